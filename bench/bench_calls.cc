@@ -0,0 +1,202 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Call heavy workloads on `CallStack` frames against frames that map names to
+// values and are allocated per call, the way a tree walking interpreter
+// without slot resolution would run them. Hardware counters per call follow
+// every row where the kernel provides them.
+//
+//   build/bench/bench_calls [fib_n] [tail_n]
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "runtime/call_stack.h"
+#include "runtime/perf_counters.h"
+#include "runtime/stats.h"
+
+namespace {
+
+using elsh::runtime::CallStack;
+using elsh::runtime::FrameLayout;
+using elsh::runtime::PerfCounters;
+using elsh::runtime::PerfValues;
+using elsh::runtime::Slot;
+
+constexpr int kReturnToHost = -1;
+
+using NamedFrame = std::unordered_map<std::string, int64_t>;
+
+int64_t NamedFib(const int64_t n) {
+  std::unique_ptr<NamedFrame> frame(new NamedFrame);
+  (*frame)["n"] = n;
+  if ((*frame)["n"] < 2) {
+    return (*frame)["n"];
+  }
+  (*frame)["a"] = NamedFib((*frame)["n"] - 1);
+  return (*frame)["a"] + NamedFib((*frame)["n"] - 2);
+}
+
+int64_t SlotFib(CallStack* const stack, const FrameLayout& layout,
+                const int64_t n) {
+  stack->PrepareArgs(1)[0].i = n;
+  Slot* frame = stack->Call(layout, kReturnToHost);
+  int pc = 0;
+  int64_t value = 0;
+  for (;;) {
+    switch (pc) {
+      case 0:
+        if (frame[0].i < 2) {
+          value = frame[0].i;
+          break;
+        }
+        stack->PrepareArgs(1)[0].i = frame[0].i - 1;
+        frame = stack->Call(layout, 1);
+        continue;
+      case 1:
+        frame[1].i = value;
+        stack->PrepareArgs(1)[0].i = frame[0].i - 2;
+        frame = stack->Call(layout, 2);
+        pc = 0;
+        continue;
+      case 2:
+        value += frame[1].i;
+        break;
+    }
+    pc = stack->Return();
+    if (pc == kReturnToHost) {
+      return value;
+    }
+    frame = stack->locals();
+  }
+}
+
+int64_t NativeFib(const int64_t n) {
+  return n < 2 ? n : NativeFib(n - 1) + NativeFib(n - 2);
+}
+
+// sum(n, acc) calling itself in tail position, with and without frame reuse.
+int64_t SlotTailSum(CallStack* const stack, const FrameLayout& layout,
+                    const int64_t n, const bool reuse_frames) {
+  Slot* args = stack->PrepareArgs(2);
+  args[0].i = n;
+  args[1].i = 0;
+  Slot* frame = stack->Call(layout, kReturnToHost);
+  while (frame[0].i != 0) {
+    args = stack->PrepareArgs(2);
+    args[0].i = frame[0].i - 1;
+    args[1].i = frame[1].i + frame[0].i;
+    frame = reuse_frames ? stack->TailCall(layout) : stack->Call(layout, 0);
+  }
+  const int64_t result = frame[1].i;
+  while (stack->Return() != kReturnToHost) {
+  }
+  return result;
+}
+
+struct Result {
+  double seconds;
+  uint64_t allocations;
+  int64_t value;
+  PerfValues perf;
+};
+
+template <typename Func>
+Result Measure(const PerfCounters& counters, const Func& func) {
+  const uint64_t allocations = elsh::runtime::AllocationCount();
+  const PerfValues perf = counters.Read();
+  const auto start = std::chrono::steady_clock::now();
+  const int64_t value = func();
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  return {seconds, elsh::runtime::AllocationCount() - allocations, value,
+          counters.Read() - perf};
+}
+
+void Row(const std::string& name, const Result& result, const double calls,
+         const PerfCounters& counters) {
+  std::cout << std::setw(20) << name << std::setw(12) << std::fixed
+            << std::setprecision(2) << result.seconds * 1e9 / calls
+            << std::setw(14) << result.allocations << std::setw(18)
+            << result.value << "\n";
+  if (counters.available()) {
+    counters.Report(result.perf, static_cast<uint64_t>(calls), "call",
+                    &std::cout);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int64_t fib_n = argc > 1 ? std::atoll(argv[1]) : 27;
+  const int64_t tail_n = argc > 2 ? std::atoll(argv[2]) : 10000000;
+
+  FrameLayout fib_layout({"n"});
+  fib_layout.Declare("a");
+  FrameLayout sum_layout({"n", "acc"});
+  CallStack fib_stack;
+  CallStack tail_stack(2 * tail_n + 16, tail_n + 1);
+
+  // fib(n) makes 2 * fib(n + 1) - 1 calls.
+  double fib_calls = 1;
+  for (int64_t a = 0, b = 1, i = 0; i <= fib_n; ++i) {
+    const int64_t next = a + b;
+    a = b;
+    b = next;
+    fib_calls = 2. * a - 1;
+  }
+
+  const PerfCounters counters;
+  if (!counters.available()) {
+    std::cout << "perf counters unavailable (" << counters.error() << ")\n";
+  }
+  std::cout << std::setw(20) << "workload" << std::setw(12) << "ns/call"
+            << std::setw(14) << "allocations" << std::setw(18) << "result"
+            << "\n";
+  Row("fib native", Measure(counters, [&]() { return NativeFib(fib_n); }),
+      fib_calls, counters);
+  Row("fib slot frames", Measure(counters, [&]() {
+        return SlotFib(&fib_stack, fib_layout, fib_n);
+      }),
+      fib_calls, counters);
+  Row("fib named frames",
+      Measure(counters, [&]() { return NamedFib(fib_n); }), fib_calls,
+      counters);
+  for (const bool reuse_frames : {true, false}) {
+    Row(reuse_frames ? "tail sum reused" : "tail sum pushed",
+        Measure(counters,
+                [&]() {
+                  return SlotTailSum(&tail_stack, sum_layout, tail_n,
+                                     reuse_frames);
+                }),
+        tail_n, counters);
+    std::cout << std::setw(20) << "" << "max depth "
+              << tail_stack.max_depth_reached() << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,133 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Lines per second over a large log file with `InputFile`, mapped and
+// buffered, against a `std::getline` loop. The file is generated unless one
+// is given, and read once before timing so that all runs see a warm page
+// cache.
+//
+//   build/bench/bench_input_file [size_mb] [file]
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "runtime/input_file.h"
+
+namespace {
+
+using elsh::runtime::InputFile;
+
+struct Count {
+  uint64_t lines = 0;
+  uint64_t bytes = 0;
+};
+
+bool WriteLog(const std::string& path, const uint64_t size) {
+  std::ofstream out(path, std::ios::binary);
+  std::string line;
+  uint64_t written = 0;
+  for (uint64_t i = 0; written < size; ++i) {
+    line = "2024-05-01T12:" + std::to_string(10 + i % 50) + ":" +
+           std::to_string(10 + i % 49) + " host-" + std::to_string(i % 97) +
+           " GET /api/v1/items/" + std::to_string(i) + " 200 " +
+           std::to_string(i % 9973) + "ms\n";
+    out << line;
+    written += line.size();
+  }
+  return static_cast<bool>(out);
+}
+
+Count ReadInputFile(const std::string& path, const size_t map_threshold) {
+  std::string error;
+  const auto input = InputFile::Open(path, &error, map_threshold);
+  Count count;
+  InputFile::View line;
+  while (input != nullptr && input->NextLine(&line)) {
+    ++count.lines;
+    count.bytes += line.size;
+  }
+  return count;
+}
+
+Count ReadGetline(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  Count count;
+  std::string line;
+  while (std::getline(in, line)) {
+    ++count.lines;
+    count.bytes += line.size();
+  }
+  return count;
+}
+
+void Row(const char* const name, const std::function<Count()>& read) {
+  const auto start = std::chrono::steady_clock::now();
+  const Count count = read();
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  std::cout << std::setw(20) << name << std::setw(14) << count.lines
+            << std::setw(14) << std::fixed << std::setprecision(2)
+            << count.lines / seconds / 1e6 << std::setw(12)
+            << (count.bytes + count.lines) / seconds / (1 << 20) << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const uint64_t size_mb = argc > 1 ? std::atoll(argv[1]) : 2048;
+  std::string path = argc > 2 ? argv[2] : "";
+  const bool generated = path.empty();
+  if (generated) {
+    path = "/tmp/elsh_bench_input.log";
+    if (!WriteLog(path, size_mb << 20)) {
+      std::cerr << "can not write " << path << "\n";
+      unlink(path.c_str());
+      return -1;
+    }
+  }
+  ReadInputFile(path, 0);
+
+  std::cout << std::setw(20) << "reader" << std::setw(14) << "lines"
+            << std::setw(14) << "Mlines/s" << std::setw(12) << "MiB/s"
+            << "\n";
+  Row("InputFile mapped", [&]() {
+    return ReadInputFile(path, std::numeric_limits<size_t>::max());
+  });
+  Row("InputFile buffered", [&]() { return ReadInputFile(path, 0); });
+  Row("std::getline", [&]() { return ReadGetline(path); });
+
+  if (generated) {
+    unlink(path.c_str());
+  }
+  return 0;
+}
@@ -0,0 +1,114 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Size and decode cost of the line table against fixed-width positions, for
+// the tokens of a source file.
+//
+//   build/bench/bench_line_table <file>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lex/line_table.h"
+#include "lex/token_loader.h"
+
+namespace {
+
+using elsh::lex::LineTable;
+using elsh::lex::LineTableBuilder;
+
+double NanosPer(const std::chrono::steady_clock::time_point start,
+                const size_t count) {
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         count;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <file>\n";
+    return -1;
+  }
+  std::ifstream fs(argv[1], std::ios::binary);
+  elsh::lex::TokenLoader loader(&fs);
+  const auto tokens = loader.GetAllTokens();
+
+  LineTableBuilder builder;
+  for (const auto& token : tokens) {
+    builder.Add(token.err_ln, token.err_col);
+  }
+  const LineTable table(builder.bytes().data(), builder.bytes().size(),
+                        builder.checkpoints().data(), builder.size());
+  const size_t fixed_bytes = tokens.size() * 2 * sizeof(int32_t);
+  const size_t table_bytes =
+      builder.bytes().size() +
+      builder.checkpoints().size() * sizeof(elsh::lex::line_table::Checkpoint);
+  // Token records are 8 bytes.
+  const size_t code_bytes = tokens.size() * 8;
+
+  std::cout << std::fixed << std::setprecision(2) << tokens.size()
+            << " tokens\n"
+            << std::setw(24) << "" << std::setw(14) << "fixed" << std::setw(14)
+            << "line table" << "\n"
+            << std::setw(24) << "position bytes" << std::setw(14)
+            << fixed_bytes << std::setw(14) << table_bytes << "\n"
+            << std::setw(24) << "bytes per token" << std::setw(14)
+            << static_cast<double>(fixed_bytes) / tokens.size()
+            << std::setw(14) << static_cast<double>(table_bytes) / tokens.size()
+            << "\n"
+            << std::setw(24) << "code + positions bytes" << std::setw(14)
+            << code_bytes + fixed_bytes << std::setw(14)
+            << code_bytes + table_bytes << "\n";
+
+  int32_t line;
+  int32_t col;
+  int64_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  LineTable::Cursor cursor(table, 0);
+  while (cursor.Next(&line, &col)) {
+    checksum += line + col;
+  }
+  std::cout << std::setw(24) << "sequential ns/entry" << std::setw(28)
+            << NanosPer(start, tokens.size()) << "\n";
+
+  std::mt19937 rng(42);
+  std::vector<size_t> indexes(100000);
+  for (auto& index : indexes) {
+    index = rng() % tokens.size();
+  }
+  start = std::chrono::steady_clock::now();
+  for (const size_t index : indexes) {
+    table.Lookup(index, &line, &col);
+    checksum += line;
+  }
+  std::cout << std::setw(24) << "random lookup ns" << std::setw(28)
+            << NanosPer(start, indexes.size()) << "\n";
+  return checksum == 0 ? 1 : 0;
+}
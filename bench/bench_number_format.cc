@@ -0,0 +1,140 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Cost of formatting one double with `FormatDouble` against the iostream
+// path the lexer printed through before, and against a single `%.17g`, per
+// class of value:
+//
+//   integral  whole numbers, which skip the digit generation
+//   short     a few decimals
+//   random    full precision, mostly 16 or 17 digits
+//
+//   build/bench/bench_number_format [values] [repeats]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "runtime/number_format.h"
+
+namespace {
+
+using elsh::runtime::FormatDouble;
+using elsh::runtime::kMaxDoubleChars;
+
+// Keeps the compiler from dropping the formatting.
+volatile char g_sink = 0;
+
+double NanosPerValue(const std::function<void()>& func, const size_t values,
+                     const int repeats) {
+  func();  // warm up
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeats; ++i) {
+    func();
+  }
+  const double nanos = std::chrono::duration<double, std::nano>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  return nanos / repeats / values;
+}
+
+void Row(const std::string& name, const std::vector<double>& values,
+         const int repeats) {
+  char out[kMaxDoubleChars];
+  const double format_ns = NanosPerValue(
+      [&]() {
+        for (const double value : values) {
+          g_sink = out[FormatDouble(value, out) - 1];
+        }
+      },
+      values.size(), repeats);
+  const double printf_ns = NanosPerValue(
+      [&]() {
+        for (const double value : values) {
+          g_sink = out[std::snprintf(out, sizeof(out), "%.17g", value) - 1];
+        }
+      },
+      values.size(), repeats);
+  // One stream rewound per value, as `std::cout << value` without the
+  // locking of the shared stream.
+  std::ostringstream os;
+  const double ostream_ns = NanosPerValue(
+      [&]() {
+        for (const double value : values) {
+          os.seekp(0);
+          os << value;
+        }
+        g_sink = os.str()[0];
+      },
+      values.size(), repeats);
+  std::ostringstream os17;
+  os17 << std::setprecision(17);
+  const double ostream17_ns = NanosPerValue(
+      [&]() {
+        for (const double value : values) {
+          os17.seekp(0);
+          os17 << value;
+        }
+        g_sink = os17.str()[0];
+      },
+      values.size(), repeats);
+  std::cout << std::setw(10) << name << std::fixed << std::setprecision(1)
+            << std::setw(14) << format_ns << std::setw(10) << printf_ns
+            << std::setw(10) << ostream_ns << std::setw(12) << ostream17_ns
+            << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t n = argc > 1 ? std::atoll(argv[1]) : 100000;
+  const int repeats = argc > 2 ? std::atoi(argv[2]) : 10;
+
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<int64_t> ints(-1000000, 1000000);
+  std::uniform_real_distribution<double> reals(-1e6, 1e6);
+  std::vector<double> integral(n);
+  std::vector<double> short_decimals(n);
+  std::vector<double> random(n);
+  for (size_t i = 0; i < n; ++i) {
+    integral[i] = static_cast<double>(ints(rng));
+    short_decimals[i] = static_cast<double>(ints(rng)) / 100;
+    random[i] = reals(rng);
+  }
+
+  std::cout << "ns per value, " << n << " values\n"
+            << std::setw(10) << "values" << std::setw(14) << "FormatDouble"
+            << std::setw(10) << "%.17g" << std::setw(10) << "ostream"
+            << std::setw(12) << "ostream 17" << "\n";
+  Row("integral", integral, repeats);
+  Row("short", short_decimals, repeats);
+  Row("random", random, repeats);
+  return 0;
+}
@@ -0,0 +1,144 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Sequential loops against `ThreadPool` loops with 1..N threads: a reduction
+// with uneven iteration cost and an ordered print loop.
+//
+//   build/bench/bench_parallel_for [max_threads] [iterations]
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "runtime/number_format.h"
+#include "runtime/output_buffer.h"
+#include "runtime/thread_pool.h"
+
+namespace {
+
+using elsh::runtime::OutputBuffer;
+using elsh::runtime::ThreadPool;
+
+// Later iterations cost more, which is what stealing has to even out.
+double Iteration(const int64_t i) {
+  double value = 0.;
+  for (int64_t k = 0; k < 16 + i % 64; ++k) {
+    value += std::sqrt(static_cast<double>(i + k));
+  }
+  return value;
+}
+
+template <typename Func>
+double Seconds(const Func& func) {
+  const auto start = std::chrono::steady_clock::now();
+  func();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+void PrintRow(const std::string& name, const double seconds,
+              const double baseline) {
+  std::cout << std::setw(16) << name << std::setw(12) << std::fixed
+            << std::setprecision(2) << seconds * 1000 << std::setw(9)
+            << baseline / seconds << "x\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int max_threads =
+      argc > 1 ? std::atoi(argv[1])
+               : std::max(4, static_cast<int>(
+                                 std::thread::hardware_concurrency()));
+  const int64_t iterations = argc > 2 ? std::atoll(argv[2]) : 2000000;
+  const int dev_null = open("/dev/null", O_WRONLY);
+
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency()
+            << ", iterations: " << iterations << "\n";
+
+  std::cout << "\nreduction\n"
+            << std::setw(16) << "loop" << std::setw(12) << "ms"
+            << std::setw(10) << "speedup" << "\n";
+  volatile double sink = 0.;
+  const double sequential = Seconds([&]() {
+    double sum = 0.;
+    for (int64_t i = 0; i < iterations; ++i) {
+      sum += Iteration(i);
+    }
+    sink = sum;
+  });
+  PrintRow("sequential", sequential, sequential);
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    ThreadPool pool(threads - 1);
+    const double seconds = Seconds([&]() {
+      sink = pool.ParallelReduce(
+          0, iterations, 0.,
+          [](const int64_t begin, const int64_t end) {
+            double sum = 0.;
+            for (int64_t i = begin; i < end; ++i) {
+              sum += Iteration(i);
+            }
+            return sum;
+          },
+          [](double a, double b) { return a + b; });
+    });
+    PrintRow("parallel x" + std::to_string(threads), seconds, sequential);
+  }
+
+  std::cout << "\nordered print\n"
+            << std::setw(16) << "loop" << std::setw(12) << "ms"
+            << std::setw(10) << "speedup" << "\n";
+  const double sequential_print = Seconds([&]() {
+    OutputBuffer out(dev_null);
+    for (int64_t i = 0; i < iterations; ++i) {
+      out.PrintDouble(Iteration(i));
+      out.PutChar('\n');
+    }
+  });
+  PrintRow("sequential", sequential_print, sequential_print);
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    ThreadPool pool(threads - 1);
+    const double seconds = Seconds([&]() {
+      OutputBuffer out(dev_null);
+      pool.ParallelForOrdered(
+          0, iterations,
+          [](const int64_t i, std::string* const output) {
+            char str[elsh::runtime::kMaxDoubleChars];
+            output->append(str, elsh::runtime::FormatDouble(Iteration(i), str));
+            output->push_back('\n');
+          },
+          &out);
+    });
+    PrintRow("parallel x" + std::to_string(threads), seconds,
+             sequential_print);
+  }
+  close(dev_null);
+  return 0;
+}
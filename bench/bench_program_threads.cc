@@ -0,0 +1,112 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Throughput of one shared `Program` run concurrently by 1..N threads, each
+// thread with its own `Context`.
+//
+//   build/bench/bench_program_threads [max_threads] [runs_per_thread]
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "runtime/program.h"
+
+namespace {
+
+constexpr char kScript[] = R"(
+int a = 1;
+int b = limit;
+if ( a != b ) {
+  print("Not equal");
+} else {
+  print("Equal");
+}
+do {
+  a += 1;
+} while ( a < b );
+for(int i = 0; i < limit; i += 1) {
+  print(i);
+}
+string str = name;
+)";
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int max_threads =
+      argc > 1 ? std::atoi(argv[1])
+               : std::max(4, static_cast<int>(
+                                 std::thread::hardware_concurrency()));
+  const int runs_per_thread = argc > 2 ? std::atoi(argv[2]) : 20000;
+
+  std::string error;
+  const auto program = elsh::runtime::Program::Compile(kScript, &error);
+  if (!program) {
+    std::cerr << error << "\n";
+    return -1;
+  }
+  const int dev_null = open("/dev/null", O_WRONLY);
+
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency()
+            << ", tokens per run: " << program->tokens().size() << "\n"
+            << std::setw(8) << "threads" << std::setw(14) << "runs/s"
+            << std::setw(10) << "speedup" << "\n";
+  double single_thread_rate = 0.;
+  for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&program, dev_null, runs_per_thread, t]() {
+        elsh::runtime::Context context(program, dev_null);
+        for (int run = 0; run < runs_per_thread; ++run) {
+          context.SetInput("limit", static_cast<int64_t>(run + t));
+          context.SetInput("name", std::string("worker"));
+          context.Run();
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    const double rate = num_threads * runs_per_thread / seconds;
+    if (num_threads == 1) {
+      single_thread_rate = rate;
+    }
+    std::cout << std::setw(8) << num_threads << std::setw(14) << std::fixed
+              << std::setprecision(0) << rate << std::setw(9)
+              << std::setprecision(2) << rate / single_thread_rate << "x\n";
+  }
+  close(dev_null);
+  return 0;
+}
@@ -0,0 +1,100 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Latency of one more REPL line as the session grows, for `Session` and for
+// recompiling the whole session text on every line.
+//
+//   build/bench/bench_repl [max_definitions]
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "runtime/program.h"
+#include "runtime/session.h"
+
+namespace {
+
+std::string Definition(const int i) {
+  return "v" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int max_definitions = argc > 1 ? std::atoi(argv[1]) : 100000;
+  constexpr int kSampleLines = 100;
+
+  const int dev_null = open("/dev/null", O_WRONLY);
+  elsh::runtime::Session session(dev_null);
+  std::string history;
+  std::string error;
+  int defined = 0;
+
+  std::cout << std::setw(12) << "definitions" << std::setw(16)
+            << "session us/line" << std::setw(18) << "recompile us/line"
+            << "\n";
+  for (int size = 1000; size <= max_definitions; size *= 10) {
+    for (; defined < size; ++defined) {
+      const std::string line = Definition(defined);
+      session.Eval(line, &error);
+      history += line;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kSampleLines; ++i) {
+      session.Eval("print(v" + std::to_string(i) + ");\n", &error);
+    }
+    const double session_us =
+        std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start)
+            .count() /
+        kSampleLines;
+
+    // What a REPL without incremental compilation does: compile everything
+    // typed so far, then run it.
+    const int recompile_lines = 5;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < recompile_lines; ++i) {
+      const auto program = elsh::runtime::Program::Compile(
+          history + "print(v" + std::to_string(i) + ");\n", &error);
+      elsh::runtime::Context context(program, dev_null);
+      context.Run();
+    }
+    const double recompile_us =
+        std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start)
+            .count() /
+        recompile_lines;
+
+    std::cout << std::setw(12) << size << std::setw(16) << std::fixed
+              << std::setprecision(2) << session_us << std::setw(18)
+              << std::setprecision(0) << recompile_us << "\n";
+  }
+  close(dev_null);
+  return 0;
+}
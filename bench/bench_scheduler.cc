@@ -0,0 +1,168 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Cost of fuel metering in `Context`, and how much a runaway script delays
+// short scripts sharing a `Scheduler` with it.
+//
+//   build/bench/bench_scheduler [runs] [workers]
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "runtime/program.h"
+#include "runtime/scheduler.h"
+
+namespace {
+
+using elsh::runtime::Context;
+using elsh::runtime::Scheduler;
+
+constexpr char kScript[] = R"(
+int a = 1;
+int b = limit;
+if ( a != b ) {
+  print("Not equal");
+} else {
+  print("Equal");
+}
+do {
+  a += 1;
+} while ( a < b );
+for(int i = 0; i < limit; i += 1) {
+  print(i);
+}
+)";
+
+template <typename Func>
+double Seconds(const Func& func) {
+  const auto start = std::chrono::steady_clock::now();
+  func();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// Best of five, against noise from the rest of the machine.
+template <typename Func>
+double BestSeconds(const Func& func) {
+  double best = std::numeric_limits<double>::max();
+  for (int i = 0; i < 5; ++i) {
+    best = std::min(best, Seconds(func));
+  }
+  return best;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int runs = argc > 1 ? std::atoi(argv[1]) : 20000;
+  const int workers = argc > 2 ? std::atoi(argv[2]) : 2;
+
+  std::string error;
+  const auto program = elsh::runtime::Program::Compile(kScript, &error);
+  if (!program) {
+    std::cerr << error << "\n";
+    return -1;
+  }
+  const int dev_null = open("/dev/null", O_WRONLY);
+  const double steps = static_cast<double>(runs) * program->tokens().size();
+
+  Context context(program, dev_null);
+  context.SetInput("limit", int64_t{10});
+  const double unmetered = BestSeconds([&]() {
+    for (int run = 0; run < runs; ++run) {
+      context.Run();
+    }
+  });
+  std::cout << std::setw(22) << "mode" << std::setw(10) << "ns/step"
+            << std::setw(10) << "overhead" << "\n"
+            << std::setw(22) << "unmetered" << std::setw(10) << std::fixed
+            << std::setprecision(2) << unmetered * 1e9 / steps << "\n";
+  for (const int64_t slice_fuel :
+       {std::numeric_limits<int64_t>::max(), int64_t{1000}, int64_t{64}}) {
+    const double metered = BestSeconds([&]() {
+      for (int run = 0; run < runs; ++run) {
+        Context::RunState state = Context::RunState::kPreempted;
+        while (state == Context::RunState::kPreempted) {
+          int64_t fuel = slice_fuel;
+          state = context.Resume(&fuel);
+        }
+      }
+    });
+    const std::string name =
+        slice_fuel == std::numeric_limits<int64_t>::max()
+            ? "metered, one slice"
+            : "metered, " + std::to_string(slice_fuel) + " fuel";
+    std::cout << std::setw(22) << name << std::setw(10) << std::setprecision(2)
+              << metered * 1e9 / steps << std::setw(9) << std::setprecision(1)
+              << (metered / unmetered - 1.) * 100. << "%\n";
+  }
+
+  // Short scripts alone, then queued behind a script that never finishes
+  // on its own.
+  Scheduler::Limits limits;
+  limits.slice_fuel = 1000;
+  Scheduler::Limits runaway_limits = limits;
+  runaway_limits.max_fuel = 50 * steps;
+  std::cout << "\n"
+            << runs << " scripts on " << workers << " workers\n"
+            << std::setw(22) << "" << std::setw(10) << "ms" << "\n";
+  for (const bool with_runaway : {false, true}) {
+    Scheduler scheduler(workers);
+    if (with_runaway) {
+      scheduler.Submit(
+          [](int64_t* const fuel) {
+            *fuel = 0;
+            return Context::RunState::kPreempted;
+          },
+          runaway_limits);
+    }
+    const double seconds = Seconds([&]() {
+      for (int run = 0; run < runs; ++run) {
+        auto script = std::make_shared<Context>(program, dev_null);
+        script->SetInput("limit", int64_t{10});
+        scheduler.Submit(script, limits);
+      }
+      // With the runaway, wait until the short scripts are through.
+      while (scheduler.finish_order().size() < static_cast<size_t>(runs)) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+      }
+    });
+    std::cout << std::setw(22) << (with_runaway ? "with runaway" : "alone")
+              << std::setw(10) << std::setprecision(1) << seconds * 1e3
+              << "\n";
+    scheduler.Wait();
+  }
+  close(dev_null);
+  return 0;
+}
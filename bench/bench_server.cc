@@ -0,0 +1,155 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Request latency of the fork server against cold launches of the lexer, for
+// a script of a few thousand tokens. "shim" spawns `lexer --connect` the way
+// a user would, "in-process" sends the request directly and shows what the
+// server itself adds.
+//
+//   build/bench/bench_server [lexer] [script] [runs]
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "runtime/fork_server.h"
+
+extern char** environ;
+
+namespace {
+
+pid_t Spawn(std::vector<std::string> args, const int out_fd) {
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT_FILENO);
+  std::vector<char*> argv;
+  for (auto& arg : args) {
+    argv.push_back(&arg[0]);
+  }
+  argv.push_back(nullptr);
+  pid_t pid;
+  const int spawned = posix_spawn(&pid, argv[0], &actions, nullptr,
+                                  argv.data(), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  return spawned == 0 ? pid : -1;
+}
+
+bool SpawnAndWait(const std::vector<std::string>& args, const int out_fd) {
+  const pid_t pid = Spawn(args, out_fd);
+  int status;
+  return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+         WEXITSTATUS(status) == 0;
+}
+
+double Percentile(std::vector<double> values, const double fraction) {
+  std::sort(values.begin(), values.end());
+  return values[static_cast<size_t>(fraction * (values.size() - 1))];
+}
+
+bool Row(const char* const name, const int runs,
+         const std::function<bool()>& request) {
+  std::vector<double> latencies;
+  for (int i = 0; i < runs; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    if (!request()) {
+      std::cerr << name << " failed\n";
+      return false;
+    }
+    latencies.push_back(std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+  }
+  std::cout << std::setw(14) << name << std::setw(12) << std::fixed
+            << std::setprecision(1) << Percentile(latencies, 0.5)
+            << std::setw(12) << Percentile(latencies, 0.99) << "\n";
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::string lexer = argc > 1 ? argv[1] : "build/lexer";
+  std::string script = argc > 2 ? argv[2] : "";
+  const int runs = argc > 3 ? std::atoi(argv[3]) : 500;
+
+  const bool generated = script.empty();
+  if (generated) {
+    script = "/tmp/elsh_bench_server.sh";
+    std::ofstream out(script);
+    for (int i = 0; i < 500; ++i) {
+      out << "int v" << i << " = " << i << "; print(v" << i << ");\n";
+    }
+  }
+  const std::string socket_path =
+      "/tmp/elsh_bench_server." + std::to_string(getpid()) + ".sock";
+  const int dev_null = open("/dev/null", O_WRONLY);
+
+  const pid_t server =
+      Spawn({lexer, "--server", socket_path, script}, dev_null);
+  // Wait until the server accepts requests.
+  int status = -1;
+  for (int i = 0; i < 500 && !elsh::runtime::SendForkRequest(
+                                 socket_path, script, dev_null, dev_null,
+                                 &status);
+       ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  bool ok = status == 0;
+  std::cout << std::setw(14) << "" << std::setw(12) << "p50 us"
+            << std::setw(12) << "p99 us" << "\n";
+  ok = ok && Row("cold launch", runs, [&]() {
+         return SpawnAndWait({lexer, script}, dev_null);
+       });
+  ok = ok && Row("shim", runs, [&]() {
+         return SpawnAndWait({lexer, "--connect", socket_path, script},
+                             dev_null);
+       });
+  ok = ok && Row("in-process", runs, [&]() {
+         return elsh::runtime::SendForkRequest(socket_path, script, dev_null,
+                                               dev_null, &status) &&
+                status == 0;
+       });
+
+  if (server > 0) {
+    kill(server, SIGTERM);
+    waitpid(server, nullptr, 0);
+  }
+  unlink(socket_path.c_str());
+  if (generated) {
+    unlink(script.c_str());
+  }
+  return ok ? 0 : -1;
+}
@@ -0,0 +1,132 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Latency from spawning the lexer to its exit, over a one statement script.
+// This is what every short-lived invocation pays before doing any work. The
+// lexer writes a pipe only when its output buffer is flushed at exit, so the
+// first token arrives with the exit and exit latency is what is measured.
+//
+//   build/bench/bench_startup [lexer] [runs]
+
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+extern char** environ;
+
+namespace {
+
+bool RunOnce(const std::string& lexer, const std::string& script,
+             double* const exit_us) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return false;
+  }
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+  posix_spawn_file_actions_addclose(&actions, fds[0]);
+  posix_spawn_file_actions_addclose(&actions, fds[1]);
+  char* argv[] = {const_cast<char*>(lexer.c_str()),
+                  const_cast<char*>(script.c_str()), nullptr};
+
+  const auto start = std::chrono::steady_clock::now();
+  pid_t pid;
+  const int spawned =
+      posix_spawn(&pid, lexer.c_str(), &actions, nullptr, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(fds[1]);
+  if (spawned != 0) {
+    close(fds[0]);
+    return false;
+  }
+
+  bool got_output = false;
+  char output[4096];
+  while (read(fds[0], output, sizeof(output)) > 0) {
+    got_output = true;
+  }
+  close(fds[0]);
+  int status;
+  waitpid(pid, &status, 0);
+  const auto exit = std::chrono::steady_clock::now();
+
+  *exit_us = std::chrono::duration<double, std::micro>(exit - start).count();
+  return got_output && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+double Percentile(std::vector<double> values, const double fraction) {
+  std::sort(values.begin(), values.end());
+  return values[static_cast<size_t>(fraction * (values.size() - 1))];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::string lexer = argc > 1 ? argv[1] : "build/lexer";
+  const int runs = argc > 2 ? std::atoi(argv[2]) : 200;
+  if (runs <= 0) {
+    std::cerr << "runs must be positive\n";
+    return -1;
+  }
+
+  char script[] = "/tmp/elsh_startup_XXXXXX";
+  const int fd = mkstemp(script);
+  if (fd < 0) {
+    std::cerr << "can not create a script\n";
+    return -1;
+  }
+  close(fd);
+  std::ofstream(script) << "print(1);\n";
+
+  std::vector<double> exit;
+  for (int i = 0; i < runs; ++i) {
+    double exit_us;
+    if (!RunOnce(lexer, script, &exit_us)) {
+      std::cerr << "can not run " << lexer << "\n";
+      unlink(script);
+      return -1;
+    }
+    exit.push_back(exit_us);
+  }
+  unlink(script);
+
+  std::cout << std::fixed << std::setprecision(1) << runs << " runs of "
+            << lexer << "\n"
+            << std::setw(16) << "" << std::setw(12) << "p10 us"
+            << std::setw(12) << "median us" << std::setw(12) << "p90 us"
+            << "\n";
+  std::cout << std::setw(16) << "exit" << std::setw(12)
+            << Percentile(exit, 0.1) << std::setw(12) << Percentile(exit, 0.5)
+            << std::setw(12) << Percentile(exit, 0.9) << "\n";
+  return 0;
+}
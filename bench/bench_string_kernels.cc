@@ -0,0 +1,220 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// String builtins per kernel set against a naive byte loop and
+// std::string::find. The std::string split copies its fields into strings,
+// the way a split written with std::string::find and substr would.
+//
+//   build/bench/bench_string_kernels [bytes] [repeats]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "runtime/string_kernels.h"
+
+namespace {
+
+using elsh::runtime::KernelSet;
+using elsh::runtime::StringKernels;
+using elsh::runtime::StringSlice;
+
+const KernelSet kKernelSets[] = {KernelSet::kScalar, KernelSet::kSse2,
+                                 KernelSet::kAvx2};
+
+double BytesPerNano(const std::function<void()>& func, const size_t bytes,
+                    const int repeats) {
+  func();  // warm up
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeats; ++i) {
+    func();
+  }
+  const double nanos = std::chrono::duration<double, std::nano>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  return bytes * static_cast<double>(repeats) / nanos;
+}
+
+void Row(const std::string& name, const std::function<void()>& naive,
+         const std::function<void()>& std_string,
+         const std::function<void(const StringKernels&)>& kernel,
+         const size_t bytes, const int repeats) {
+  const double naive_gbs = BytesPerNano(naive, bytes, repeats);
+  std::cout << std::setw(14) << name << std::fixed << std::setprecision(2)
+            << std::setw(8) << naive_gbs << std::setw(8)
+            << BytesPerNano(std_string, bytes, repeats);
+  for (const KernelSet kernel_set : kKernelSets) {
+    if (!elsh::runtime::IsSupported(kernel_set)) {
+      std::cout << std::setw(16) << "n/a";
+      continue;
+    }
+    const StringKernels& kernels = elsh::runtime::GetStringKernels(kernel_set);
+    const double kernel_gbs =
+        BytesPerNano([&]() { kernel(kernels); }, bytes, repeats);
+    std::cout << std::setw(8) << std::setprecision(2) << kernel_gbs
+              << std::setw(7) << std::setprecision(1) << kernel_gbs / naive_gbs
+              << "x";
+  }
+  std::cout << "\n";
+}
+
+size_t NaiveFind(const std::string& str, const std::string& needle) {
+  for (size_t i = 0; i + needle.size() <= str.size(); ++i) {
+    size_t j = 0;
+    while (j < needle.size() && str[i + j] == needle[j]) {
+      ++j;
+    }
+    if (j == needle.size()) {
+      return i;
+    }
+  }
+  return elsh::runtime::kNotFound;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t n = argc > 1 ? std::atoll(argv[1]) : 1 << 20;
+  const int repeats = argc > 2 ? std::atoi(argv[2]) : 50;
+
+  // Lower case words of 1 to 12 letters, the needles only at the very end.
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> letter('a', 'z');
+  std::uniform_int_distribution<int> word_size(1, 12);
+  std::string text;
+  while (text.size() < n) {
+    for (int i = word_size(rng); i > 0; --i) {
+      text += static_cast<char>(letter(rng));
+    }
+    text += ' ';
+  }
+  const std::string short_needle = "Elsh";
+  const std::string long_needle = "the Elsh language";
+  text += "#" + long_needle;
+  // Comma separated fields for split.
+  std::string csv = text;
+  std::replace(csv.begin(), csv.end(), ' ', ',');
+
+  volatile size_t sink = 0;
+  std::vector<StringSlice> fields;
+  std::vector<std::string> copies;
+
+  std::cout << "GB/s, " << text.size() << " bytes, detected: "
+            << KernelSetName(elsh::runtime::DetectKernelSet()) << "\n"
+            << std::setw(14) << "op" << std::setw(8) << "naive" << std::setw(8)
+            << "std";
+  for (const KernelSet kernel_set : kKernelSets) {
+    std::cout << std::setw(8) << KernelSetName(kernel_set) << std::setw(8)
+              << "speedup";
+  }
+  std::cout << "\n";
+
+  Row("find byte",
+      [&]() {
+        size_t i = 0;
+        while (i < text.size() && text[i] != '#') {
+          ++i;
+        }
+        sink = i;
+      },
+      [&]() { sink = text.find('#'); },
+      [&](const StringKernels& k) {
+        sink = k.find_byte(text.data(), text.size(), '#');
+      },
+      text.size(), repeats);
+  Row("count byte",
+      [&]() {
+        size_t count = 0;
+        for (const char c : text) {
+          count += c == ' ';
+        }
+        sink = count;
+      },
+      [&]() {
+        size_t count = 0;
+        for (size_t i = text.find(' '); i != std::string::npos;
+             i = text.find(' ', i + 1)) {
+          ++count;
+        }
+        sink = count;
+      },
+      [&](const StringKernels& k) {
+        sink = k.count_byte(text.data(), text.size(), ' ');
+      },
+      text.size(), repeats);
+  for (const std::string* const needle : {&short_needle, &long_needle}) {
+    Row("find " + std::to_string(needle->size()) + " bytes",
+        [&]() { sink = NaiveFind(text, *needle); },
+        [&]() { sink = text.find(*needle); },
+        [&](const StringKernels& k) {
+          sink = k.find(text.data(), text.size(), needle->data(),
+                        needle->size());
+        },
+        text.size(), repeats);
+  }
+  Row("split ','",
+      [&]() {
+        fields.clear();
+        size_t start = 0;
+        for (size_t i = 0; i < csv.size(); ++i) {
+          if (csv[i] == ',') {
+            fields.emplace_back(csv.data() + start, i - start);
+            start = i + 1;
+          }
+        }
+        fields.emplace_back(csv.data() + start, csv.size() - start);
+        sink = fields.size();
+      },
+      [&]() {
+        copies.clear();
+        size_t start = 0;
+        for (size_t i = csv.find(','); i != std::string::npos;
+             i = csv.find(',', start)) {
+          copies.push_back(csv.substr(start, i - start));
+          start = i + 1;
+        }
+        copies.push_back(csv.substr(start));
+        sink = copies.size();
+      },
+      [&](const StringKernels& k) {
+        fields.clear();
+        const char* const data = csv.data();
+        size_t start = 0;
+        size_t found = 0;
+        while ((found = k.find_byte(data + start, csv.size() - start, ',')) !=
+               elsh::runtime::kNotFound) {
+          fields.emplace_back(data + start, found);
+          start += found + 1;
+        }
+        fields.emplace_back(data + start, csv.size() - start);
+        sink = fields.size();
+      },
+      csv.size(), repeats);
+  return 0;
+}
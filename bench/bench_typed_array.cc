@@ -0,0 +1,242 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Bulk array builtins per kernel set against the element by element loop a
+// script would run, with one checked access per element.
+//
+//   build/bench/bench_typed_array [elements] [repeats]
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "runtime/array_kernels.h"
+#include "runtime/typed_array.h"
+
+namespace {
+
+using elsh::runtime::ArrayKernels;
+using elsh::runtime::KernelSet;
+using elsh::runtime::TypedArray;
+
+const KernelSet kKernelSets[] = {KernelSet::kScalar, KernelSet::kSse2,
+                                 KernelSet::kAvx2};
+
+double NanosPerElement(const std::function<void()>& func,
+                       const size_t elements, const int repeats) {
+  func();  // warm up
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeats; ++i) {
+    func();
+  }
+  const double nanos = std::chrono::duration<double, std::nano>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  return nanos / repeats / elements;
+}
+
+void Row(const std::string& name, const std::function<void()>& script,
+         const std::function<void(const ArrayKernels&)>& kernel,
+         const size_t elements, const int repeats) {
+  const double script_ns = NanosPerElement(script, elements, repeats);
+  std::cout << std::setw(14) << name << std::fixed << std::setprecision(3)
+            << std::setw(10) << script_ns;
+  for (const KernelSet kernel_set : kKernelSets) {
+    if (!elsh::runtime::IsSupported(kernel_set)) {
+      std::cout << std::setw(18) << "n/a";
+      continue;
+    }
+    const ArrayKernels& kernels = elsh::runtime::GetArrayKernels(kernel_set);
+    const double kernel_ns =
+        NanosPerElement([&]() { kernel(kernels); }, elements, repeats);
+    std::cout << std::setw(10) << std::setprecision(3) << kernel_ns
+              << std::setw(7) << std::setprecision(1) << script_ns / kernel_ns
+              << "x";
+  }
+  std::cout << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t n = argc > 1 ? std::atoll(argv[1]) : 1 << 20;
+  const int repeats = argc > 2 ? std::atoi(argv[2]) : 50;
+
+  TypedArray<int32_t> a(n);
+  TypedArray<int32_t> b(n);
+  TypedArray<int32_t> out(n);
+  TypedArray<double> x(n);
+  TypedArray<double> y(n);
+  TypedArray<double> out_doubles(n);
+  for (size_t i = 0; i < n; ++i) {
+    a.Set(i, static_cast<int32_t>(i * 2654435761u));
+    b.Set(i, static_cast<int32_t>(i % 1000) - 500);
+    x.Set(i, (i % 1000) * 0.5);
+    y.Set(i, (i % 777) * 0.25);
+  }
+  volatile int64_t int_sink = 0;
+  volatile double double_sink = 0.;
+
+  std::cout << "ns per element, " << n << " elements, detected: "
+            << KernelSetName(elsh::runtime::DetectKernelSet()) << "\n"
+            << std::setw(14) << "op" << std::setw(10) << "script";
+  for (const KernelSet kernel_set : kKernelSets) {
+    std::cout << std::setw(10) << KernelSetName(kernel_set) << std::setw(8)
+              << "speedup";
+  }
+  std::cout << "\n";
+
+  Row("fill int32",
+      [&]() {
+        for (size_t i = 0; i < n; ++i) {
+          out.Set(i, 7);
+        }
+      },
+      [&](const ArrayKernels& k) { k.fill_int32(out.data(), n, 7); }, n,
+      repeats);
+  Row("sum int32",
+      [&]() {
+        int64_t sum = 0;
+        int32_t value = 0;
+        for (size_t i = 0; i < n; ++i) {
+          a.Get(i, &value);
+          sum += value;
+        }
+        int_sink = sum;
+      },
+      [&](const ArrayKernels& k) { int_sink = k.sum_int32(a.data(), n); }, n,
+      repeats);
+  Row("max int32",
+      [&]() {
+        int32_t max = a[0];
+        int32_t value = 0;
+        for (size_t i = 1; i < n; ++i) {
+          a.Get(i, &value);
+          max = value > max ? value : max;
+        }
+        int_sink = max;
+      },
+      [&](const ArrayKernels& k) { int_sink = k.max_int32(a.data(), n); }, n,
+      repeats);
+  Row("add int32",
+      [&]() {
+        int32_t lhs = 0;
+        int32_t rhs = 0;
+        for (size_t i = 0; i < n; ++i) {
+          a.Get(i, &lhs);
+          b.Get(i, &rhs);
+          out.Set(i, static_cast<int32_t>(static_cast<uint32_t>(lhs) + rhs));
+        }
+      },
+      [&](const ArrayKernels& k) {
+        k.add_int32(a.data(), b.data(), out.data(), n);
+      },
+      n, repeats);
+  Row("mul int32",
+      [&]() {
+        int32_t lhs = 0;
+        int32_t rhs = 0;
+        for (size_t i = 0; i < n; ++i) {
+          a.Get(i, &lhs);
+          b.Get(i, &rhs);
+          out.Set(i, static_cast<int32_t>(static_cast<uint32_t>(lhs) * rhs));
+        }
+      },
+      [&](const ArrayKernels& k) {
+        k.mul_int32(a.data(), b.data(), out.data(), n);
+      },
+      n, repeats);
+  Row("dot int32",
+      [&]() {
+        int64_t dot = 0;
+        int32_t lhs = 0;
+        int32_t rhs = 0;
+        for (size_t i = 0; i < n; ++i) {
+          a.Get(i, &lhs);
+          b.Get(i, &rhs);
+          dot += static_cast<int64_t>(lhs) * rhs;
+        }
+        int_sink = dot;
+      },
+      [&](const ArrayKernels& k) {
+        int_sink = k.dot_int32(a.data(), b.data(), n);
+      },
+      n, repeats);
+  Row("sum double",
+      [&]() {
+        double sum = 0.;
+        double value = 0;
+        for (size_t i = 0; i < n; ++i) {
+          x.Get(i, &value);
+          sum += value;
+        }
+        double_sink = sum;
+      },
+      [&](const ArrayKernels& k) { double_sink = k.sum_double(x.data(), n); },
+      n, repeats);
+  Row("min double",
+      [&]() {
+        double min = x[0];
+        double value = 0;
+        for (size_t i = 1; i < n; ++i) {
+          x.Get(i, &value);
+          min = value < min ? value : min;
+        }
+        double_sink = min;
+      },
+      [&](const ArrayKernels& k) { double_sink = k.min_double(x.data(), n); },
+      n, repeats);
+  Row("mul double",
+      [&]() {
+        double lhs = 0;
+        double rhs = 0;
+        for (size_t i = 0; i < n; ++i) {
+          x.Get(i, &lhs);
+          y.Get(i, &rhs);
+          out_doubles.Set(i, lhs * rhs);
+        }
+      },
+      [&](const ArrayKernels& k) {
+        k.mul_double(x.data(), y.data(), out_doubles.data(), n);
+      },
+      n, repeats);
+  Row("dot double",
+      [&]() {
+        double dot = 0.;
+        double lhs = 0;
+        double rhs = 0;
+        for (size_t i = 0; i < n; ++i) {
+          x.Get(i, &lhs);
+          y.Get(i, &rhs);
+          dot += lhs * rhs;
+        }
+        double_sink = dot;
+      },
+      [&](const ArrayKernels& k) {
+        double_sink = k.dot_double(x.data(), y.data(), n);
+      },
+      n, repeats);
+  return 0;
+}
@@ -0,0 +1,127 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Lexing and UTF-8 validation throughput on an ASCII-only corpus and on the
+// same corpus with localized strings, per kernel, and the hardware counters
+// of lexing per token where the kernel provides them.
+//
+//   build/bench/bench_utf8 [statements]
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "lex/token_loader.h"
+#include "lex/utf8.h"
+#include "runtime/perf_counters.h"
+
+namespace {
+
+using elsh::lex::utf8::Kernel;
+using elsh::runtime::PerfCounters;
+using elsh::runtime::PerfValues;
+
+std::string Corpus(const int statements, const bool mixed) {
+  static const char* const kAscii[] = {"file not found", "permission denied",
+                                       "connection reset", "out of memory"};
+  static const char* const kMixed[] = {
+      "Datei nicht gefunden: \xC3\xBC\xC3\xB6\xC3\xA4",
+      "acc\xC3\xA8s refus\xC3\xA9",
+      "\xE8\xBF\x9E\xE6\x8E\xA5\xE5\xB7\xB2\xE9\x87\x8D\xE7\xBD\xAE",
+      "\xD0\xBD\xD0\xB5\xD1\x85\xD0\xB2\xD0\xB0\xD1\x82\xD0\xBA\xD0\xB0 "
+      "\xD0\xBF\xD0\xB0\xD0\xBC\xD1\x8F\xD1\x82\xD0\xB8"};
+  std::string corpus;
+  for (int i = 0; i < statements; ++i) {
+    corpus += "string m" + std::to_string(i) + " = \"" +
+              (mixed ? kMixed : kAscii)[i % 4] + "\"; print(m" +
+              std::to_string(i) + ");\n";
+  }
+  return corpus;
+}
+
+double MegabytesPerSecond(const std::chrono::steady_clock::time_point start,
+                          const size_t bytes, const int rounds) {
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  return static_cast<double>(bytes) * rounds / seconds / 1e6;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int statements = argc > 1 ? std::atoi(argv[1]) : 100000;
+  constexpr int kLexRounds = 3;
+  constexpr int kValidateRounds = 200;
+  const Kernel kernels[] = {Kernel::kScalar, Kernel::kSse2, Kernel::kAvx2};
+
+  std::cout << std::fixed << std::setprecision(1) << std::setw(8) << "corpus"
+            << std::setw(12) << "bytes" << std::setw(12) << "lex MB/s";
+  for (const auto kernel : kernels) {
+    std::cout << std::setw(10) << elsh::lex::utf8::KernelName(kernel);
+  }
+  std::cout << "  validate MB/s\n";
+
+  const PerfCounters counters;
+  PerfValues lex_perf[2];
+  size_t num_tokens[2] = {0, 0};
+  size_t checksum = 0;
+  for (const bool mixed : {false, true}) {
+    const std::string corpus = Corpus(statements, mixed);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kLexRounds; ++round) {
+      std::istringstream ss(corpus);
+      elsh::lex::TokenLoader loader(&ss);
+      PerfCounters::ScopedRegion region(&counters, &lex_perf[mixed]);
+      num_tokens[mixed] += loader.GetAllTokens().size();
+    }
+    checksum += num_tokens[mixed];
+    std::cout << std::setw(8) << (mixed ? "mixed" : "ascii") << std::setw(12)
+              << corpus.size() << std::setw(12)
+              << MegabytesPerSecond(start, corpus.size(), kLexRounds);
+
+    for (const auto kernel : kernels) {
+      start = std::chrono::steady_clock::now();
+      for (int round = 0; round < kValidateRounds; ++round) {
+        checksum += elsh::lex::utf8::Validate(corpus.data(), corpus.size(),
+                                              kernel);
+      }
+      std::cout << std::setw(10)
+                << MegabytesPerSecond(start, corpus.size(), kValidateRounds);
+    }
+    std::cout << "\n";
+  }
+
+  if (!counters.available()) {
+    std::cout << "perf counters unavailable (" << counters.error() << ")\n";
+    return checksum == 0 ? 1 : 0;
+  }
+  for (const bool mixed : {false, true}) {
+    std::cout << "lex " << (mixed ? "mixed" : "ascii") << "\n";
+    counters.Report(lex_perf[mixed], num_tokens[mixed], "token", &std::cout);
+  }
+  return checksum == 0 ? 1 : 0;
+}
@@ -20,26 +20,519 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <limits.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "lex/token_image.h"
 #include "lex/token_loader.h"
+#include "runtime/fork_server.h"
+#include "runtime/output_buffer.h"
+#include "runtime/perf_counters.h"
+#include "runtime/profiler.h"
+#include "runtime/session.h"
+#include "runtime/stats.h"
+#include "runtime/token_printer.h"
 
-using elsh::lex::kTokenNames;
 using elsh::lex::Token;
+using elsh::lex::TokenImage;
 using elsh::lex::TokenType;
+using elsh::runtime::ForkServer;
+using elsh::runtime::OutputBuffer;
+using elsh::runtime::PerfCounters;
+using elsh::runtime::Profiler;
+using elsh::runtime::PrintToken;
+using elsh::runtime::Session;
+using elsh::runtime::Stats;
 
-int main(int argc, char** argv) {
-  if (argc < 2) {
-    return -1;
+namespace {
+
+bool ReadFile(const std::string& path, std::string* const contents) {
+  std::ifstream fs(path, std::ios::binary);
+  if (!fs.is_open()) {
+    return false;
+  }
+  contents->assign(std::istreambuf_iterator<char>(fs),
+                   std::istreambuf_iterator<char>());
+  return true;
+}
+
+std::vector<Token> LexSource(const std::string& source) {
+  std::istringstream ss(source);
+  elsh::lex::TokenLoader loader(&ss);
+  return loader.GetAllTokens();
+}
+
+// Same as `LexSource`, every token is one execution at its starting line
+// with its type as the op.
+std::vector<Token> LexSourceProfiled(const std::string& source,
+                                     Profiler* const profiler) {
+  std::istringstream ss(source);
+  elsh::lex::TokenLoader loader(&ss);
+  std::vector<Token> all_tokens;
+  if (!profiler->Start()) {
+    std::cerr << "can not start the profiler, the report has no samples\n";
   }
+  do {
+    all_tokens.push_back(loader.GetToken());
+    profiler->Record(all_tokens.back().err_ln,
+                     static_cast<uint16_t>(all_tokens.back().tok_type));
+  } while (all_tokens.back().tok_type != TokenType::kTokenUnknown &&
+           all_tokens.back().tok_type != TokenType::kTokenEOI);
+  profiler->Stop();
+  return all_tokens;
+}
+
+std::string TokenName(const uint16_t op) {
+  return elsh::lex::TokenName(static_cast<TokenType>(op));
+}
 
-  std::ifstream fs(argv[1]);
-  elsh::lex::TokenLoader loader(&fs);
-  for (const auto& tok : loader.GetAllTokens()) {
-    std::cout << tok << "\n" << std::flush;
+std::string CachePath(const std::string& cache_dir, const uint64_t hash) {
+  static const char kHexDigits[] = "0123456789abcdef";
+  std::string name(16, '0');
+  for (int i = 15; i >= 0; --i) {
+    name[i] = kHexDigits[(hash >> ((15 - i) * 4)) & 0xf];
   }
+  return cache_dir + "/" + name + elsh::lex::image::kFileSuffix;
+}
+
+void PrintUsage(const char* const program) {
+  std::cerr << "usage: " << program << " [options] <file>\n"
+            << "       " << program << " --repl\n"
+            << "  --line-buffered   flush every line when stdout is a tty\n"
+            << "  --compile         write the compiled token image and exit\n"
+            << "  -o <path>         output of --compile, <file>.etok by "
+               "default\n"
+            << "  --cache-dir <dir> reuse compiled images keyed by the "
+               "source hash\n"
+            << "  --profile         report time per line and token type "
+               "on stderr\n"
+            << "  --profile-folded <path>\n"
+            << "                    also write folded stacks for "
+               "flamegraph.pl\n"
+            << "  --stats           report time and allocations per phase "
+               "on stderr\n"
+            << "  --stats-json <path>\n"
+            << "                    write the same numbers as json\n"
+            << "  --perf            report hardware counters per phase and "
+               "token on stderr\n"
+            << "  --repl            read and run stdin line by line, keeping "
+               "definitions\n"
+            << "  --watch           run <file> again whenever it is saved\n"
+            << "  --server <socket> keep [files] lexed and fork a child per "
+               "request\n"
+            << "  --connect <socket>\n"
+            << "                    run <file> in the server with its "
+               "options, or here if\n"
+            << "                    there is none\n";
+}
+
+struct Options {
+  std::string output;
+  std::string cache_dir;
+  bool line_buffered = false;
+  bool compile = false;
+  bool profile = false;
+  std::string folded_path;
+};
+
+// Tokens of the source `Run` lexed last, so that watch mode skips lexing
+// when a save left the file as it was.
+struct LexCache {
+  bool valid = false;
+  uint64_t hash = 0;
+  std::vector<Token> tokens;
+};
+
+// Lex `source` into `lex_cache` unless it already holds its tokens.
+void UpdateLexCache(const std::string& source, LexCache* const lex_cache,
+                    Stats* const stats) {
+  const uint64_t hash = elsh::lex::HashSource(source.data(), source.size());
+  if (!lex_cache->valid || lex_cache->hash != hash) {
+    Stats::ScopedPhase phase(stats, "lex");
+    lex_cache->tokens = LexSource(source);
+    lex_cache->hash = hash;
+    lex_cache->valid = true;
+  }
+}
+
+int Run(const std::string& file, const Options& options, Stats* const stats,
+        LexCache* const lex_cache = nullptr,
+        size_t* const num_tokens = nullptr) {
+  std::string source;
+  {
+    Stats::ScopedPhase phase(stats, "read");
+    if (!ReadFile(file, &source)) {
+      std::cerr << "can not open " << file << "\n";
+      return -1;
+    }
+  }
+
+  std::unique_ptr<TokenImage> token_image;
+  std::vector<Token> tokens;
+  const std::vector<Token>* listing = &tokens;
+  if (options.profile) {
+    Stats::ScopedPhase phase(stats, "lex");
+    // Always lex, a cached image would leave nothing to profile.
+    Profiler profiler;
+    tokens = LexSourceProfiled(source, &profiler);
+    profiler.Report(TokenName, &std::cerr);
+    if (!options.folded_path.empty()) {
+      std::ofstream folded(options.folded_path);
+      profiler.WriteFolded(file, TokenName, &folded);
+    }
+  } else if (elsh::lex::IsTokenImage(source.data(), source.size())) {
+    Stats::ScopedPhase phase(stats, "load");
+    token_image = TokenImage::Load(file);
+    if (!token_image) {
+      std::cerr << file << ": invalid or outdated token image\n";
+      return -1;
+    }
+  } else if (options.compile) {
+    {
+      Stats::ScopedPhase phase(stats, "lex");
+      tokens = LexSource(source);
+    }
+    Stats::ScopedPhase phase(stats, "compile");
+    const std::string path = options.output.empty()
+                                 ? file + elsh::lex::image::kFileSuffix
+                                 : options.output;
+    const uint64_t hash = elsh::lex::HashSource(source.data(), source.size());
+    if (!elsh::lex::WriteTokenImage(tokens, hash, path)) {
+      std::cerr << "can not write " << path << "\n";
+      return -1;
+    }
+    return 0;
+  } else if (!options.cache_dir.empty()) {
+    const uint64_t hash = elsh::lex::HashSource(source.data(), source.size());
+    const std::string path = CachePath(options.cache_dir, hash);
+    {
+      Stats::ScopedPhase phase(stats, "load");
+      token_image = TokenImage::Load(path);
+    }
+    if (!token_image || token_image->source_hash() != hash) {
+      token_image.reset();
+      {
+        Stats::ScopedPhase phase(stats, "lex");
+        tokens = LexSource(source);
+      }
+      Stats::ScopedPhase phase(stats, "compile");
+      // A cache that can not be written only costs the next run some time.
+      mkdir(options.cache_dir.c_str(), 0755);
+      elsh::lex::WriteTokenImage(tokens, hash, path);
+    }
+  } else if (lex_cache != nullptr) {
+    UpdateLexCache(source, lex_cache, stats);
+    listing = &lex_cache->tokens;
+  } else {
+    Stats::ScopedPhase phase(stats, "lex");
+    tokens = LexSource(source);
+  }
+
+  if (num_tokens != nullptr) {
+    *num_tokens = token_image ? token_image->size() : listing->size();
+  }
+
+  Stats::ScopedPhase phase(stats, "execute");
+  OutputBuffer out;
+  // Only make a difference for interactive use, pipes and files keep the
+  // large buffer.
+  out.SetLineBuffered(options.line_buffered && out.IsTerminal());
+
+  if (token_image) {
+    token_image->ForEachToken(
+        [&out](const Token& token) { PrintToken(token, &out); });
+  } else {
+    for (const auto& tok : *listing) {
+      PrintToken(tok, &out);
+    }
+  }
+
+  return out.Flush() ? 0 : -1;
+}
+
+// Hardware counters of every phase of `stats`, per token as well. Without
+// counters only the wall time is left to report.
+void ReportPerf(const Stats& stats, const PerfCounters& counters,
+                const size_t num_tokens) {
+  if (!counters.available()) {
+    std::cerr << "perf counters unavailable (" << counters.error()
+              << "), wall time only\n";
+  }
+  std::vector<Stats::Phase> rows = stats.phases();
+  rows.push_back(stats.Total());
+  for (const auto& phase : rows) {
+    std::cerr << phase.name << ": " << std::fixed << std::setprecision(3)
+              << phase.wall_ns / 1e6 << " ms";
+    if (num_tokens > 0) {
+      std::cerr << ", " << std::setprecision(2)
+                << static_cast<double>(phase.wall_ns) / num_tokens
+                << " ns/token";
+    }
+    std::cerr << "\n";
+    if (counters.available()) {
+      counters.Report(phase.perf, num_tokens, "token", &std::cerr);
+    }
+  }
+}
 
+// Interactive session, every line is compiled and run on its own against
+// the state the previous lines left.
+int RunRepl() {
+  const bool interactive = isatty(STDIN_FILENO);
+  Session session(STDOUT_FILENO);
+  std::string line;
+  std::string error;
+  while (true) {
+    if (interactive) {
+      std::cerr << "> " << std::flush;
+    }
+    if (!std::getline(std::cin, line)) {
+      break;
+    }
+    line.push_back('\n');
+    if (!session.Eval(line, &error) && !error.empty()) {
+      std::cerr << error << "\n";
+      error.clear();
+    }
+  }
   return 0;
 }
+
+// Run `file` now and after every save, reporting how long each cycle took.
+// Editors either rewrite the file or replace it by renaming a new one over
+// it, so the directory is watched rather than the file.
+int Watch(const std::string& file, const Options& options) {
+  const size_t slash = file.rfind('/');
+  const std::string dir = slash == std::string::npos
+                              ? "."
+                              : (slash == 0 ? "/" : file.substr(0, slash));
+  const std::string name =
+      slash == std::string::npos ? file : file.substr(slash + 1);
+  const int inotify_fd = inotify_init1(IN_CLOEXEC);
+  if (inotify_fd < 0) {
+    std::cerr << "can not watch " << dir << "\n";
+    return -1;
+  }
+  if (inotify_add_watch(inotify_fd, dir.c_str(),
+                        IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    std::cerr << "can not watch " << dir << "\n";
+    close(inotify_fd);
+    return -1;
+  }
+
+  LexCache lex_cache;
+  alignas(inotify_event) char events[4096];
+  while (true) {
+    Stats stats;
+    const auto start = std::chrono::steady_clock::now();
+    Run(file, options, &stats, &lex_cache);
+    const double ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+    std::cerr << "[watch] " << file << ": " << std::fixed
+              << std::setprecision(3) << ms << " ms (";
+    for (size_t i = 0; i < stats.phases().size(); ++i) {
+      const auto& phase = stats.phases()[i];
+      std::cerr << (i > 0 ? ", " : "") << phase.name << " "
+                << phase.wall_ns / 1e6;
+    }
+    std::cerr << ")" << std::endl;
+
+    // Block until the file is saved, then take every event already queued so
+    // that one save runs the script once.
+    bool saved = false;
+    int timeout = -1;
+    while (true) {
+      pollfd pfd{inotify_fd, POLLIN, 0};
+      const int ready = poll(&pfd, 1, timeout);
+      if (ready < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        std::cerr << "can not watch " << dir << ": " << strerror(errno)
+                  << "\n";
+        close(inotify_fd);
+        return -1;
+      }
+      if (ready == 0) {
+        // Only polled without blocking once saved: the queue is drained.
+        break;
+      }
+      const ssize_t size = read(inotify_fd, events, sizeof(events));
+      if (size <= 0) {
+        close(inotify_fd);
+        return -1;
+      }
+      for (ssize_t offset = 0; offset < size;) {
+        const auto* event = reinterpret_cast<inotify_event*>(events + offset);
+        if (event->len > 0 && name == event->name) {
+          saved = true;
+        }
+        offset += sizeof(inotify_event) + event->len;
+      }
+      timeout = saved ? 0 : -1;
+    }
+  }
+}
+
+// Fork server: the requests are script paths, lexed here before every fork so
+// that the children only run them. `files` are lexed up front.
+int Serve(const std::string& socket_path, const std::vector<std::string>& files,
+          const Options& options) {
+  std::string error;
+  const auto server = ForkServer::Listen(socket_path, &error);
+  if (!server) {
+    std::cerr << error << "\n";
+    return -1;
+  }
+  std::unordered_map<std::string, LexCache> lex_caches;
+  const auto prepare = [&lex_caches](const std::string& file) {
+    std::string source;
+    Stats stats;
+    if (ReadFile(file, &source)) {
+      UpdateLexCache(source, &lex_caches[file], &stats);
+    }
+  };
+  // Requests name files by their real path, preload them under it too.
+  for (const auto& file : files) {
+    char path[PATH_MAX];
+    if (realpath(file.c_str(), path) == nullptr) {
+      std::cerr << "can not open " << file << "\n";
+      continue;
+    }
+    prepare(path);
+  }
+  const bool served = server->Serve(
+      prepare, [&lex_caches, &options](const std::string& file) {
+        Stats stats;
+        return Run(file, options, &stats, &lex_caches[file]);
+      });
+  return served ? 0 : -1;
+}
+
+// Client of `Serve`, behaving like a local run of `file`. Falls back to one if
+// no server is listening.
+int Connect(const std::string& socket_path, const std::string& file,
+            const Options& options) {
+  char path[PATH_MAX];
+  int status;
+  if (realpath(file.c_str(), path) != nullptr &&
+      elsh::runtime::SendForkRequest(socket_path, path, STDOUT_FILENO,
+                                     STDERR_FILENO, &status)) {
+    return status;
+  }
+  Stats stats;
+  return Run(file, options, &stats);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string file;
+  Options options;
+  bool repl = false;
+  bool watch = false;
+  std::string server_socket;
+  std::string connect_socket;
+  std::vector<std::string> files;
+  bool stats_report = false;
+  bool perf = false;
+  std::string stats_json_path;
+  for (int i = 1; i < argc; ++i) {
+    const bool has_value = i + 1 < argc;
+    if (std::strcmp(argv[i], "--line-buffered") == 0) {
+      options.line_buffered = true;
+    } else if (std::strcmp(argv[i], "--compile") == 0) {
+      options.compile = true;
+    } else if (std::strcmp(argv[i], "-o") == 0 && has_value) {
+      options.output = argv[++i];
+    } else if (std::strcmp(argv[i], "--cache-dir") == 0 && has_value) {
+      options.cache_dir = argv[++i];
+    } else if (std::strcmp(argv[i], "--profile") == 0) {
+      options.profile = true;
+    } else if (std::strcmp(argv[i], "--profile-folded") == 0 && has_value) {
+      options.profile = true;
+      options.folded_path = argv[++i];
+    } else if (std::strcmp(argv[i], "--stats") == 0) {
+      stats_report = true;
+    } else if (std::strcmp(argv[i], "--stats-json") == 0 && has_value) {
+      stats_json_path = argv[++i];
+    } else if (std::strcmp(argv[i], "--perf") == 0) {
+      perf = true;
+    } else if (std::strcmp(argv[i], "--repl") == 0) {
+      repl = true;
+    } else if (std::strcmp(argv[i], "--watch") == 0) {
+      watch = true;
+    } else if (std::strcmp(argv[i], "--server") == 0 && has_value) {
+      server_socket = argv[++i];
+    } else if (std::strcmp(argv[i], "--connect") == 0 && has_value) {
+      connect_socket = argv[++i];
+    } else if (argv[i][0] == '-') {
+      PrintUsage(argv[0]);
+      return -1;
+    } else {
+      file = argv[i];
+      files.push_back(file);
+    }
+  }
+  if (!server_socket.empty()) {
+    return Serve(server_socket, files, options);
+  }
+  if (repl) {
+    return RunRepl();
+  }
+  if (file.empty()) {
+    PrintUsage(argv[0]);
+    return -1;
+  }
+  if (watch) {
+    return Watch(file, options);
+  }
+  if (!connect_socket.empty()) {
+    // The server's children run with the server's options.
+    if (options.line_buffered || options.profile || options.compile ||
+        !options.cache_dir.empty() || stats_report || perf ||
+        !stats_json_path.empty()) {
+      std::cerr << "--connect takes no run options, the server's apply\n";
+      return -1;
+    }
+    return Connect(connect_socket, file, options);
+  }
+
+  Stats stats;
+  std::unique_ptr<PerfCounters> perf_counters;
+  if (perf) {
+    perf_counters.reset(new PerfCounters());
+    stats.set_perf_counters(perf_counters.get());
+  }
+  size_t num_tokens = 0;
+  const int ret = Run(file, options, &stats, nullptr, &num_tokens);
+  if (perf) {
+    ReportPerf(stats, *perf_counters, num_tokens);
+  }
+  if (stats_report) {
+    stats.Report(&std::cerr);
+  }
+  if (!stats_json_path.empty()) {
+    std::ofstream json(stats_json_path);
+    stats.WriteJson(&json);
+  }
+  return ret;
+}
@@ -0,0 +1,160 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "lex/line_table.h"
+
+namespace elsh {
+namespace lex {
+namespace {
+constexpr uint8_t kExtended = 0x80;
+constexpr uint8_t kNextLine = 0x40;
+constexpr int32_t kMaxShortCol = 0x3f;
+
+uint64_t ZigZag(const int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(const uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+}  // namespace
+
+void LineTableBuilder::Add(const int32_t line, const int32_t col) {
+  if (size_ % line_table::kCheckpointInterval == 0) {
+    checkpoints_.push_back(
+        {static_cast<uint32_t>(bytes_.size()), line_, col_});
+  }
+  ++size_;
+
+  const int64_t line_delta = static_cast<int64_t>(line) - line_;
+  const int64_t col_value =
+      line_delta == 0 ? static_cast<int64_t>(col) - col_ : col;
+  line_ = line;
+  col_ = col;
+  if ((line_delta == 0 || line_delta == 1) && 0 <= col_value &&
+      col_value <= kMaxShortCol) {
+    bytes_.push_back(static_cast<char>((line_delta == 1 ? kNextLine : 0) |
+                                       static_cast<uint8_t>(col_value)));
+    return;
+  }
+  bytes_.push_back(static_cast<char>(kExtended));
+  PutVarint(ZigZag(line_delta));
+  PutVarint(ZigZag(col_value));
+}
+
+void LineTableBuilder::PutVarint(uint64_t value) {
+  while (value >= 0x80) {
+    bytes_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  bytes_.push_back(static_cast<char>(value));
+}
+
+LineTable::LineTable(const char* const bytes, const size_t num_bytes,
+                     const line_table::Checkpoint* const checkpoints,
+                     const size_t size)
+    : bytes_(bytes),
+      num_bytes_(num_bytes),
+      checkpoints_(checkpoints),
+      size_(size) {}
+
+bool LineTable::Lookup(const size_t index, int32_t* const line,
+                       int32_t* const col) const {
+  if (index >= size_) {
+    return false;
+  }
+  Cursor cursor(*this,
+                index / line_table::kCheckpointInterval *
+                    line_table::kCheckpointInterval);
+  for (size_t i = index % line_table::kCheckpointInterval; i > 0; --i) {
+    if (!cursor.Next(line, col)) {
+      return false;
+    }
+  }
+  return cursor.Next(line, col);
+}
+
+LineTable::Cursor::Cursor(const LineTable& table, const size_t index)
+    : table_(table), index_(index), offset_(0), line_(1), col_(0) {
+  if (index >= table.size_) {
+    index_ = table.size_;
+    return;
+  }
+  const line_table::Checkpoint& checkpoint =
+      table.checkpoints_[index / line_table::kCheckpointInterval];
+  offset_ = checkpoint.offset;
+  line_ = checkpoint.line;
+  col_ = checkpoint.col;
+  index_ = index / line_table::kCheckpointInterval *
+           line_table::kCheckpointInterval;
+  int32_t line;
+  int32_t col;
+  while (index_ < index && Next(&line, &col)) {
+  }
+}
+
+bool LineTable::Cursor::Next(int32_t* const line, int32_t* const col) {
+  if (index_ >= table_.size_ || offset_ >= table_.num_bytes_) {
+    return false;
+  }
+  const uint8_t head = static_cast<uint8_t>(table_.bytes_[offset_++]);
+  if ((head & kExtended) == 0) {
+    if ((head & kNextLine) != 0) {
+      ++line_;
+      col_ = head & kMaxShortCol;
+    } else {
+      col_ += head & kMaxShortCol;
+    }
+  } else {
+    uint64_t line_delta;
+    uint64_t col_value;
+    if (!GetVarint(&line_delta) || !GetVarint(&col_value)) {
+      return false;
+    }
+    line_ += static_cast<int32_t>(UnZigZag(line_delta));
+    col_ = static_cast<int32_t>(UnZigZag(col_value)) +
+           (line_delta == 0 ? col_ : 0);
+  }
+  ++index_;
+  *line = line_;
+  *col = col_;
+  return true;
+}
+
+bool LineTable::Cursor::GetVarint(uint64_t* const value) {
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (offset_ >= table_.num_bytes_) {
+      return false;
+    }
+    const uint8_t byte = static_cast<uint8_t>(table_.bytes_[offset_++]);
+    *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace lex
+}  // namespace elsh
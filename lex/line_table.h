@@ -0,0 +1,132 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef LEX_LINE_TABLE_H_
+#define LEX_LINE_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace elsh {
+namespace lex {
+
+/// @brief Source positions of a token stream, kept apart from the tokens and
+/// packed like a DWARF line program: every entry stores its position relative
+/// to the one before.
+///
+/// An entry on the same line as its predecessor, at most 63 columns further,
+/// or at a column below 64 of the next line takes one byte:
+///
+///   0 n cccccc      n: next line, c: column delta, or column on a new line
+///
+/// Every other entry is the byte 0x80 followed by the zigzag varints of the
+/// line delta and of the column delta (same line) or the column (new line).
+/// A checkpoint every `kCheckpointInterval` entries bounds the work of a
+/// random lookup.
+namespace line_table {
+
+constexpr size_t kCheckpointInterval = 64;
+
+/// @brief Decoder state right before entry `k * kCheckpointInterval`.
+struct Checkpoint {
+  uint32_t offset;
+  int32_t line;
+  int32_t col;
+};
+
+}  // namespace line_table
+
+class LineTableBuilder {
+ public:
+  void Add(const int32_t line, const int32_t col);
+
+  size_t size() const { return size_; }
+  const std::string& bytes() const { return bytes_; }
+  const std::vector<line_table::Checkpoint>& checkpoints() const {
+    return checkpoints_;
+  }
+
+ private:
+  void PutVarint(uint64_t value);
+
+ private:
+  size_t size_ = 0;
+  int32_t line_ = 1;
+  int32_t col_ = 0;
+  std::string bytes_;
+  std::vector<line_table::Checkpoint> checkpoints_;
+};
+
+/// @brief Read-only view of an encoded table, typically inside a mapped
+/// image. Positions are only decoded on request.
+class LineTable {
+ public:
+  LineTable(const char* const bytes, const size_t num_bytes,
+            const line_table::Checkpoint* const checkpoints,
+            const size_t size);
+
+  static size_t NumCheckpoints(const size_t size) {
+    return (size + line_table::kCheckpointInterval - 1) /
+           line_table::kCheckpointInterval;
+  }
+
+  size_t size() const { return size_; }
+
+  /// @brief Position of entry `index`. Return false if it is out of range or
+  /// the table is corrupted.
+  bool Lookup(const size_t index, int32_t* const line,
+              int32_t* const col) const;
+
+  /// @brief Sequential decoder, one step per entry.
+  class Cursor {
+   public:
+    /// @brief Start at entry `index`.
+    Cursor(const LineTable& table, const size_t index);
+
+    /// @brief Position of the current entry, then move to the next one.
+    /// Return false past the end or on corrupted data.
+    bool Next(int32_t* const line, int32_t* const col);
+
+   private:
+    bool GetVarint(uint64_t* const value);
+
+   private:
+    const LineTable& table_;
+    size_t index_;
+    size_t offset_;
+    int32_t line_;
+    int32_t col_;
+  };
+
+ private:
+  const char* const bytes_;
+  const size_t num_bytes_;
+  const line_table::Checkpoint* const checkpoints_;
+  const size_t size_;
+};
+
+}  // namespace lex
+}  // namespace elsh
+
+#endif  // LEX_LINE_TABLE_H_
@@ -0,0 +1,300 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "lex/token_image.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace elsh {
+namespace lex {
+namespace {
+constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+bool HasConstantOperand(const TokenType type) {
+  return type == TokenType::kTokenValueInt ||
+         type == TokenType::kTokenValueDouble ||
+         type == TokenType::kTokenValueChar;
+}
+
+uint64_t AlignUp(const uint64_t offset) { return (offset + 7) & ~7ULL; }
+
+template <typename T>
+bool SectionFits(const uint64_t offset, const uint64_t count,
+                 const size_t file_size) {
+  return offset % alignof(T) == 0 && offset <= file_size &&
+         count <= (file_size - offset) / sizeof(T);
+}
+
+template <typename T>
+const T* Section(const char* const data, const uint64_t offset) {
+  return reinterpret_cast<const T*>(data + offset);
+}
+}  // namespace
+
+uint64_t HashSource(const char* const data, const size_t size) {
+  uint64_t hash = kFnvOffsetBasis;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+bool WriteTokenImage(const std::vector<Token>& tokens,
+                     const uint64_t source_hash, const std::string& path) {
+  std::vector<uint64_t> constants;
+  std::vector<image::StringEntry> strings;
+  std::vector<image::TokenRecord> code;
+  LineTableBuilder lines;
+  std::string string_pool;
+  std::unordered_map<uint64_t, uint32_t> constant_index;
+  std::unordered_map<std::string, uint32_t> string_index;
+
+  code.reserve(tokens.size());
+  for (const auto& token : tokens) {
+    image::TokenRecord record;
+    record.type = static_cast<uint16_t>(token.tok_type);
+    record.reserved = 0;
+    if (HasConstantOperand(token.tok_type)) {
+      uint64_t bits;
+      if (token.tok_type == TokenType::kTokenValueDouble) {
+        std::memcpy(&bits, &token.value_double, sizeof(bits));
+      } else if (token.tok_type == TokenType::kTokenValueChar) {
+        bits = static_cast<uint64_t>(token.value_char);
+      } else {
+        bits = static_cast<uint64_t>(token.value_int);
+      }
+      const auto it = constant_index.emplace(bits, constants.size()).first;
+      if (it->second == constants.size()) {
+        constants.push_back(bits);
+      }
+      record.operand = it->second;
+    } else {
+      const auto it = string_index.emplace(token.str, strings.size()).first;
+      if (it->second == strings.size()) {
+        strings.push_back({static_cast<uint32_t>(string_pool.size()),
+                           static_cast<uint32_t>(token.str.size())});
+        string_pool += token.str;
+      }
+      record.operand = it->second;
+    }
+    code.push_back(record);
+    lines.Add(token.err_ln, token.err_col);
+  }
+
+  image::Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, image::kMagic, sizeof(header.magic));
+  header.version = image::kVersion;
+  header.num_tokens = static_cast<uint32_t>(code.size());
+  header.num_constants = static_cast<uint32_t>(constants.size());
+  header.num_strings = static_cast<uint32_t>(strings.size());
+  header.string_pool_size = string_pool.size();
+  header.source_hash = source_hash;
+  header.constants_offset = AlignUp(sizeof(header));
+  header.strings_offset = AlignUp(header.constants_offset +
+                                  constants.size() * sizeof(uint64_t));
+  header.code_offset = AlignUp(header.strings_offset +
+                               strings.size() * sizeof(image::StringEntry));
+  header.checkpoints_offset =
+      AlignUp(header.code_offset + code.size() * sizeof(image::TokenRecord));
+  header.lines_offset =
+      header.checkpoints_offset +
+      lines.checkpoints().size() * sizeof(line_table::Checkpoint);
+  header.lines_size = lines.bytes().size();
+  header.string_pool_offset = header.lines_offset + header.lines_size;
+
+  std::string contents(header.string_pool_offset + string_pool.size(), '\0');
+  char* const data = &contents[0];
+  std::memcpy(data, &header, sizeof(header));
+  std::memcpy(data + header.constants_offset, constants.data(),
+              constants.size() * sizeof(uint64_t));
+  std::memcpy(data + header.strings_offset, strings.data(),
+              strings.size() * sizeof(image::StringEntry));
+  std::memcpy(data + header.code_offset, code.data(),
+              code.size() * sizeof(image::TokenRecord));
+  std::memcpy(data + header.checkpoints_offset, lines.checkpoints().data(),
+              lines.checkpoints().size() * sizeof(line_table::Checkpoint));
+  std::memcpy(data + header.lines_offset, lines.bytes().data(),
+              lines.bytes().size());
+  std::memcpy(data + header.string_pool_offset, string_pool.data(),
+              string_pool.size());
+
+  const std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream fs(tmp_path, std::ios::binary | std::ios::trunc);
+    fs.write(contents.data(), contents.size());
+    if (!fs) {
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool IsTokenImage(const char* const data, const size_t size) {
+  return size >= sizeof(image::kMagic) &&
+         std::memcmp(data, image::kMagic, sizeof(image::kMagic)) == 0;
+}
+
+std::unique_ptr<TokenImage> TokenImage::Load(const std::string& path) {
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(image::Header)) {
+    close(fd);
+    return nullptr;
+  }
+  const size_t size = st.st_size;
+  void* const data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+
+  std::unique_ptr<TokenImage> token_image(
+      new TokenImage(static_cast<const char*>(data), size));
+  const image::Header& header = *token_image->header_;
+  const bool valid =
+      IsTokenImage(token_image->data_, size) &&
+      header.version == image::kVersion &&
+      SectionFits<uint64_t>(header.constants_offset, header.num_constants,
+                            size) &&
+      SectionFits<image::StringEntry>(header.strings_offset,
+                                      header.num_strings, size) &&
+      SectionFits<image::TokenRecord>(header.code_offset, header.num_tokens,
+                                      size) &&
+      SectionFits<line_table::Checkpoint>(
+          header.checkpoints_offset,
+          LineTable::NumCheckpoints(header.num_tokens), size) &&
+      SectionFits<char>(header.lines_offset, header.lines_size, size) &&
+      SectionFits<char>(header.string_pool_offset, header.string_pool_size,
+                        size);
+  if (!valid) {
+    return nullptr;
+  }
+  // Checked once here, so `MakeToken` never hands out a type outside the
+  // enum.
+  const image::TokenRecord* const records =
+      Section<image::TokenRecord>(token_image->data_, header.code_offset);
+  for (uint64_t i = 0; i < header.num_tokens; ++i) {
+    if (!IsTokenType(records[i].type)) {
+      return nullptr;
+    }
+  }
+  return token_image;
+}
+
+TokenImage::TokenImage(const char* const data, const size_t size)
+    : data_(data),
+      size_(size),
+      header_(reinterpret_cast<const image::Header*>(data)),
+      line_table_(data + header_->lines_offset, header_->lines_size,
+                  Section<line_table::Checkpoint>(
+                      data, header_->checkpoints_offset),
+                  header_->num_tokens) {}
+
+TokenImage::~TokenImage() { munmap(const_cast<char*>(data_), size_); }
+
+Token TokenImage::GetToken(const size_t index) const {
+  if (index >= size()) {
+    return Token(TokenType::kTokenUnknown, -1, -1, "token out of image");
+  }
+  int32_t line;
+  int32_t col;
+  if (!line_table_.Lookup(index, &line, &col)) {
+    return Token(TokenType::kTokenUnknown, -1, -1,
+                 "corrupted line table in image");
+  }
+  return MakeToken(index, line, col);
+}
+
+Token TokenImage::MakeToken(const size_t index, const int32_t line,
+                            const int32_t col) const {
+  const image::TokenRecord& record =
+      Section<image::TokenRecord>(data_, header_->code_offset)[index];
+  const TokenType type = static_cast<TokenType>(record.type);
+
+  if (HasConstantOperand(type)) {
+    if (record.operand >= header_->num_constants) {
+      return Token(TokenType::kTokenUnknown, line, col,
+                   "corrupted constant in image");
+    }
+    const uint64_t bits =
+        Section<uint64_t>(data_, header_->constants_offset)[record.operand];
+    if (type == TokenType::kTokenValueDouble) {
+      double value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return Token(type, line, col, value);
+    } else if (type == TokenType::kTokenValueChar) {
+      return Token(type, line, col, static_cast<char>(bits));
+    }
+    Token token(type, line, col);
+    token.value_int = static_cast<int64_t>(bits);
+    return token;
+  }
+
+  if (record.operand >= header_->num_strings) {
+    return Token(TokenType::kTokenUnknown, line, col,
+                 "corrupted string in image");
+  }
+  const image::StringEntry& entry = Section<image::StringEntry>(
+      data_, header_->strings_offset)[record.operand];
+  if (entry.offset > header_->string_pool_size ||
+      entry.size > header_->string_pool_size - entry.offset) {
+    return Token(TokenType::kTokenUnknown, line, col,
+                 "corrupted string in image");
+  }
+  Token token(type, line, col,
+              std::string(data_ + header_->string_pool_offset + entry.offset,
+                          entry.size));
+  token.value_int = 0;
+  return token;
+}
+
+std::vector<Token> TokenImage::GetAllTokens() const {
+  std::vector<Token> all_tokens;
+  all_tokens.reserve(size());
+  ForEachToken([&all_tokens](const Token& token) {
+    all_tokens.push_back(token);
+  });
+  return all_tokens;
+}
+
+}  // namespace lex
+}  // namespace elsh
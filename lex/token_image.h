@@ -0,0 +1,161 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef LEX_TOKEN_IMAGE_H_
+#define LEX_TOKEN_IMAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "lex/line_table.h"
+#include "lex/types.h"
+
+namespace elsh {
+namespace lex {
+
+/// @brief On-disk layout of a compiled token stream. Everything is addressed
+/// by offsets from the start of the file, so an image is usable right after
+/// `mmap` without any relocation or parsing:
+///
+///   Header
+///   uint64_t        constants[num_constants]    int / double / char values
+///   StringEntry     strings[num_strings]        interned, deduplicated
+///   TokenRecord     code[num_tokens]
+///   Checkpoint      checkpoints[]               see `LineTable`
+///   char            lines[lines_size]           line table
+///   char            string_pool[string_pool_size]
+///
+/// Positions are only needed to report them, so they stay out of the code
+/// and are decoded from the compact line table on demand.
+namespace image {
+
+constexpr char kMagic[8] = {'E', 'L', 'S', 'H', 'T', 'O', 'K', '\0'};
+/// Bumped whenever the layout or the tokens the lexer produces change, so
+/// that stale images are rejected and relexed. 3: UTF-8 aware literals and
+/// code point columns.
+constexpr uint32_t kVersion = 3;
+constexpr char kFileSuffix[] = ".etok";
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_tokens;
+  uint32_t num_constants;
+  uint32_t num_strings;
+  uint64_t string_pool_size;
+  uint64_t source_hash;
+  uint64_t constants_offset;
+  uint64_t strings_offset;
+  uint64_t code_offset;
+  uint64_t checkpoints_offset;
+  uint64_t lines_offset;
+  uint64_t lines_size;
+  uint64_t string_pool_offset;
+};
+
+struct StringEntry {
+  uint32_t offset;
+  uint32_t size;
+};
+
+struct TokenRecord {
+  uint16_t type;
+  uint16_t reserved;
+  /// Index into `constants` for int, double and char values, index into
+  /// `strings` for everything else.
+  uint32_t operand;
+};
+
+}  // namespace image
+
+/// @brief 64bit FNV-1a hash of a source file, used as the cache key of its
+/// compiled image.
+uint64_t HashSource(const char* const data, const size_t size);
+
+/// @brief Serialize `tokens` to `path`. The file is written next to `path`
+/// first and renamed, so concurrent readers never see a partial image.
+bool WriteTokenImage(const std::vector<Token>& tokens,
+                     const uint64_t source_hash, const std::string& path);
+
+/// @brief Read-only view of a compiled token stream mapped into memory.
+class TokenImage {
+ public:
+  /// @brief Map the image at `path`. Return nullptr if the file can not be
+  /// mapped or is not a valid image of the current version.
+  static std::unique_ptr<TokenImage> Load(const std::string& path);
+  ~TokenImage();
+
+  TokenImage(const TokenImage&) = delete;
+  TokenImage& operator=(const TokenImage&) = delete;
+
+  size_t size() const { return header_->num_tokens; }
+  uint64_t source_hash() const { return header_->source_hash; }
+
+  /// @brief Materialize the token at `index`. Its position is looked up in
+  /// the line table, so walking the whole image is cheaper with
+  /// `ForEachToken`.
+  Token GetToken(const size_t index) const;
+  std::vector<Token> GetAllTokens() const;
+  /// @brief Call `func(const Token&)` on every token in order.
+  template <typename Func>
+  void ForEachToken(const Func& func) const;
+
+  const LineTable& line_table() const { return line_table_; }
+
+ private:
+  TokenImage(const char* const data, const size_t size);
+
+  Token MakeToken(const size_t index, const int32_t line,
+                  const int32_t col) const;
+
+ private:
+  const char* const data_;
+  const size_t size_;
+  const image::Header* const header_;
+  const LineTable line_table_;
+};
+
+template <typename Func>
+void TokenImage::ForEachToken(const Func& func) const {
+  LineTable::Cursor cursor(line_table_, 0);
+  int32_t line;
+  int32_t col;
+  for (size_t i = 0; i < size(); ++i) {
+    if (!cursor.Next(&line, &col)) {
+      func(Token(TokenType::kTokenUnknown, -1, -1,
+                 "corrupted line table in image"));
+      return;
+    }
+    func(MakeToken(i, line, col));
+  }
+}
+
+/// @brief Whether `data` starts like a compiled token image.
+bool IsTokenImage(const char* const data, const size_t size);
+
+}  // namespace lex
+}  // namespace elsh
+
+#endif  // LEX_TOKEN_IMAGE_H_
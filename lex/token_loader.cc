@@ -22,22 +22,52 @@
 
 #include "lex/token_loader.h"
 
+#include <cctype>
 #include <iostream>
-#include <unordered_map>
+
+#include "lex/utf8.h"
 
 namespace elsh {
 namespace lex {
 namespace {
-const std::unordered_map<char, TokenType> kSimpleTokenMap{
-    {'{', TokenType::kTokenSymLbrace},    {'}', TokenType::kTokenSymRbrace},
-    {'(', TokenType::kTokenSymLparen},    {')', TokenType::kTokenSymRparen},
-    {'+', TokenType::kTokenOpAdd},        {'-', TokenType::kTokenOpSub},
-    {'*', TokenType::kTokenOpMul},        {'%', TokenType::kTokenOpMod},
-    {';', TokenType::kTokenSymSemiColon}, {',', TokenType::kTokenSymComma}};
+// Type of the tokens that are a single character and never start a longer
+// one, `kTokenUnknown` for every other character. A switch rather than a
+// map, so there is nothing to build at startup.
+TokenType SimpleTokenType(const char c) {
+  switch (c) {
+    case '{':
+      return TokenType::kTokenSymLbrace;
+    case '}':
+      return TokenType::kTokenSymRbrace;
+    case '(':
+      return TokenType::kTokenSymLparen;
+    case ')':
+      return TokenType::kTokenSymRparen;
+    case '[':
+      return TokenType::kTokenSymLbracket;
+    case ']':
+      return TokenType::kTokenSymRbracket;
+    case '+':
+      return TokenType::kTokenOpAdd;
+    case '-':
+      return TokenType::kTokenOpSub;
+    case '*':
+      return TokenType::kTokenOpMul;
+    case '%':
+      return TokenType::kTokenOpMod;
+    case ';':
+      return TokenType::kTokenSymSemiColon;
+    case ',':
+      return TokenType::kTokenSymComma;
+    default:
+      return TokenType::kTokenUnknown;
+  }
 }
+}  // namespace
 
-TokenLoader::TokenLoader(std::basic_istream<char>* const stream)
-    : stream_(stream) {}
+TokenLoader::TokenLoader(std::basic_istream<char>* const stream,
+                         const int first_line)
+    : stream_(stream), current_line_(first_line) {}
 
 Token TokenLoader::GetToken() {
   while (isspace(current_char_)) {
@@ -46,9 +76,10 @@ Token TokenLoader::GetToken() {
 
   const int start_line = current_line_;
   const int start_col = current_col_;
-  if (kSimpleTokenMap.count(current_char_) > 0) {
+  const TokenType simple_type = SimpleTokenType(current_char_);
+  if (simple_type != TokenType::kTokenUnknown) {
     GetNextChar();
-    return Token{kSimpleTokenMap.at(last_char_), start_line, start_col, {0}};
+    return Token{simple_type, start_line, start_col, {0}};
   } else {
     switch (current_char_) {
       case '/':
@@ -108,9 +139,16 @@ void TokenLoader::GetNextChar() {
   last_char_ = current_char_;
   if (stream_->get(current_char_)) {
     ++current_col_;
-    if (current_char_ == '\n') {
-      ++current_line_;
-      current_col_ = 0;
+    // Newlines and the bytes of multi-byte sequences, which are negative as
+    // signed chars, share a single compare on the ASCII path.
+    if (static_cast<signed char>(current_char_) <= '\n') {
+      if (current_char_ == '\n') {
+        ++current_line_;
+        current_col_ = 0;
+      } else if (utf8::IsContinuation(current_char_)) {
+        // Columns count code points, continuation bytes do not start one.
+        --current_col_;
+      }
     }
   } else {
     current_char_ = EOF;
@@ -158,48 +196,117 @@ Token TokenLoader::CharSplit(const int line, const int col) {
                  "empty character constant");
   }
 
-  char n = current_char_;
+  uint32_t code_point = static_cast<unsigned char>(current_char_);
   if (current_char_ == '\\') {
     GetNextChar();
     if (current_char_ == 'n') {
-      n = '\n';
+      code_point = '\n';
+      GetNextChar();
     } else if (current_char_ == '\\') {
-      n = '\\';
+      code_point = '\\';
+      GetNextChar();
+    } else if (current_char_ == 'u') {
+      if (!UnicodeEscape(&code_point)) {
+        return Token(TokenType::kTokenUnknown, line, col,
+                     "invalid \\u escape sequence");
+      }
     } else {
       return Token(TokenType::kTokenUnknown, line, col,
                    "gettok: unknown escape sequence \\" + current_char_);
     }
+  } else if (code_point >= 0x80) {
+    if (!Utf8Sequence(&code_point)) {
+      return Token(TokenType::kTokenUnknown, line, col,
+                   "invalid UTF-8 in character constant");
+    }
+  } else {
+    GetNextChar();
   }
 
-  GetNextChar();
   if (current_char_ != '\'') {
     return Token(TokenType::kTokenUnknown, line, col,
                  "multi-character constant");
   }
+  // A character constant is a single byte.
+  if (code_point >= 0x80) {
+    return Token(TokenType::kTokenUnknown, line, col,
+                 "character constant out of range");
+  }
   GetNextChar();
-  return Token{TokenType::kTokenValueChar, line, col, {n}};
+  return Token{TokenType::kTokenValueChar, line, col,
+               {static_cast<char>(code_point)}};
 }
 
 Token TokenLoader::StringSplit(const int line, const int col) {
   std::string str;
-  while (true) {
-    GetNextChar();
-    if (current_char_ == '"') {
-      break;
-    }
+  GetNextChar();
+  while (current_char_ != '"') {
     if (current_char_ == '\n') {
       GetNextChar();
       return Token(TokenType::kTokenUnknown, line, col, "EOL in string");
     } else if (current_char_ == EOF) {
       return Token(TokenType::kTokenUnknown, line, col, "EOF in string");
+    } else if (current_char_ == '\\') {
+      GetNextChar();
+      if (current_char_ == 'u') {
+        uint32_t code_point;
+        if (!UnicodeEscape(&code_point)) {
+          return Token(TokenType::kTokenUnknown, line, col,
+                       "invalid \\u escape sequence");
+        }
+        utf8::Append(code_point, &str);
+        continue;
+      }
+      // Other escapes stay as they are written, the escaped character
+      // included, so that "\\u" is not taken for a \u escape.
+      str += '\\';
+      if (current_char_ == '\n' || current_char_ == EOF) {
+        continue;
+      }
     }
     str += current_char_;
+    GetNextChar();
   }
 
+  if (!utf8::Validate(str.data(), str.size())) {
+    GetNextChar();
+    return Token(TokenType::kTokenUnknown, line, col,
+                 "invalid UTF-8 in string");
+  }
   GetNextChar();
   return Token(TokenType::kTokenValueString, line, col, str);
 }
 
+bool TokenLoader::UnicodeEscape(uint32_t* const code_point) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    GetNextChar();
+    if (!isxdigit(static_cast<unsigned char>(current_char_))) {
+      return false;
+    }
+    const char c = static_cast<char>(tolower(current_char_));
+    value = (value << 4) |
+            static_cast<uint32_t>(isdigit(c) ? c - '0' : c - 'a' + 10);
+  }
+  GetNextChar();
+  if (value >= utf8::kSurrogateFirst && value <= utf8::kSurrogateLast) {
+    return false;
+  }
+  *code_point = value;
+  return true;
+}
+
+bool TokenLoader::Utf8Sequence(uint32_t* const code_point) {
+  char bytes[4] = {current_char_};
+  const size_t length = utf8::SequenceLength(current_char_);
+  for (size_t i = 1; i < length; ++i) {
+    GetNextChar();
+    bytes[i] = current_char_;
+  }
+  GetNextChar();
+  return length > 0 && utf8::Decode(bytes, length, code_point) == length;
+}
+
 Token TokenLoader::IndentifierOrValue(const int line, const int col) {
   bool is_number = true;
   int count_of_point = 0;
@@ -246,8 +353,7 @@ Token TokenLoader::IndentifierOrValue(const int line, const int col) {
 }
 
 TokenType TokenLoader::GetIdentifierType(const std::string& text) {
-  return kReservedKeywords.count(text) > 0 ? kReservedKeywords.at(text)
-                                           : TokenType::kTokenIdentifier;
+  return KeywordType(text.data(), text.size());
 }
 
 Token TokenLoader::Follow(const char expect, const TokenType is_yes_token,
@@ -23,6 +23,7 @@
 #ifndef LEX_TOKEN_LOADER_H_
 #define LEX_TOKEN_LOADER_H_
 
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -34,7 +35,10 @@ namespace lex {
 
 class TokenLoader {
  public:
-  explicit TokenLoader(std::basic_istream<char>* const stream);
+  /// @brief Lex `stream`, numbering its lines from `first_line` so that
+  /// input fed in pieces keeps its positions.
+  explicit TokenLoader(std::basic_istream<char>* const stream,
+                       const int first_line = 1);
 
   /// @brief Get next token.
   Token GetToken();
@@ -48,6 +52,12 @@ class TokenLoader {
   Token DivisionOrComment(const int line, const int col);
   Token CharSplit(const int line, const int col);
   Token StringSplit(const int line, const int col);
+  /// @brief Reads the four hex digits of a `\u` escape, the current character
+  /// being the `u`, and moves past them.
+  bool UnicodeEscape(uint32_t* const code_point);
+  /// @brief Reads the UTF-8 sequence starting at the current character and
+  /// moves past it.
+  bool Utf8Sequence(uint32_t* const code_point);
   Token IndentifierOrValue(const int line, const int col);
   TokenType GetIdentifierType(const std::string& text);
   Token Follow(const char next, const TokenType is_yes_token,
@@ -22,100 +22,132 @@
 
 #include "lex/types.h"
 
+#include <cstring>
 #include <iomanip>
-#include <map>
-#include <unordered_map>
 
 namespace elsh {
 namespace lex {
+namespace {
 
-const std::unordered_map<TokenType, std::string, EnumClassHash> kTokenNames{
-    {TokenType::kTokenEOI, "End_of_input"},
-    {TokenType::kTokenUnknown, "Unknown_token"},
+// Token types are numbered in groups of a hundred, names are looked up by
+// group and position within it. Both tables are constant initialized, unused
+// slots are null.
+constexpr size_t kNumTypeGroups = 6;
+constexpr size_t kMaxTypesPerGroup = 16;
+
+constexpr const char* kTokenNames[kNumTypeGroups][kMaxTypesPerGroup] = {
+    {"Unknown_token", "End_of_input"},
     // Operators
-    {TokenType::kTokenOpMul, "Op_multiply"},
-    {TokenType::kTokenOpDiv, "Op_divide"},
-    {TokenType::kTokenOpMod, "Op_mod"},
-    {TokenType::kTokenOpAdd, "Op_add"},
-    {TokenType::kTokenOpSub, "Op_subtract"},
-    {TokenType::kTokenOpNegate, "Op_negate"},
-    {TokenType::kTokenOpNot, "Op_not"},
-    {TokenType::kTokenOpLss, "Op_less"},
-    {TokenType::kTokenOpLeq, "Op_lessequal"},
-    {TokenType::kTokenOpGtr, "Op_greater"},
-    {TokenType::kTokenOpGeq, "Op_greaterequal"},
-    {TokenType::kTokenOpEq, "Op_equal"},
-    {TokenType::kTokenOpNeq, "Op_notequal"},
-    {TokenType::kTokenOpAssign, "Op_assign"},
-    {TokenType::kTokenOpAnd, "Op_and"},
-    {TokenType::kTokenOpOr, "Op_or"},
+    {"Op_multiply", "Op_divide", "Op_mod", "Op_add", "Op_subtract",
+     "Op_negate", "Op_not", "Op_less", "Op_lessequal", "Op_greater",
+     "Op_greaterequal", "Op_equal", "Op_notequal", "Op_assign", "Op_and",
+     "Op_or"},
     // Reserved Keywords
-    {TokenType::kTokenKwIf, "Keyword_if"},
-    {TokenType::kTokenKwElse, "Keyword_else"},
-    {TokenType::kTokenKwWhile, "Keyword_while"},
-    {TokenType::kTokenKwBreak, "Keyword_break"},
-    {TokenType::kTokenKwContinue, "Keyword_continue"},
-    {TokenType::kTokenKwDo, "Keyword_do"},
-    {TokenType::kTokenKwFor, "Keyword_for"},
-    {TokenType::kTokenKwPrint, "Keyword_print"},
-    {TokenType::kTokenKwPutc, "Keyword_putc"},
-    {TokenType::kTokenKwReturn, "Keyword_return"},
-    {TokenType::kTokenKwConst, "Keyword_const"},
+    {"Keyword_if", "Keyword_else", "Keyword_while", "Keyword_break",
+     "Keyword_continue", "Keyword_do", "Keyword_for", "Keyword_print",
+     "Keyword_putc", "Keyword_return", "Keyword_const", "Keyword_parallel"},
     // Symbols
-    {TokenType::kTokenSymLparen, "Symbol_LeftParen"},
-    {TokenType::kTokenSymRparen, "Symbol_RightParen"},
-    {TokenType::kTokenSymLbrace, "Symbol_LeftBrace"},
-    {TokenType::kTokenSymRbrace, "Symbol_RightBrace"},
-    {TokenType::kTokenSymLbracket, "Symbol_LeftBracket"},
-    {TokenType::kTokenSymRbracket, "Symbol_RightBracket"},
-    {TokenType::kTokenSymSemiColon, "Symbol_Semicolon"},
-    {TokenType::kTokenSymComma, "Symbol_Comma"},
-    // Data types
-    {TokenType::kTokenDtInt32, "Type_int32"},
-    {TokenType::kTokenDtInt64, "Type_int64"},
-    {TokenType::kTokenDtUint32, "Type_uint32"},
-    {TokenType::kTokenDtUint64, "Type_uint64"},
-    {TokenType::kTokenDtDouble, "Type_double"},
-    {TokenType::kTokenDtChar, "Type_char"},
-    {TokenType::kTokenDtVoid, "Type_void"},
-    {TokenType::kTokenDtBool, "Type_bool"},
-    {TokenType::kTokenDtString, "Type_string"},
-
-    {TokenType::kTokenIdentifier, "Identifier"},
-    {TokenType::kTokenValueInt, "Value_int"},
-    {TokenType::kTokenValueDouble, "Value_double"},
-    {TokenType::kTokenValueChar, "Value_char"},
-    {TokenType::kTokenValueString, "Value_string"},
-    {TokenType::kTokenValueBool, "Value_bool"}};
-
-const std::unordered_map<std::string, TokenType> kReservedKeywords{
-    {"if", TokenType::kTokenKwIf},
-    {"else", TokenType::kTokenKwElse},
-    {"while", TokenType::kTokenKwWhile},
+    {"Symbol_LeftParen", "Symbol_RightParen", "Symbol_LeftBrace",
+     "Symbol_RightBrace", "Symbol_LeftBracket", "Symbol_RightBracket",
+     "Symbol_Semicolon", "Symbol_Comma"},
+    // Data types, 406 is not used.
+    {"Type_int32", "Type_int64", "Type_uint32", "Type_uint64", "Type_double",
+     "Type_char", nullptr, "Type_void", "Type_bool", "Type_string"},
+    // Others
+    {"Identifier", "Value_int", "Value_double", "Value_char", "Value_string",
+     "Value_bool"}};
+
+struct Keyword {
+  const char* text;
+  TokenType type;
+};
+
+// Sorted by text for the binary search in `KeywordType`.
+constexpr Keyword kKeywords[] = {
+    {"bool", TokenType::kTokenDtBool},
     {"break", TokenType::kTokenKwBreak},
+    {"char", TokenType::kTokenDtChar},
+    {"const", TokenType::kTokenKwConst},
     {"continue", TokenType::kTokenKwContinue},
     {"do", TokenType::kTokenKwDo},
+    {"double", TokenType::kTokenDtDouble},
+    {"else", TokenType::kTokenKwElse},
+    {"false", TokenType::kTokenValueBool},
     {"for", TokenType::kTokenKwFor},
+    {"if", TokenType::kTokenKwIf},
+    {"int", TokenType::kTokenDtInt32},
+    {"int32", TokenType::kTokenDtInt32},
+    {"int64", TokenType::kTokenDtInt64},
+    {"parallel", TokenType::kTokenKwParallel},
     {"print", TokenType::kTokenKwPrint},
     {"putc", TokenType::kTokenKwPutc},
     {"return", TokenType::kTokenKwReturn},
-    {"const", TokenType::kTokenKwConst},
+    {"string", TokenType::kTokenDtString},
     {"true", TokenType::kTokenValueBool},
-    {"false", TokenType::kTokenValueBool},
-    {"int", TokenType::kTokenDtInt32},
-    {"int32", TokenType::kTokenDtInt32},
-    {"int64", TokenType::kTokenDtInt64},
     {"uint32", TokenType::kTokenDtUint32},
     {"uint64", TokenType::kTokenDtUint64},
-    {"double", TokenType::kTokenDtDouble},
-    {"char", TokenType::kTokenDtChar},
     {"void", TokenType::kTokenDtVoid},
-    {"bool", TokenType::kTokenDtBool},
-    {"string", TokenType::kTokenDtString}};
+    {"while", TokenType::kTokenKwWhile}};
+
+constexpr size_t kNumKeywords = sizeof(kKeywords) / sizeof(kKeywords[0]);
+
+constexpr int CompareText(const char* const a, const char* const b) {
+  return *a != *b ? (*a < *b ? -1 : 1)
+                  : (*a == '\0' ? 0 : CompareText(a + 1, b + 1));
+}
+
+constexpr bool IsSorted(const Keyword* const keywords, const size_t size) {
+  return size < 2 || (CompareText(keywords[0].text, keywords[1].text) < 0 &&
+                      IsSorted(keywords + 1, size - 1));
+}
+
+static_assert(IsSorted(kKeywords, kNumKeywords),
+              "kKeywords must be sorted by text");
+
+}  // namespace
+
+const char* TokenName(const TokenType type) {
+  const size_t value = static_cast<size_t>(type);
+  const size_t group = value / 100;
+  const size_t index = value % 100;
+  const char* const name = group < kNumTypeGroups && index < kMaxTypesPerGroup
+                               ? kTokenNames[group][index]
+                               : nullptr;
+  return name != nullptr ? name : kTokenNames[0][0];
+}
+
+bool IsTokenType(const uint16_t value) {
+  const size_t group = value / 100;
+  const size_t index = value % 100;
+  return group < kNumTypeGroups && index < kMaxTypesPerGroup &&
+         kTokenNames[group][index] != nullptr;
+}
+
+TokenType KeywordType(const char* const text, const size_t size) {
+  size_t low = 0;
+  size_t high = kNumKeywords;
+  while (low < high) {
+    const size_t middle = (low + high) / 2;
+    const char* const keyword = kKeywords[middle].text;
+    int order = strncmp(keyword, text, size);
+    if (order == 0 && keyword[size] != '\0') {
+      // `text` is a proper prefix of the keyword.
+      order = 1;
+    }
+    if (order == 0) {
+      return kKeywords[middle].type;
+    } else if (order < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return TokenType::kTokenIdentifier;
+}
 
 std::ostream& operator<<(std::ostream& os, const Token& token) {
   os << std::setw(6) << token.err_ln << ": " << std::setw(3) << token.err_col
-     << std::setw(25) << kTokenNames.at(token.tok_type);
+     << std::setw(25) << TokenName(token.tok_type);
   switch (token.tok_type) {
     case TokenType::kTokenValueInt:
       os << std::setw(12) << token.value_int;
@@ -23,11 +23,11 @@
 #ifndef LEX_TYPES_H_
 #define LEX_TYPES_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
-#include <map>
 #include <memory>
 #include <string>
-#include <unordered_map>
 
 namespace elsh {
 namespace lex {
@@ -66,6 +66,7 @@ enum class TokenType : uint16_t {
   kTokenKwPutc = 208,
   kTokenKwReturn = 209,
   kTokenKwConst = 210,
+  kTokenKwParallel = 211,
 
   // Symbols
   kTokenSymLparen = 300,
@@ -97,18 +98,18 @@ enum class TokenType : uint16_t {
   kTokenValueBool = 505,
 };
 
-// Enum class can not be use as `unordered_map` key in c++11, so we define our
-// own hash function for enum classes.
-struct EnumClassHash {
-  template <typename T>
-  std::size_t operator()(const T& t) const {
-    return static_cast<std::size_t>(t);
-  }
-};
+/// @brief Name of `type` in token listings, "Unknown_token" for values that
+/// are not a `TokenType`. Names live in a constant table indexed by the
+/// hundreds and the units of the type, nothing is built at startup.
+const char* TokenName(const TokenType type);
+
+/// @brief Whether `value` is one of the `TokenType` values, for types read
+/// back from files.
+bool IsTokenType(const uint16_t value);
 
-extern const std::unordered_map<TokenType, std::string, EnumClassHash>
-    kTokenNames;
-extern const std::unordered_map<std::string, TokenType> kReservedKeywords;
+/// @brief Type of the reserved word `text`, `kTokenIdentifier` if it is not
+/// one.
+TokenType KeywordType(const char* const text, const size_t size);
 
 struct Token {
   Token() = default;
@@ -0,0 +1,234 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "lex/utf8.h"
+
+#include <cstring>
+
+#include "lex/simd_targets.h"
+
+namespace elsh {
+namespace lex {
+namespace utf8 {
+namespace {
+
+using AsciiPrefixFunc = size_t (*)(const char* const, const size_t);
+
+// Scalar scan, eight bytes per step through a 64 bit word.
+size_t AsciiPrefixScalar(const char* const data, const size_t size) {
+  constexpr uint64_t kHighBits = 0x8080808080808080ull;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, sizeof(word));
+    if ((word & kHighBits) != 0) {
+      break;
+    }
+  }
+  while (i < size && (static_cast<unsigned char>(data[i]) & 0x80) == 0) {
+    ++i;
+  }
+  return i;
+}
+
+#ifdef ELSH_X86_KERNELS
+
+// The sign bit of every byte is its high bit, movemask collects them.
+
+ELSH_TARGET_SSE2 size_t AsciiPrefixSse2(const char* const data,
+                                        const size_t size) {
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    const int mask = _mm_movemask_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + AsciiPrefixScalar(data + i, size - i);
+}
+
+ELSH_TARGET_AVX2 size_t AsciiPrefixAvx2(const char* const data,
+                                        const size_t size) {
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i))));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + AsciiPrefixSse2(data + i, size - i);
+}
+
+#endif  // ELSH_X86_KERNELS
+
+AsciiPrefixFunc GetAsciiPrefix(const Kernel kernel) {
+#ifdef ELSH_X86_KERNELS
+  if (static_cast<uint8_t>(kernel) <= static_cast<uint8_t>(DetectKernel())) {
+    if (kernel == Kernel::kAvx2) {
+      return AsciiPrefixAvx2;
+    } else if (kernel == Kernel::kSse2) {
+      return AsciiPrefixSse2;
+    }
+  }
+#endif
+  return AsciiPrefixScalar;
+}
+
+}  // namespace
+
+Kernel DetectKernel() {
+#ifdef ELSH_X86_KERNELS
+  static const Kernel kDetected =
+      __builtin_cpu_supports("avx2")
+          ? Kernel::kAvx2
+          : (__builtin_cpu_supports("sse2") ? Kernel::kSse2 : Kernel::kScalar);
+  return kDetected;
+#else
+  return Kernel::kScalar;
+#endif
+}
+
+const char* KernelName(const Kernel kernel) {
+  switch (kernel) {
+    case Kernel::kAvx2:
+      return "avx2";
+    case Kernel::kSse2:
+      return "sse2";
+    default:
+      return "scalar";
+  }
+}
+
+size_t SequenceLength(const char lead) {
+  const unsigned char c = static_cast<unsigned char>(lead);
+  if (c < 0x80) {
+    return 1;
+  } else if (c >= 0xC2 && c <= 0xDF) {
+    return 2;
+  } else if (c >= 0xE0 && c <= 0xEF) {
+    return 3;
+  } else if (c >= 0xF0 && c <= 0xF4) {
+    return 4;
+  }
+  // Continuation bytes, the overlong leads 0xC0 and 0xC1, and 0xF5 and above.
+  return 0;
+}
+
+size_t AsciiPrefix(const char* const data, const size_t size,
+                   const Kernel kernel) {
+  return GetAsciiPrefix(kernel)(data, size);
+}
+
+size_t AsciiPrefix(const char* const data, const size_t size) {
+  return AsciiPrefix(data, size, DetectKernel());
+}
+
+size_t Decode(const char* const data, const size_t size,
+              uint32_t* const code_point) {
+  // Smallest code point of a sequence of each length, anything below is an
+  // overlong encoding.
+  static const uint32_t kMinCodePoint[] = {0, 0, 0x80, 0x800, 0x10000};
+
+  if (size == 0) {
+    return 0;
+  }
+  const size_t length = SequenceLength(data[0]);
+  if (length == 0 || length > size) {
+    return 0;
+  }
+  if (length == 1) {
+    *code_point = static_cast<unsigned char>(data[0]);
+    return 1;
+  }
+
+  uint32_t value = static_cast<unsigned char>(data[0]) & (0x7F >> length);
+  for (size_t i = 1; i < length; ++i) {
+    if (!IsContinuation(data[i])) {
+      return 0;
+    }
+    value = (value << 6) | (static_cast<unsigned char>(data[i]) & 0x3F);
+  }
+  if (value < kMinCodePoint[length] || value > kMaxCodePoint ||
+      (value >= kSurrogateFirst && value <= kSurrogateLast)) {
+    return 0;
+  }
+  *code_point = value;
+  return length;
+}
+
+bool Append(const uint32_t code_point, std::string* const out) {
+  if (code_point > kMaxCodePoint ||
+      (code_point >= kSurrogateFirst && code_point <= kSurrogateLast)) {
+    return false;
+  }
+  if (code_point < 0x80) {
+    out->push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    out->push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else if (code_point < 0x10000) {
+    out->push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else {
+    out->push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  }
+  return true;
+}
+
+bool Validate(const char* const data, const size_t size, const Kernel kernel,
+              size_t* const error_offset) {
+  const AsciiPrefixFunc ascii_prefix = GetAsciiPrefix(kernel);
+  size_t i = 0;
+  for (;;) {
+    i += ascii_prefix(data + i, size - i);
+    if (i == size) {
+      return true;
+    }
+    // Decode the whole non-ASCII run before going back to the vector scan.
+    do {
+      uint32_t code_point;
+      const size_t length = Decode(data + i, size - i, &code_point);
+      if (length == 0) {
+        if (error_offset != nullptr) {
+          *error_offset = i;
+        }
+        return false;
+      }
+      i += length;
+    } while (i < size && (static_cast<unsigned char>(data[i]) & 0x80) != 0);
+  }
+}
+
+bool Validate(const char* const data, const size_t size,
+              size_t* const error_offset) {
+  return Validate(data, size, DetectKernel(), error_offset);
+}
+
+}  // namespace utf8
+}  // namespace lex
+}  // namespace elsh
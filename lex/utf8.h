@@ -0,0 +1,95 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef LEX_UTF8_H_
+#define LEX_UTF8_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace elsh {
+namespace lex {
+
+/// @brief UTF-8 helpers for the literals of the lexer.
+///
+/// Validation skips runs of ASCII bytes with SSE2 or AVX2 compares, 16 or 32
+/// bytes per step, and only decodes the multi-byte sequences one by one. Pure
+/// ASCII text therefore never leaves the vector loop.
+namespace utf8 {
+
+/// @brief Instruction sets the ASCII scan is built for.
+enum class Kernel : uint8_t {
+  kScalar = 0,
+  kSse2 = 1,
+  kAvx2 = 2,
+};
+
+/// @brief Largest code point, and the surrogate range which is not encodable.
+constexpr uint32_t kMaxCodePoint = 0x10FFFF;
+constexpr uint32_t kSurrogateFirst = 0xD800;
+constexpr uint32_t kSurrogateLast = 0xDFFF;
+
+/// @brief Best kernel the running cpu supports, detected once.
+Kernel DetectKernel();
+const char* KernelName(const Kernel kernel);
+
+/// @brief True for the bytes 10xxxxxx, which do not start a code point.
+inline bool IsContinuation(const char c) {
+  return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+/// @brief Length of the sequence a lead byte starts, 0 if `lead` can not
+/// start one.
+size_t SequenceLength(const char lead);
+
+/// @brief Number of leading ASCII bytes of `data`, with `kernel`, falling back
+/// to scalar code if the cpu does not support it.
+size_t AsciiPrefix(const char* const data, const size_t size,
+                   const Kernel kernel);
+size_t AsciiPrefix(const char* const data, const size_t size);
+
+/// @brief Decodes the sequence at the start of `data` to `code_point`.
+/// @return Its length in bytes, 0 if it is truncated, overlong, a surrogate or
+/// beyond `kMaxCodePoint`.
+size_t Decode(const char* const data, const size_t size,
+              uint32_t* const code_point);
+
+/// @brief Appends the encoding of `code_point` to `out`.
+/// @return False, appending nothing, for surrogates and values beyond
+/// `kMaxCodePoint`.
+bool Append(const uint32_t code_point, std::string* const out);
+
+/// @brief Whether `data` is well-formed UTF-8.
+/// @param error_offset If not null, receives the offset of the first invalid
+/// sequence on failure.
+bool Validate(const char* const data, const size_t size, const Kernel kernel,
+              size_t* const error_offset = nullptr);
+bool Validate(const char* const data, const size_t size,
+              size_t* const error_offset = nullptr);
+
+}  // namespace utf8
+
+}  // namespace lex
+}  // namespace elsh
+
+#endif  // LEX_UTF8_H_
@@ -0,0 +1,196 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Replacement global allocation functions feeding `AllocationCount`,
+// `AllocatedBytes` and `ThreadLiveBytes`. Every object that allocates
+// references `operator new`, so every binary linking the runtime library
+// pulls this object in and has all of its allocations counted.
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "runtime/stats.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+// Counters of one thread. Only the owning thread writes them, with a relaxed
+// load and store rather than a read-modify-write, so an allocation costs no
+// locked instruction; readers sum the counters of every live thread.
+struct ThreadCounts {
+  ThreadCounts();
+  ~ThreadCounts();
+
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> bytes{0};
+  ThreadCounts* prev = nullptr;
+  ThreadCounts* next = nullptr;
+};
+
+// Guards the list of live threads and the totals of the exited ones.
+// `std::mutex` is constant initialized, so it is usable from allocations made
+// during static initialization.
+std::mutex g_threads_mutex;
+ThreadCounts* g_threads = nullptr;
+uint64_t g_exited_allocations = 0;
+uint64_t g_exited_bytes = 0;
+
+thread_local ThreadCounts g_thread_counts;
+thread_local int64_t g_thread_live_bytes = 0;
+
+ThreadCounts::ThreadCounts() {
+  std::lock_guard<std::mutex> lock(g_threads_mutex);
+  next = g_threads;
+  if (next != nullptr) {
+    next->prev = this;
+  }
+  g_threads = this;
+}
+
+ThreadCounts::~ThreadCounts() {
+  std::lock_guard<std::mutex> lock(g_threads_mutex);
+  g_exited_allocations += allocations.load(std::memory_order_relaxed);
+  g_exited_bytes += bytes.load(std::memory_order_relaxed);
+  if (prev != nullptr) {
+    prev->next = next;
+  } else {
+    g_threads = next;
+  }
+  if (next != nullptr) {
+    next->prev = prev;
+  }
+}
+
+void Add(std::atomic<uint64_t>* const counter, const uint64_t value) {
+  counter->store(counter->load(std::memory_order_relaxed) + value,
+                 std::memory_order_relaxed);
+}
+
+// Size of the block behind `ptr`. Only glibc can tell, elsewhere
+// `ThreadLiveBytes` stays 0.
+std::size_t BlockSize(void* const ptr) {
+#ifdef __GLIBC__
+  return malloc_usable_size(ptr);
+#else
+  (void)ptr;
+  return 0;
+#endif
+}
+
+void* CountedAllocate(const std::size_t size) {
+  void* const ptr = std::malloc(size == 0 ? 1 : size);
+  if (ptr != nullptr) {
+    ThreadCounts& counts = g_thread_counts;
+    Add(&counts.allocations, 1);
+    Add(&counts.bytes, size);
+    g_thread_live_bytes += BlockSize(ptr);
+  }
+  return ptr;
+}
+
+// Retries through the installed new handler like the standard `operator new`.
+void* CountedAllocateOrThrow(const std::size_t size) {
+  for (;;) {
+    void* const ptr = CountedAllocate(size);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+    const std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+
+void* CountedAllocateNoThrow(const std::size_t size) noexcept {
+  try {
+    return CountedAllocateOrThrow(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void CountedFree(void* const ptr) {
+  g_thread_live_bytes -= BlockSize(ptr);
+  std::free(ptr);
+}
+}  // namespace
+
+uint64_t AllocationCount() {
+  std::lock_guard<std::mutex> lock(g_threads_mutex);
+  uint64_t total = g_exited_allocations;
+  for (const ThreadCounts* t = g_threads; t != nullptr; t = t->next) {
+    total += t->allocations.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+uint64_t AllocatedBytes() {
+  std::lock_guard<std::mutex> lock(g_threads_mutex);
+  uint64_t total = g_exited_bytes;
+  for (const ThreadCounts* t = g_threads; t != nullptr; t = t->next) {
+    total += t->bytes.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+int64_t ThreadLiveBytes() { return g_thread_live_bytes; }
+
+}  // namespace runtime
+}  // namespace elsh
+
+void* operator new(std::size_t size) {
+  return elsh::runtime::CountedAllocateOrThrow(size);
+}
+
+void* operator new[](std::size_t size) {
+  return elsh::runtime::CountedAllocateOrThrow(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return elsh::runtime::CountedAllocateNoThrow(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return elsh::runtime::CountedAllocateNoThrow(size);
+}
+
+void operator delete(void* ptr) noexcept { elsh::runtime::CountedFree(ptr); }
+
+void operator delete[](void* ptr) noexcept {
+  elsh::runtime::CountedFree(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  elsh::runtime::CountedFree(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  elsh::runtime::CountedFree(ptr);
+}
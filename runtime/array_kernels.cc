@@ -0,0 +1,667 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/array_kernels.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "lex/simd_targets.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+// Scalar kernels, used as they are on other architectures and for the tails
+// of the vectorized ones.
+
+template <typename T>
+void FillScalar(T* const out, const size_t size, const T value) {
+  std::fill(out, out + size, value);
+}
+
+template <typename Sum, typename T>
+Sum SumScalar(const T* const in, const size_t size) {
+  Sum sum = 0;
+  for (size_t i = 0; i < size; ++i) {
+    sum += in[i];
+  }
+  return sum;
+}
+
+// Smaller and larger of two values, a NaN in either wins. `value != value`
+// only holds for NaN and folds away for integers.
+template <typename T>
+T MinOf(const T min, const T value) {
+  return value < min || value != value ? value : min;
+}
+
+template <typename T>
+T MaxOf(const T max, const T value) {
+  return value > max || value != value ? value : max;
+}
+
+template <typename T>
+T MinScalar(const T* const in, const size_t size) {
+  T min = in[0];
+  for (size_t i = 1; i < size; ++i) {
+    min = MinOf(min, in[i]);
+  }
+  return min;
+}
+
+template <typename T>
+T MaxScalar(const T* const in, const size_t size) {
+  T max = in[0];
+  for (size_t i = 1; i < size; ++i) {
+    max = MaxOf(max, in[i]);
+  }
+  return max;
+}
+
+void AddInt32Scalar(const int32_t* const a, const int32_t* const b,
+                    int32_t* const out, const size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    out[i] = static_cast<int32_t>(static_cast<uint32_t>(a[i]) +
+                                  static_cast<uint32_t>(b[i]));
+  }
+}
+
+void MulInt32Scalar(const int32_t* const a, const int32_t* const b,
+                    int32_t* const out, const size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    out[i] = static_cast<int32_t>(static_cast<uint32_t>(a[i]) *
+                                  static_cast<uint32_t>(b[i]));
+  }
+}
+
+int64_t DotInt32Scalar(const int32_t* const a, const int32_t* const b,
+                       const size_t size) {
+  int64_t dot = 0;
+  for (size_t i = 0; i < size; ++i) {
+    dot += static_cast<int64_t>(a[i]) * b[i];
+  }
+  return dot;
+}
+
+void AddDoubleScalar(const double* const a, const double* const b,
+                     double* const out, const size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    out[i] = a[i] + b[i];
+  }
+}
+
+void MulDoubleScalar(const double* const a, const double* const b,
+                     double* const out, const size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    out[i] = a[i] * b[i];
+  }
+}
+
+double DotDoubleScalar(const double* const a, const double* const b,
+                       const size_t size) {
+  double dot = 0.;
+  for (size_t i = 0; i < size; ++i) {
+    dot += a[i] * b[i];
+  }
+  return dot;
+}
+
+const ArrayKernels kScalarKernels = {
+    FillScalar<int32_t>,
+    SumScalar<int64_t, int32_t>,
+    MinScalar<int32_t>,
+    MaxScalar<int32_t>,
+    AddInt32Scalar,
+    MulInt32Scalar,
+    DotInt32Scalar,
+    FillScalar<double>,
+    SumScalar<double, double>,
+    MinScalar<double>,
+    MaxScalar<double>,
+    AddDoubleScalar,
+    MulDoubleScalar,
+    DotDoubleScalar};
+
+#ifdef ELSH_X86_KERNELS
+
+// SSE2, 4 x int32 or 2 x double per instruction.
+
+ELSH_TARGET_SSE2 void FillInt32Sse2(int32_t* const out, const size_t size,
+                                    const int32_t value) {
+  const __m128i v = _mm_set1_epi32(value);
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+  }
+  FillScalar(out + i, size - i, value);
+}
+
+ELSH_TARGET_SSE2 int64_t SumInt32Sse2(const int32_t* const in,
+                                      const size_t size) {
+  __m128i sum = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    // Sign extend to 64 bits by interleaving with the sign bits.
+    const __m128i sign = _mm_srai_epi32(v, 31);
+    sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(v, sign));
+    sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(v, sign));
+  }
+  int64_t lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sum);
+  return lanes[0] + lanes[1] + SumScalar<int64_t>(in + i, size - i);
+}
+
+// SSE2 has no pminsd/pmaxsd, select with a compare mask instead.
+ELSH_TARGET_SSE2 __m128i SelectInt32Sse2(const __m128i mask, const __m128i a,
+                                         const __m128i b) {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+ELSH_TARGET_SSE2 int32_t MinInt32Sse2(const int32_t* const in,
+                                      const size_t size) {
+  if (size < 4) {
+    return MinScalar(in, size);
+  }
+  __m128i min = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+  size_t i = 4;
+  for (; i + 4 <= size; i += 4) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    min = SelectInt32Sse2(_mm_cmplt_epi32(v, min), v, min);
+  }
+  int32_t lanes[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), min);
+  const int32_t result = MinScalar(lanes, 4);
+  return i < size ? std::min(result, MinScalar(in + i, size - i)) : result;
+}
+
+ELSH_TARGET_SSE2 int32_t MaxInt32Sse2(const int32_t* const in,
+                                      const size_t size) {
+  if (size < 4) {
+    return MaxScalar(in, size);
+  }
+  __m128i max = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+  size_t i = 4;
+  for (; i + 4 <= size; i += 4) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    max = SelectInt32Sse2(_mm_cmpgt_epi32(v, max), v, max);
+  }
+  int32_t lanes[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), max);
+  const int32_t result = MaxScalar(lanes, 4);
+  return i < size ? std::max(result, MaxScalar(in + i, size - i)) : result;
+}
+
+ELSH_TARGET_SSE2 void AddInt32Sse2(const int32_t* const a,
+                                   const int32_t* const b, int32_t* const out,
+                                   const size_t size) {
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_add_epi32(va, vb));
+  }
+  AddInt32Scalar(a + i, b + i, out + i, size - i);
+}
+
+ELSH_TARGET_SSE2 void MulInt32Sse2(const int32_t* const a,
+                                   const int32_t* const b, int32_t* const out,
+                                   const size_t size) {
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    // No pmulld either: multiply even and odd lanes separately and keep the
+    // low halves of the 64 bit products.
+    const __m128i even = _mm_mul_epu32(va, vb);
+    const __m128i odd =
+        _mm_mul_epu32(_mm_srli_si128(va, 4), _mm_srli_si128(vb, 4));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(out + i),
+        _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                           _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))));
+  }
+  MulInt32Scalar(a + i, b + i, out + i, size - i);
+}
+
+ELSH_TARGET_SSE2 void FillDoubleSse2(double* const out, const size_t size,
+                                     const double value) {
+  const __m128d v = _mm_set1_pd(value);
+  size_t i = 0;
+  for (; i + 2 <= size; i += 2) {
+    _mm_storeu_pd(out + i, v);
+  }
+  FillScalar(out + i, size - i, value);
+}
+
+ELSH_TARGET_SSE2 double SumDoubleSse2(const double* const in,
+                                      const size_t size) {
+  // Two accumulators hide the latency of the adds.
+  __m128d sum0 = _mm_setzero_pd();
+  __m128d sum1 = _mm_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    sum0 = _mm_add_pd(sum0, _mm_loadu_pd(in + i));
+    sum1 = _mm_add_pd(sum1, _mm_loadu_pd(in + i + 2));
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, _mm_add_pd(sum0, sum1));
+  return lanes[0] + lanes[1] + SumScalar<double>(in + i, size - i);
+}
+
+ELSH_TARGET_SSE2 double MinDoubleSse2(const double* const in,
+                                      const size_t size) {
+  if (size < 2) {
+    return MinScalar(in, size);
+  }
+  // minpd drops NaNs, they are tracked in a mask of their own.
+  __m128d min = _mm_loadu_pd(in);
+  __m128d nan = _mm_cmpunord_pd(min, min);
+  size_t i = 2;
+  for (; i + 2 <= size; i += 2) {
+    const __m128d v = _mm_loadu_pd(in + i);
+    min = _mm_min_pd(v, min);
+    nan = _mm_or_pd(nan, _mm_cmpunord_pd(v, v));
+  }
+  if (_mm_movemask_pd(nan) != 0) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, min);
+  const double result = MinOf(lanes[0], lanes[1]);
+  return i < size ? MinOf(result, in[i]) : result;
+}
+
+ELSH_TARGET_SSE2 double MaxDoubleSse2(const double* const in,
+                                      const size_t size) {
+  if (size < 2) {
+    return MaxScalar(in, size);
+  }
+  __m128d max = _mm_loadu_pd(in);
+  __m128d nan = _mm_cmpunord_pd(max, max);
+  size_t i = 2;
+  for (; i + 2 <= size; i += 2) {
+    const __m128d v = _mm_loadu_pd(in + i);
+    max = _mm_max_pd(v, max);
+    nan = _mm_or_pd(nan, _mm_cmpunord_pd(v, v));
+  }
+  if (_mm_movemask_pd(nan) != 0) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, max);
+  const double result = MaxOf(lanes[0], lanes[1]);
+  return i < size ? MaxOf(result, in[i]) : result;
+}
+
+ELSH_TARGET_SSE2 void AddDoubleSse2(const double* const a,
+                                    const double* const b, double* const out,
+                                    const size_t size) {
+  size_t i = 0;
+  for (; i + 2 <= size; i += 2) {
+    _mm_storeu_pd(out + i,
+                  _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+  }
+  AddDoubleScalar(a + i, b + i, out + i, size - i);
+}
+
+ELSH_TARGET_SSE2 void MulDoubleSse2(const double* const a,
+                                    const double* const b, double* const out,
+                                    const size_t size) {
+  size_t i = 0;
+  for (; i + 2 <= size; i += 2) {
+    _mm_storeu_pd(out + i,
+                  _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+  }
+  MulDoubleScalar(a + i, b + i, out + i, size - i);
+}
+
+ELSH_TARGET_SSE2 double DotDoubleSse2(const double* const a,
+                                      const double* const b,
+                                      const size_t size) {
+  __m128d dot0 = _mm_setzero_pd();
+  __m128d dot1 = _mm_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    dot0 = _mm_add_pd(dot0,
+                      _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    dot1 = _mm_add_pd(
+        dot1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, _mm_add_pd(dot0, dot1));
+  return lanes[0] + lanes[1] + DotDoubleScalar(a + i, b + i, size - i);
+}
+
+// SSE2 has no signed 32x32->64 multiply, the int32 dot product stays scalar.
+const ArrayKernels kSse2Kernels = {
+    FillInt32Sse2,
+    SumInt32Sse2,
+    MinInt32Sse2,
+    MaxInt32Sse2,
+    AddInt32Sse2,
+    MulInt32Sse2,
+    DotInt32Scalar,
+    FillDoubleSse2,
+    SumDoubleSse2,
+    MinDoubleSse2,
+    MaxDoubleSse2,
+    AddDoubleSse2,
+    MulDoubleSse2,
+    DotDoubleSse2};
+
+// AVX2, 8 x int32 or 4 x double per instruction.
+
+ELSH_TARGET_AVX2 void FillInt32Avx2(int32_t* const out, const size_t size,
+                                    const int32_t value) {
+  const __m256i v = _mm256_set1_epi32(value);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+  }
+  FillScalar(out + i, size - i, value);
+}
+
+ELSH_TARGET_AVX2 int64_t SumInt64LanesAvx2(const __m256i v) {
+  int64_t lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), v);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+ELSH_TARGET_AVX2 int64_t SumInt32Avx2(const int32_t* const in,
+                                      const size_t size) {
+  __m256i sum = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    sum = _mm256_add_epi64(
+        sum, _mm256_cvtepi32_epi64(
+                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+    sum = _mm256_add_epi64(
+        sum, _mm256_cvtepi32_epi64(_mm_loadu_si128(
+                 reinterpret_cast<const __m128i*>(in + i + 4))));
+  }
+  return SumInt64LanesAvx2(sum) + SumScalar<int64_t>(in + i, size - i);
+}
+
+ELSH_TARGET_AVX2 int32_t MinInt32Avx2(const int32_t* const in,
+                                      const size_t size) {
+  if (size < 8) {
+    return MinScalar(in, size);
+  }
+  __m256i min = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+  size_t i = 8;
+  for (; i + 8 <= size; i += 8) {
+    min = _mm256_min_epi32(
+        min, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)));
+  }
+  int32_t lanes[8];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), min);
+  const int32_t result = MinScalar(lanes, 8);
+  return i < size ? std::min(result, MinScalar(in + i, size - i)) : result;
+}
+
+ELSH_TARGET_AVX2 int32_t MaxInt32Avx2(const int32_t* const in,
+                                      const size_t size) {
+  if (size < 8) {
+    return MaxScalar(in, size);
+  }
+  __m256i max = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+  size_t i = 8;
+  for (; i + 8 <= size; i += 8) {
+    max = _mm256_max_epi32(
+        max, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)));
+  }
+  int32_t lanes[8];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), max);
+  const int32_t result = MaxScalar(lanes, 8);
+  return i < size ? std::max(result, MaxScalar(in + i, size - i)) : result;
+}
+
+ELSH_TARGET_AVX2 void AddInt32Avx2(const int32_t* const a,
+                                   const int32_t* const b, int32_t* const out,
+                                   const size_t size) {
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(out + i),
+        _mm256_add_epi32(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i))));
+  }
+  AddInt32Scalar(a + i, b + i, out + i, size - i);
+}
+
+ELSH_TARGET_AVX2 void MulInt32Avx2(const int32_t* const a,
+                                   const int32_t* const b, int32_t* const out,
+                                   const size_t size) {
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(out + i),
+        _mm256_mullo_epi32(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i))));
+  }
+  MulInt32Scalar(a + i, b + i, out + i, size - i);
+}
+
+ELSH_TARGET_AVX2 int64_t DotInt32Avx2(const int32_t* const a,
+                                      const int32_t* const b,
+                                      const size_t size) {
+  __m256i dot = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    const __m256i va =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    const __m256i vb =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    // vpmuldq multiplies the signed even lanes into 64 bit products, shifting
+    // by 32 bits moves the odd lanes there.
+    dot = _mm256_add_epi64(dot, _mm256_mul_epi32(va, vb));
+    dot = _mm256_add_epi64(dot, _mm256_mul_epi32(_mm256_srli_epi64(va, 32),
+                                                 _mm256_srli_epi64(vb, 32)));
+  }
+  return SumInt64LanesAvx2(dot) + DotInt32Scalar(a + i, b + i, size - i);
+}
+
+ELSH_TARGET_AVX2 void FillDoubleAvx2(double* const out, const size_t size,
+                                     const double value) {
+  const __m256d v = _mm256_set1_pd(value);
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    _mm256_storeu_pd(out + i, v);
+  }
+  FillScalar(out + i, size - i, value);
+}
+
+ELSH_TARGET_AVX2 double SumDoubleLanesAvx2(const __m256d v) {
+  double lanes[4];
+  _mm256_storeu_pd(lanes, v);
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+ELSH_TARGET_AVX2 double SumDoubleAvx2(const double* const in,
+                                      const size_t size) {
+  __m256d sum0 = _mm256_setzero_pd();
+  __m256d sum1 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    sum0 = _mm256_add_pd(sum0, _mm256_loadu_pd(in + i));
+    sum1 = _mm256_add_pd(sum1, _mm256_loadu_pd(in + i + 4));
+  }
+  return SumDoubleLanesAvx2(_mm256_add_pd(sum0, sum1)) +
+         SumScalar<double>(in + i, size - i);
+}
+
+ELSH_TARGET_AVX2 double MinDoubleAvx2(const double* const in,
+                                      const size_t size) {
+  if (size < 4) {
+    return MinScalar(in, size);
+  }
+  // vminpd drops NaNs, they are tracked in a mask of their own.
+  __m256d min = _mm256_loadu_pd(in);
+  __m256d nan = _mm256_cmp_pd(min, min, _CMP_UNORD_Q);
+  size_t i = 4;
+  for (; i + 4 <= size; i += 4) {
+    const __m256d v = _mm256_loadu_pd(in + i);
+    min = _mm256_min_pd(v, min);
+    nan = _mm256_or_pd(nan, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+  }
+  if (_mm256_movemask_pd(nan) != 0) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, min);
+  const double result = MinScalar(lanes, 4);
+  return i < size ? MinOf(result, MinScalar(in + i, size - i)) : result;
+}
+
+ELSH_TARGET_AVX2 double MaxDoubleAvx2(const double* const in,
+                                      const size_t size) {
+  if (size < 4) {
+    return MaxScalar(in, size);
+  }
+  __m256d max = _mm256_loadu_pd(in);
+  __m256d nan = _mm256_cmp_pd(max, max, _CMP_UNORD_Q);
+  size_t i = 4;
+  for (; i + 4 <= size; i += 4) {
+    const __m256d v = _mm256_loadu_pd(in + i);
+    max = _mm256_max_pd(v, max);
+    nan = _mm256_or_pd(nan, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+  }
+  if (_mm256_movemask_pd(nan) != 0) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, max);
+  const double result = MaxScalar(lanes, 4);
+  return i < size ? MaxOf(result, MaxScalar(in + i, size - i)) : result;
+}
+
+ELSH_TARGET_AVX2 void AddDoubleAvx2(const double* const a,
+                                    const double* const b, double* const out,
+                                    const size_t size) {
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(a + i),
+                                            _mm256_loadu_pd(b + i)));
+  }
+  AddDoubleScalar(a + i, b + i, out + i, size - i);
+}
+
+ELSH_TARGET_AVX2 void MulDoubleAvx2(const double* const a,
+                                    const double* const b, double* const out,
+                                    const size_t size) {
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i),
+                                            _mm256_loadu_pd(b + i)));
+  }
+  MulDoubleScalar(a + i, b + i, out + i, size - i);
+}
+
+ELSH_TARGET_AVX2 double DotDoubleAvx2(const double* const a,
+                                      const double* const b,
+                                      const size_t size) {
+  __m256d dot0 = _mm256_setzero_pd();
+  __m256d dot1 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    dot0 = _mm256_add_pd(
+        dot0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    dot1 = _mm256_add_pd(dot1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4),
+                                             _mm256_loadu_pd(b + i + 4)));
+  }
+  return SumDoubleLanesAvx2(_mm256_add_pd(dot0, dot1)) +
+         DotDoubleScalar(a + i, b + i, size - i);
+}
+
+const ArrayKernels kAvx2Kernels = {
+    FillInt32Avx2,
+    SumInt32Avx2,
+    MinInt32Avx2,
+    MaxInt32Avx2,
+    AddInt32Avx2,
+    MulInt32Avx2,
+    DotInt32Avx2,
+    FillDoubleAvx2,
+    SumDoubleAvx2,
+    MinDoubleAvx2,
+    MaxDoubleAvx2,
+    AddDoubleAvx2,
+    MulDoubleAvx2,
+    DotDoubleAvx2};
+
+#endif  // ELSH_X86_KERNELS
+
+}  // namespace
+
+KernelSet DetectKernelSet() {
+#ifdef ELSH_X86_KERNELS
+  static const KernelSet kDetected =
+      __builtin_cpu_supports("avx2")
+          ? KernelSet::kAvx2
+          : (__builtin_cpu_supports("sse2") ? KernelSet::kSse2
+                                            : KernelSet::kScalar);
+  return kDetected;
+#else
+  return KernelSet::kScalar;
+#endif
+}
+
+bool IsSupported(const KernelSet kernel_set) {
+  return static_cast<uint8_t>(kernel_set) <=
+         static_cast<uint8_t>(DetectKernelSet());
+}
+
+const char* KernelSetName(const KernelSet kernel_set) {
+  switch (kernel_set) {
+    case KernelSet::kAvx2:
+      return "avx2";
+    case KernelSet::kSse2:
+      return "sse2";
+    default:
+      return "scalar";
+  }
+}
+
+const ArrayKernels& GetArrayKernels(const KernelSet kernel_set) {
+#ifdef ELSH_X86_KERNELS
+  if (IsSupported(kernel_set)) {
+    if (kernel_set == KernelSet::kAvx2) {
+      return kAvx2Kernels;
+    } else if (kernel_set == KernelSet::kSse2) {
+      return kSse2Kernels;
+    }
+  }
+#endif
+  return kScalarKernels;
+}
+
+const ArrayKernels& GetArrayKernels() {
+  return GetArrayKernels(DetectKernelSet());
+}
+
+}  // namespace runtime
+}  // namespace elsh
@@ -0,0 +1,85 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_ARRAY_KERNELS_H_
+#define RUNTIME_ARRAY_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace elsh {
+namespace runtime {
+
+/// @brief Instruction sets the bulk array operations are built for.
+enum class KernelSet : uint8_t {
+  kScalar = 0,
+  kSse2 = 1,
+  kAvx2 = 2,
+};
+
+/// @brief Best kernel set the running cpu supports, detected once.
+KernelSet DetectKernelSet();
+bool IsSupported(const KernelSet kernel_set);
+const char* KernelSetName(const KernelSet kernel_set);
+
+/// @brief Bulk operations on contiguous unboxed elements. Integer sums and
+/// dot products accumulate in 64 bits, element-wise integer arithmetic wraps
+/// around. Vectorized double sums add in a different order than a sequential
+/// loop and may differ from it in the last bits. `min` and `max` need at least
+/// one element; for doubles they return NaN if any element is NaN, in every
+/// kernel set.
+struct ArrayKernels {
+  void (*fill_int32)(int32_t* const out, const size_t size,
+                     const int32_t value);
+  int64_t (*sum_int32)(const int32_t* const in, const size_t size);
+  int32_t (*min_int32)(const int32_t* const in, const size_t size);
+  int32_t (*max_int32)(const int32_t* const in, const size_t size);
+  void (*add_int32)(const int32_t* const a, const int32_t* const b,
+                    int32_t* const out, const size_t size);
+  void (*mul_int32)(const int32_t* const a, const int32_t* const b,
+                    int32_t* const out, const size_t size);
+  int64_t (*dot_int32)(const int32_t* const a, const int32_t* const b,
+                       const size_t size);
+
+  void (*fill_double)(double* const out, const size_t size,
+                      const double value);
+  double (*sum_double)(const double* const in, const size_t size);
+  double (*min_double)(const double* const in, const size_t size);
+  double (*max_double)(const double* const in, const size_t size);
+  void (*add_double)(const double* const a, const double* const b,
+                     double* const out, const size_t size);
+  void (*mul_double)(const double* const a, const double* const b,
+                     double* const out, const size_t size);
+  double (*dot_double)(const double* const a, const double* const b,
+                       const size_t size);
+};
+
+/// @brief Kernels of `kernel_set`, falling back to scalar code if the cpu does
+/// not support it.
+const ArrayKernels& GetArrayKernels(const KernelSet kernel_set);
+/// @brief Kernels of `DetectKernelSet()`.
+const ArrayKernels& GetArrayKernels();
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_ARRAY_KERNELS_H_
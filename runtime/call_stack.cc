@@ -0,0 +1,112 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/call_stack.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace elsh {
+namespace runtime {
+
+constexpr int FrameLayout::kNoSlot;
+constexpr size_t CallStack::kDefaultCapacity;
+constexpr size_t CallStack::kDefaultMaxDepth;
+
+FrameLayout::FrameLayout(const std::vector<std::string>& params)
+    : num_params_(static_cast<int>(params.size())) {
+  for (const auto& param : params) {
+    Declare(param);
+  }
+}
+
+int FrameLayout::Declare(const std::string& name) {
+  const auto it = slots_.emplace(name, static_cast<int>(names_.size()));
+  if (it.second) {
+    names_.push_back(name);
+  }
+  return it.first->second;
+}
+
+int FrameLayout::FindSlot(const std::string& name) const {
+  const auto it = slots_.find(name);
+  return it == slots_.end() ? kNoSlot : it->second;
+}
+
+CallStack::CallStack(const size_t capacity, const size_t max_depth)
+    : slots_(capacity), max_depth_(max_depth) {
+  frames_.reserve(max_depth);
+}
+
+Slot* CallStack::PrepareArgs(const int count) {
+  if (top_ + count > slots_.size()) {
+    return nullptr;
+  }
+  return slots_.data() + top_;
+}
+
+Slot* CallStack::Call(const FrameLayout& layout, const int return_pc) {
+  if (frames_.size() == max_depth_ ||
+      top_ + layout.num_slots() > slots_.size()) {
+    return nullptr;
+  }
+  frames_.push_back({&layout, static_cast<uint32_t>(top_), return_pc});
+  max_depth_reached_ = std::max(max_depth_reached_, frames_.size());
+  EnterFrame(layout, top_);
+  return slots_.data() + frames_.back().base;
+}
+
+Slot* CallStack::TailCall(const FrameLayout& layout) {
+  if (frames_.empty()) {
+    return nullptr;
+  }
+  Frame& frame = frames_.back();
+  if (frame.base + layout.num_slots() > slots_.size() ||
+      top_ + layout.num_params() > slots_.size()) {
+    return nullptr;
+  }
+  // The arguments may have been computed from the frame being replaced, so
+  // they were staged above it and only move down now.
+  std::memmove(slots_.data() + frame.base, slots_.data() + top_,
+               layout.num_params() * sizeof(Slot));
+  frame.layout = &layout;
+  EnterFrame(layout, frame.base);
+  return slots_.data() + frame.base;
+}
+
+int CallStack::Return() {
+  const Frame frame = frames_.back();
+  frames_.pop_back();
+  top_ = frame.base;
+  return frame.return_pc;
+}
+
+void CallStack::EnterFrame(const FrameLayout& layout, const size_t base) {
+  // Pointer arithmetic rather than `&slots_[...]` here and above: a frame
+  // that fills the stack has its locals, if any, one past the end.
+  std::memset(slots_.data() + base + layout.num_params(), 0,
+              (layout.num_slots() - layout.num_params()) * sizeof(Slot));
+  top_ = base + layout.num_slots();
+}
+
+}  // namespace runtime
+}  // namespace elsh
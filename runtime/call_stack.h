@@ -0,0 +1,133 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_CALL_STACK_H_
+#define RUNTIME_CALL_STACK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace elsh {
+namespace runtime {
+
+/// @brief One unboxed stack slot.
+union Slot {
+  int64_t i;
+  double d;
+};
+
+/// @brief Compile time view of a function's frame: parameters take the first
+/// slots in declaration order, locals follow. The compiler resolves every
+/// name to a slot here, so calls never look names up.
+class FrameLayout {
+ public:
+  explicit FrameLayout(const std::vector<std::string>& params);
+
+  /// @brief Slot of the local `name`, declaring it if it is new.
+  int Declare(const std::string& name);
+  /// @brief Slot of `name`, `kNoSlot` if it is neither a parameter nor a
+  /// declared local.
+  int FindSlot(const std::string& name) const;
+
+  int num_params() const { return num_params_; }
+  int num_slots() const { return static_cast<int>(names_.size()); }
+
+  static constexpr int kNoSlot = -1;
+
+ private:
+  int num_params_;
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, int> slots_;
+};
+
+/// @brief Contiguous VM stack of fixed size frames.
+///
+/// Both the slots and the frame records are allocated once up front, a call
+/// only moves the top of the stack. The caller writes the arguments right
+/// above its own frame, where they become the first slots of the callee's
+/// frame without being copied:
+///
+///   Slot* args = stack.PrepareArgs(1);
+///   args[0].i = n - 1;
+///   Slot* frame = stack.Call(layout, kAfterCall);
+///
+/// `TailCall` replaces the current frame instead, so calls in tail position,
+/// self recursion included, run in constant stack space.
+class CallStack {
+ public:
+  static constexpr size_t kDefaultCapacity = 1 << 20;
+  static constexpr size_t kDefaultMaxDepth = 1 << 16;
+
+  explicit CallStack(const size_t capacity = kDefaultCapacity,
+                     const size_t max_depth = kDefaultMaxDepth);
+
+  CallStack(const CallStack&) = delete;
+  CallStack& operator=(const CallStack&) = delete;
+
+  /// @brief Room for `count` outgoing arguments above the current frame,
+  /// nullptr if the stack is full.
+  Slot* PrepareArgs(const int count);
+
+  /// @brief Push a frame for `layout` whose parameters are the prepared
+  /// arguments and whose locals start zeroed. `return_pc` is handed back by
+  /// the matching `Return`. Return nullptr on stack overflow, leaving the stack
+  /// unchanged.
+  Slot* Call(const FrameLayout& layout, const int return_pc);
+
+  /// @brief Reuse the current frame for a call to `layout` with the prepared
+  /// arguments. The frame keeps its return pc. Return nullptr on stack
+  /// overflow or if there is no frame to reuse.
+  Slot* TailCall(const FrameLayout& layout);
+
+  /// @brief Pop the current frame and return its return pc.
+  int Return();
+
+  /// @brief Slots of the current frame.
+  Slot* locals() { return slots_.data() + frames_.back().base; }
+  size_t depth() const { return frames_.size(); }
+  /// @brief Most frames live at once since construction.
+  size_t max_depth_reached() const { return max_depth_reached_; }
+
+ private:
+  struct Frame {
+    const FrameLayout* layout;
+    uint32_t base;
+    int32_t return_pc;
+  };
+
+  void EnterFrame(const FrameLayout& layout, const size_t base);
+
+ private:
+  std::vector<Slot> slots_;
+  std::vector<Frame> frames_;
+  const size_t max_depth_;
+  size_t top_ = 0;
+  size_t max_depth_reached_ = 0;
+};
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_CALL_STACK_H_
@@ -0,0 +1,296 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/fork_server.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+constexpr int kNumPassedFds = 2;
+// How often a server with running children wakes up to reap them.
+constexpr int kReapIntervalMs = 100;
+// How long a client may take to send its request after connecting, so that
+// one that never does can not stall the requests after it.
+constexpr int kRequestTimeoutMs = 1000;
+
+bool MakeAddress(const std::string& socket_path, sockaddr_un* const address) {
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(address->sun_path)) {
+    return false;
+  }
+  memcpy(address->sun_path, socket_path.c_str(), socket_path.size() + 1);
+  return true;
+}
+
+// Sequenced packets keep every request in one message.
+int Connect(const std::string& socket_path) {
+  sockaddr_un address;
+  if (!MakeAddress(socket_path, &address)) {
+    return -1;
+  }
+  const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  if (connect(fd, reinterpret_cast<const sockaddr*>(&address),
+              sizeof(address)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+}  // namespace
+
+constexpr size_t ForkServer::kMaxRequestSize;
+
+std::unique_ptr<ForkServer> ForkServer::Listen(const std::string& socket_path,
+                                               std::string* const error) {
+  sockaddr_un address;
+  if (!MakeAddress(socket_path, &address)) {
+    *error = "socket path too long: " + socket_path;
+    return nullptr;
+  }
+  // A socket nobody accepts on is left over from a server that is gone.
+  const int existing = Connect(socket_path);
+  if (existing >= 0) {
+    close(existing);
+    *error = "a server is already listening on " + socket_path;
+    return nullptr;
+  }
+  struct stat st;
+  if (stat(socket_path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+    unlink(socket_path.c_str());
+  }
+
+  const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  bool listening = false;
+  if (fd >= 0) {
+    // bind creates the socket file, owner only from the start: a chmod
+    // afterwards would leave a moment in which others can connect.
+    const mode_t mask = umask(0177);
+    const int bound = bind(fd, reinterpret_cast<const sockaddr*>(&address),
+                           sizeof(address));
+    umask(mask);
+    listening = bound == 0 && listen(fd, SOMAXCONN) == 0;
+  }
+  if (!listening) {
+    const int listen_errno = errno;
+    *error = "can not listen on " + socket_path + ": " + strerror(listen_errno);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return nullptr;
+  }
+  return std::unique_ptr<ForkServer>(new ForkServer(fd, socket_path));
+}
+
+ForkServer::ForkServer(const int fd, const std::string& socket_path)
+    : fd_(fd), socket_path_(socket_path) {}
+
+ForkServer::~ForkServer() {
+  close(fd_);
+  unlink(socket_path_.c_str());
+}
+
+bool ForkServer::Serve(const Prepare& prepare, const Handler& handler,
+                       const int max_requests) {
+  for (int served = 0; max_requests < 0 || served < max_requests;) {
+    ReapChildren(false);
+    // Wait for the next request in slices while children run, so that they
+    // do not linger as zombies until it comes.
+    if (!children_.empty()) {
+      pollfd pfd{fd_, POLLIN, 0};
+      const int ready = poll(&pfd, 1, kReapIntervalMs);
+      if (ready == 0 || (ready < 0 && errno == EINTR)) {
+        continue;
+      }
+    }
+    const int connection = accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (connection < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      ReapChildren(true);
+      return false;
+    }
+    if (ServeOne(connection, prepare, handler)) {
+      ++served;
+    }
+    close(connection);
+  }
+  ReapChildren(true);
+  return true;
+}
+
+void ForkServer::ReapChildren(const bool wait) {
+  size_t running = 0;
+  for (const pid_t pid : children_) {
+    pid_t reaped;
+    do {
+      reaped = waitpid(pid, nullptr, wait ? 0 : WNOHANG);
+    } while (reaped < 0 && errno == EINTR);
+    if (reaped == 0) {
+      children_[running++] = pid;
+    }
+  }
+  children_.resize(running);
+}
+
+bool ForkServer::ServeOne(const int connection, const Prepare& prepare,
+                          const Handler& handler) {
+  char request[kMaxRequestSize];
+  iovec iov{request, sizeof(request)};
+  alignas(cmsghdr) char control[CMSG_SPACE(kNumPassedFds * sizeof(int))];
+  msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  pollfd pfd{connection, POLLIN, 0};
+  int ready;
+  do {
+    ready = poll(&pfd, 1, kRequestTimeoutMs);
+  } while (ready < 0 && errno == EINTR);
+  const ssize_t size =
+      ready > 0 ? recvmsg(connection, &message, MSG_CMSG_CLOEXEC | MSG_DONTWAIT)
+                : -1;
+
+  // Take the first pair of descriptors sent and close everything else that
+  // came along, so that malformed requests leak nothing.
+  int fds[kNumPassedFds] = {-1, -1};
+  for (cmsghdr* header = size >= 0 ? CMSG_FIRSTHDR(&message) : nullptr;
+       header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+    if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+      continue;
+    }
+    const size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    const bool is_pair = count == kNumPassedFds && fds[0] < 0;
+    for (size_t i = 0; i < count; ++i) {
+      int fd;
+      memcpy(&fd, CMSG_DATA(header) + i * sizeof(int), sizeof(fd));
+      if (is_pair) {
+        fds[i] = fd;
+      } else {
+        close(fd);
+      }
+    }
+  }
+  if (fds[0] < 0 || fds[1] < 0 ||
+      (message.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0) {
+    for (const int fd : fds) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+    return false;
+  }
+
+  const std::string request_string(request, size);
+  prepare(request_string);
+  // Whatever the server buffered must not be written again by the child.
+  std::cout.flush();
+  fflush(nullptr);
+  const pid_t pid = fork();
+  if (pid == 0) {
+    close(fd_);
+    dup2(fds[0], STDOUT_FILENO);
+    dup2(fds[1], STDERR_FILENO);
+    close(fds[0]);
+    close(fds[1]);
+    const int status = handler(request_string);
+    std::cout.flush();
+    fflush(nullptr);
+    send(connection, &status, sizeof(status), MSG_NOSIGNAL);
+    // The server's state is not the child's to tear down.
+    _exit(0);
+  }
+  close(fds[0]);
+  close(fds[1]);
+  if (pid > 0) {
+    children_.push_back(pid);
+  } else {
+    const int status = -1;
+    send(connection, &status, sizeof(status), MSG_NOSIGNAL);
+  }
+  return true;
+}
+
+bool SendForkRequest(const std::string& socket_path,
+                     const std::string& request, const int out_fd,
+                     const int err_fd, int* const status) {
+  if (request.size() > ForkServer::kMaxRequestSize) {
+    return false;
+  }
+  const int fd = Connect(socket_path);
+  if (fd < 0) {
+    return false;
+  }
+
+  iovec iov{const_cast<char*>(request.data()), request.size()};
+  alignas(cmsghdr) char control[CMSG_SPACE(kNumPassedFds * sizeof(int))];
+  memset(control, 0, sizeof(control));
+  msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  cmsghdr* const header = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type = SCM_RIGHTS;
+  header->cmsg_len = CMSG_LEN(kNumPassedFds * sizeof(int));
+  const int fds[kNumPassedFds] = {out_fd, err_fd};
+  memcpy(CMSG_DATA(header), fds, sizeof(fds));
+  if (sendmsg(fd, &message, MSG_NOSIGNAL) < 0) {
+    close(fd);
+    return false;
+  }
+
+  ssize_t size;
+  do {
+    size = recv(fd, status, sizeof(*status), 0);
+  } while (size < 0 && errno == EINTR);
+  if (size != static_cast<ssize_t>(sizeof(*status))) {
+    *status = -1;
+  }
+  close(fd);
+  return true;
+}
+
+}  // namespace runtime
+}  // namespace elsh
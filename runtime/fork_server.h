@@ -0,0 +1,111 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_FORK_SERVER_H_
+#define RUNTIME_FORK_SERVER_H_
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace elsh {
+namespace runtime {
+
+/// @brief Pre-forking ("zygote") server on a Unix domain socket.
+///
+/// The server process keeps whatever it has loaded warm and forks a copy on
+/// write child per request, which starts from that state instead of from a
+/// cold process. A request is a short string, say a script path, sent
+/// together with the client's stdout and stderr; the child runs with those as
+/// its own stdout and stderr and sends back an exit status:
+///
+///   // Server
+///   const auto server = ForkServer::Listen("/tmp/elsh.sock", &error);
+///   server->Serve(warm_up, run);
+///   // Client
+///   int status;
+///   SendForkRequest("/tmp/elsh.sock", "/path/script.sh", STDOUT_FILENO,
+///                   STDERR_FILENO, &status);
+///
+/// Requests run concurrently, each in its own child. Only the owner of the
+/// socket may connect to it. A client has a second after connecting to send
+/// its request.
+class ForkServer {
+ public:
+  static constexpr size_t kMaxRequestSize = 4096;
+
+  /// @brief Called in the server before every fork, to bring the shared
+  /// state up to date for `request`.
+  using Prepare = std::function<void(const std::string& request)>;
+  /// @brief Called in the child, return the exit status for the client.
+  using Handler = std::function<int(const std::string& request)>;
+
+  /// @brief Return nullptr and describe why in `error` if `socket_path` can
+  /// not be bound. A stale socket file left by a previous server is
+  /// replaced.
+  static std::unique_ptr<ForkServer> Listen(const std::string& socket_path,
+                                            std::string* const error);
+  ~ForkServer();
+
+  ForkServer(const ForkServer&) = delete;
+  ForkServer& operator=(const ForkServer&) = delete;
+
+  /// @brief Accept and fork for requests until `max_requests` were served,
+  /// forever if it is negative, then wait for the children still running.
+  /// Connections closed without a request do not count. Only the server's
+  /// own children are reaped, others of the host process are left alone.
+  /// Return false if accepting fails.
+  bool Serve(const Prepare& prepare, const Handler& handler,
+             const int max_requests = -1);
+
+ private:
+  ForkServer(const int fd, const std::string& socket_path);
+
+  /// @brief Return false for connections that did not send a request.
+  bool ServeOne(const int connection, const Prepare& prepare,
+                const Handler& handler);
+  /// @brief Reap the children that exited, all of them if `wait`.
+  void ReapChildren(const bool wait);
+
+ private:
+  const int fd_;
+  const std::string socket_path_;
+  // Children not reaped yet.
+  std::vector<pid_t> children_;
+};
+
+/// @brief Send `request` to the server at `socket_path` and wait for the
+/// status of its run, which writes to `out_fd` and `err_fd`. Return false if
+/// no server accepted the request, so the caller can run it itself; a child
+/// that died without reporting gives a status of -1.
+bool SendForkRequest(const std::string& socket_path,
+                     const std::string& request, const int out_fd,
+                     const int err_fd, int* const status);
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_FORK_SERVER_H_
@@ -0,0 +1,192 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/input_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+namespace elsh {
+namespace runtime {
+
+constexpr size_t InputFile::kDefaultMapThreshold;
+constexpr size_t InputFile::kDefaultBufferSize;
+
+std::unique_ptr<InputFile> InputFile::Open(const std::string& path,
+                                           std::string* const error,
+                                           const size_t map_threshold,
+                                           const size_t buffer_size) {
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    *error = "can not open " + path + ": " + strerror(errno);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return nullptr;
+  }
+
+  const size_t size = static_cast<size_t>(st.st_size);
+  // Files reporting no size are read, there may be more to them than that.
+  if (S_ISREG(st.st_mode) && size > 0 && size <= map_threshold) {
+    void* const mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      *error = "can not map " + path + ": " + strerror(errno);
+      close(fd);
+      return nullptr;
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    std::unique_ptr<InputFile> input(new InputFile(Mode::kMapped, -1, false));
+    input->mapping_ = mapping;
+    input->mapping_size_ = size;
+    input->data_ = static_cast<const char*>(mapping);
+    input->end_ = size;
+    // The mapping keeps the file open.
+    close(fd);
+    input->eof_ = true;
+    return input;
+  }
+
+  if (S_ISREG(st.st_mode)) {
+    // Larger readahead windows for the whole file.
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+  return Buffered(fd, true, buffer_size);
+}
+
+std::unique_ptr<InputFile> InputFile::FromFd(const int fd,
+                                             const size_t buffer_size) {
+  return Buffered(fd, false, buffer_size);
+}
+
+InputFile::InputFile(const Mode mode, const int fd, const bool owns_fd)
+    : mode_(mode), fd_(fd), owns_fd_(owns_fd) {}
+
+std::unique_ptr<InputFile> InputFile::Buffered(const int fd,
+                                               const bool owns_fd,
+                                               const size_t buffer_size) {
+  std::unique_ptr<InputFile> input(new InputFile(Mode::kBuffered, fd, owns_fd));
+  // An empty buffer could never grow by doubling.
+  input->capacity_ = buffer_size == 0 ? 1 : buffer_size;
+  input->buffer_.reset(new char[input->capacity_]);
+  input->data_ = input->buffer_.get();
+  return input;
+}
+
+InputFile::~InputFile() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+  if (owns_fd_) {
+    close(fd_);
+  }
+}
+
+bool InputFile::NextLine(View* const line) {
+  for (;;) {
+    const size_t unscanned = end_ - begin_ - scanned_;
+    const char* const newline =
+        unscanned == 0 ? nullptr
+                       : static_cast<const char*>(memchr(
+                             data_ + begin_ + scanned_, '\n', unscanned));
+    if (newline != nullptr) {
+      line->data = data_ + begin_;
+      line->size = newline - line->data;
+      begin_ += line->size + 1;
+      scanned_ = 0;
+      return true;
+    }
+    scanned_ = end_ - begin_;
+    if (!Fill()) {
+      break;
+    }
+  }
+  if (begin_ == end_ || failed_) {
+    return false;
+  }
+  line->data = data_ + begin_;
+  line->size = end_ - begin_;
+  begin_ = end_;
+  scanned_ = 0;
+  return true;
+}
+
+bool InputFile::NextChunk(const size_t size, View* const chunk) {
+  // An empty chunk would never advance a loop over the chunks.
+  if (size == 0) {
+    return false;
+  }
+  while (end_ - begin_ < size && Fill()) {
+  }
+  if (begin_ == end_ || failed_) {
+    return false;
+  }
+  chunk->data = data_ + begin_;
+  chunk->size = end_ - begin_ < size ? end_ - begin_ : size;
+  begin_ += chunk->size;
+  scanned_ = 0;
+  return true;
+}
+
+bool InputFile::Fill() {
+  if (eof_ || failed_) {
+    return false;
+  }
+  const size_t unread = end_ - begin_;
+  if (begin_ > 0) {
+    memmove(buffer_.get(), buffer_.get() + begin_, unread);
+    begin_ = 0;
+    end_ = unread;
+  }
+  if (end_ == capacity_) {
+    // A line or chunk longer than the buffer.
+    std::unique_ptr<char[]> buffer(new char[capacity_ * 2]);
+    memcpy(buffer.get(), buffer_.get(), end_);
+    buffer_ = std::move(buffer);
+    capacity_ *= 2;
+    data_ = buffer_.get();
+  }
+
+  ssize_t size;
+  do {
+    size = read(fd_, buffer_.get() + end_, capacity_ - end_);
+  } while (size < 0 && errno == EINTR);
+  if (size < 0) {
+    failed_ = true;
+    return false;
+  }
+  if (size == 0) {
+    eof_ = true;
+    return false;
+  }
+  end_ += size;
+  return true;
+}
+
+}  // namespace runtime
+}  // namespace elsh
@@ -0,0 +1,130 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_INPUT_FILE_H_
+#define RUNTIME_INPUT_FILE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace elsh {
+namespace runtime {
+
+/// @brief Input source of the line and chunk iteration builtins.
+///
+/// Regular files up to the map threshold are mapped whole and advised for
+/// sequential access, larger files, pipes and terminals are read through one
+/// large buffer, with kernel readahead requested for regular files. So are
+/// regular files reporting a size of 0, which may be empty or, under /proc
+/// and /sys, generated as they are read.
+///
+/// Lines and chunks are handed out as views into the mapping or the buffer,
+/// nothing is copied:
+///
+///   std::string error;
+///   const auto input = InputFile::Open("access.log", &error);
+///   InputFile::View line;
+///   while (input->NextLine(&line)) {
+///     ...
+///   }
+///
+/// A view stays valid until the next `NextLine` or `NextChunk` call, which
+/// may move or refill the buffer. Views of a mapped file stay valid as long
+/// as the `InputFile`.
+class InputFile {
+ public:
+  enum class Mode { kMapped, kBuffered };
+
+  static constexpr size_t kDefaultMapThreshold = 64 << 20;
+  static constexpr size_t kDefaultBufferSize = 1 << 20;
+
+  struct View {
+    const char* data = nullptr;
+    size_t size = 0;
+
+    std::string ToString() const { return std::string(data, size); }
+  };
+
+  /// @brief Return nullptr and describe why in `error` if `path` can not be
+  /// opened or mapped. A `buffer_size` of 0 counts as 1.
+  static std::unique_ptr<InputFile> Open(
+      const std::string& path, std::string* const error,
+      const size_t map_threshold = kDefaultMapThreshold,
+      const size_t buffer_size = kDefaultBufferSize);
+  /// @brief Read `fd`, say a pipe or stdin, which stays owned by the caller.
+  static std::unique_ptr<InputFile> FromFd(
+      const int fd, const size_t buffer_size = kDefaultBufferSize);
+
+  ~InputFile();
+
+  InputFile(const InputFile&) = delete;
+  InputFile& operator=(const InputFile&) = delete;
+
+  /// @brief Next line without its '\n'. A last line without one is returned
+  /// as well. Return false at the end of the input or on a read error.
+  bool NextLine(View* const line);
+  /// @brief Next `size` bytes, fewer only for the last chunk. Return false at
+  /// the end of the input, on a read error or for a `size` of 0.
+  bool NextChunk(const size_t size, View* const chunk);
+
+  Mode mode() const { return mode_; }
+  /// @brief Whether reading stopped on an error rather than at the end.
+  bool failed() const { return failed_; }
+
+ private:
+  InputFile(const Mode mode, const int fd, const bool owns_fd);
+
+  static std::unique_ptr<InputFile> Buffered(const int fd, const bool owns_fd,
+                                             const size_t buffer_size);
+
+  /// @brief Move the unread bytes to the front of the buffer, growing it if
+  /// they fill it, and read more after them. Return false at the end of the
+  /// input or on a read error.
+  bool Fill();
+
+ private:
+  const Mode mode_;
+  const int fd_;
+  const bool owns_fd_;
+  // Start of the mapping or of the buffer, unread bytes are [begin_, end_).
+  const char* data_ = nullptr;
+  size_t begin_ = 0;
+  size_t end_ = 0;
+  // Bytes after `begin_` already searched for a newline.
+  size_t scanned_ = 0;
+  bool eof_ = false;
+  bool failed_ = false;
+
+  // Mapped mode.
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+
+  // Buffered mode.
+  std::unique_ptr<char[]> buffer_;
+  size_t capacity_ = 0;
+};
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_INPUT_FILE_H_
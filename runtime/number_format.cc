@@ -0,0 +1,447 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/number_format.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace elsh {
+namespace runtime {
+namespace {
+constexpr char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Every decimal with no more than 15 significant digits survives a round trip
+// through a double, so 15 digits is where the fallback search for the
+// shortest representation starts. 17 digits always round trip.
+constexpr int kMinRoundTripDigits = 15;
+constexpr int kMaxRoundTripDigits = 17;
+// Same thresholds as `%.17g`: fixed notation is used for decimal exponents in
+// [kMinFixedExponent, kMaxFixedExponent).
+constexpr int kMinFixedExponent = -4;
+constexpr int kMaxFixedExponent = 17;
+
+int CopyLiteral(const char* const literal, char* const out) {
+  const int size = static_cast<int>(std::strlen(literal));
+  std::memcpy(out, literal, size);
+  return size;
+}
+
+// Shortest digits with Grisu3 (Loitsch, "Printing Floating-Point Numbers
+// Quickly and Accurately with Integers", PLDI 2010). It works in 64 bit
+// integers only and proves for about 99.5% of all doubles that its digits are
+// the shortest that round trip; for the rest it gives up, and the search with
+// `snprintf` and `strtod` below takes over.
+
+// Significand and binary exponent of f * 2^e, no hidden bit, no sign.
+struct DiyFp {
+  uint64_t f;
+  int e;
+};
+
+// Product rounded to the upper 64 bits of the significand.
+DiyFp Multiply(const DiyFp& x, const DiyFp& y) {
+  constexpr uint64_t kMask32 = 0xFFFFFFFF;
+  const uint64_t a = x.f >> 32;
+  const uint64_t b = x.f & kMask32;
+  const uint64_t c = y.f >> 32;
+  const uint64_t d = y.f & kMask32;
+  const uint64_t ac = a * c;
+  const uint64_t bc = b * c;
+  const uint64_t ad = a * d;
+  const uint64_t bd = b * d;
+  const uint64_t middle = (bd >> 32) + (ad & kMask32) + (bc & kMask32) +
+                          (uint64_t{1} << 31);
+  return {ac + (ad >> 32) + (bc >> 32) + (middle >> 32), x.e + y.e + 64};
+}
+
+DiyFp Normalize(DiyFp x) {
+  while ((x.f >> 63) == 0) {
+    x.f <<= 1;
+    --x.e;
+  }
+  return x;
+}
+
+// 10^k as a normalized DiyFp, for every 8th k from -348 to 340, generated
+// with exact integer arithmetic and rounded to nearest.
+struct CachedPower {
+  uint64_t f;
+  int16_t e;
+  int16_t k;
+};
+
+constexpr CachedPower kCachedPowers[] = {
+    {0xFA8FD5A0081C0288, -1220, -348},
+    {0xBAAEE17FA23EBF76, -1193, -340},
+    {0x8B16FB203055AC76, -1166, -332},
+    {0xCF42894A5DCE35EA, -1140, -324},
+    {0x9A6BB0AA55653B2D, -1113, -316},
+    {0xE61ACF033D1A45DF, -1087, -308},
+    {0xAB70FE17C79AC6CA, -1060, -300},
+    {0xFF77B1FCBEBCDC4F, -1034, -292},
+    {0xBE5691EF416BD60C, -1007, -284},
+    {0x8DD01FAD907FFC3C, -980, -276},
+    {0xD3515C2831559A83, -954, -268},
+    {0x9D71AC8FADA6C9B5, -927, -260},
+    {0xEA9C227723EE8BCB, -901, -252},
+    {0xAECC49914078536D, -874, -244},
+    {0x823C12795DB6CE57, -847, -236},
+    {0xC21094364DFB5637, -821, -228},
+    {0x9096EA6F3848984F, -794, -220},
+    {0xD77485CB25823AC7, -768, -212},
+    {0xA086CFCD97BF97F4, -741, -204},
+    {0xEF340A98172AACE5, -715, -196},
+    {0xB23867FB2A35B28E, -688, -188},
+    {0x84C8D4DFD2C63F3B, -661, -180},
+    {0xC5DD44271AD3CDBA, -635, -172},
+    {0x936B9FCEBB25C996, -608, -164},
+    {0xDBAC6C247D62A584, -582, -156},
+    {0xA3AB66580D5FDAF6, -555, -148},
+    {0xF3E2F893DEC3F126, -529, -140},
+    {0xB5B5ADA8AAFF80B8, -502, -132},
+    {0x87625F056C7C4A8B, -475, -124},
+    {0xC9BCFF6034C13053, -449, -116},
+    {0x964E858C91BA2655, -422, -108},
+    {0xDFF9772470297EBD, -396, -100},
+    {0xA6DFBD9FB8E5B88F, -369, -92},
+    {0xF8A95FCF88747D94, -343, -84},
+    {0xB94470938FA89BCF, -316, -76},
+    {0x8A08F0F8BF0F156B, -289, -68},
+    {0xCDB02555653131B6, -263, -60},
+    {0x993FE2C6D07B7FAC, -236, -52},
+    {0xE45C10C42A2B3B06, -210, -44},
+    {0xAA242499697392D3, -183, -36},
+    {0xFD87B5F28300CA0E, -157, -28},
+    {0xBCE5086492111AEB, -130, -20},
+    {0x8CBCCC096F5088CC, -103, -12},
+    {0xD1B71758E219652C, -77, -4},
+    {0x9C40000000000000, -50, 4},
+    {0xE8D4A51000000000, -24, 12},
+    {0xAD78EBC5AC620000, 3, 20},
+    {0x813F3978F8940984, 30, 28},
+    {0xC097CE7BC90715B3, 56, 36},
+    {0x8F7E32CE7BEA5C70, 83, 44},
+    {0xD5D238A4ABE98068, 109, 52},
+    {0x9F4F2726179A2245, 136, 60},
+    {0xED63A231D4C4FB27, 162, 68},
+    {0xB0DE65388CC8ADA8, 189, 76},
+    {0x83C7088E1AAB65DB, 216, 84},
+    {0xC45D1DF942711D9A, 242, 92},
+    {0x924D692CA61BE758, 269, 100},
+    {0xDA01EE641A708DEA, 295, 108},
+    {0xA26DA3999AEF774A, 322, 116},
+    {0xF209787BB47D6B85, 348, 124},
+    {0xB454E4A179DD1877, 375, 132},
+    {0x865B86925B9BC5C2, 402, 140},
+    {0xC83553C5C8965D3D, 428, 148},
+    {0x952AB45CFA97A0B3, 455, 156},
+    {0xDE469FBD99A05FE3, 481, 164},
+    {0xA59BC234DB398C25, 508, 172},
+    {0xF6C69A72A3989F5C, 534, 180},
+    {0xB7DCBF5354E9BECE, 561, 188},
+    {0x88FCF317F22241E2, 588, 196},
+    {0xCC20CE9BD35C78A5, 614, 204},
+    {0x98165AF37B2153DF, 641, 212},
+    {0xE2A0B5DC971F303A, 667, 220},
+    {0xA8D9D1535CE3B396, 694, 228},
+    {0xFB9B7CD9A4A7443C, 720, 236},
+    {0xBB764C4CA7A44410, 747, 244},
+    {0x8BAB8EEFB6409C1A, 774, 252},
+    {0xD01FEF10A657842C, 800, 260},
+    {0x9B10A4E5E9913129, 827, 268},
+    {0xE7109BFBA19C0C9D, 853, 276},
+    {0xAC2820D9623BF429, 880, 284},
+    {0x80444B5E7AA7CF85, 907, 292},
+    {0xBF21E44003ACDD2D, 933, 300},
+    {0x8E679C2F5E44FF8F, 960, 308},
+    {0xD433179D9C8CB841, 986, 316},
+    {0x9E19DB92B4E31BA9, 1013, 324},
+    {0xEB96BF6EBADF77D9, 1039, 332},
+    {0xAF87023B9BF0EE6B, 1066, 340}};
+constexpr int kCachedPowersOffset = 348;
+constexpr int kCachedPowersStep = 8;
+
+// The scaled significands are cut at 2^-e with e in [kMinTargetExponent,
+// kMaxTargetExponent], so their integral part fits 32 bits.
+constexpr int kMinTargetExponent = -60;
+constexpr int kMaxTargetExponent = -32;
+
+// Power of ten that brings a normalized `e` into the target range.
+const CachedPower& CachedPowerFor(const int e) {
+  const int min_exponent = kMinTargetExponent - (e + 64);
+  const int k = static_cast<int>(std::ceil((min_exponent + 63) *
+                                           0.30102999566398114));
+  return kCachedPowers[(kCachedPowersOffset + k - 1) / kCachedPowersStep + 1];
+}
+
+// Move the last digit towards `w` while the digits stay inside the safe
+// interval, then tell whether they are provably the closest shortest ones.
+bool RoundWeed(char* const digits, const int num_digits,
+               const uint64_t distance_too_high_w,
+               const uint64_t unsafe_interval, uint64_t rest,
+               const uint64_t ten_kappa, const uint64_t unit) {
+  const uint64_t small_distance = distance_too_high_w - unit;
+  const uint64_t big_distance = distance_too_high_w + unit;
+  while (rest < small_distance && unsafe_interval - rest >= ten_kappa &&
+         (rest + ten_kappa < small_distance ||
+          small_distance - rest >= rest + ten_kappa - small_distance)) {
+    --digits[num_digits - 1];
+    rest += ten_kappa;
+  }
+  if (rest < big_distance && unsafe_interval - rest >= ten_kappa &&
+      (rest + ten_kappa < big_distance ||
+       big_distance - rest > rest + ten_kappa - big_distance)) {
+    return false;
+  }
+  return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+// Digits of the scaled `w` between `low` and `high`, which share its exponent.
+// On success `value` = digits * 10^(kappa - k) for the scaling by 10^k.
+bool GenerateDigits(const DiyFp& low, const DiyFp& w, const DiyFp& high,
+                    char* const digits, int* const num_digits,
+                    int* const kappa) {
+  uint64_t unit = 1;
+  const DiyFp too_high = {high.f + unit, high.e};
+  uint64_t unsafe_interval = too_high.f - (low.f - unit);
+  const int shift = -w.e;
+  const uint64_t one = uint64_t{1} << shift;
+  uint32_t integrals = static_cast<uint32_t>(too_high.f >> shift);
+  uint64_t fractionals = too_high.f & (one - 1);
+
+  uint32_t divisor = 1;
+  *kappa = 0;
+  if (integrals > 0) {
+    *kappa = 1;
+    while (integrals / divisor >= 10) {
+      divisor *= 10;
+      ++*kappa;
+    }
+  }
+  *num_digits = 0;
+  while (*kappa > 0) {
+    digits[(*num_digits)++] = static_cast<char>('0' + integrals / divisor);
+    integrals %= divisor;
+    --*kappa;
+    const uint64_t rest =
+        (static_cast<uint64_t>(integrals) << shift) + fractionals;
+    if (rest < unsafe_interval) {
+      return RoundWeed(digits, *num_digits, too_high.f - w.f, unsafe_interval,
+                       rest, static_cast<uint64_t>(divisor) << shift, unit);
+    }
+    divisor /= 10;
+  }
+  for (;;) {
+    fractionals *= 10;
+    unit *= 10;
+    unsafe_interval *= 10;
+    digits[(*num_digits)++] = static_cast<char>('0' + (fractionals >> shift));
+    fractionals &= one - 1;
+    --*kappa;
+    if (fractionals < unsafe_interval) {
+      return RoundWeed(digits, *num_digits, (too_high.f - w.f) * unit,
+                       unsafe_interval, fractionals, one, unit);
+    }
+    // Past 17 digits the interval is too narrow to decide in 64 bits.
+    if (*num_digits > kMaxRoundTripDigits) {
+      return false;
+    }
+  }
+}
+
+// Shortest digits of the finite, positive `value` and the decimal exponent of
+// the first one, or false if Grisu3 can not prove them shortest.
+bool Grisu3(const double value, char* const digits, int* const num_digits,
+            int* const exponent) {
+  constexpr int kSignificandBits = 52;
+  constexpr int kExponentBias = 0x3FF + kSignificandBits;
+  constexpr uint64_t kHiddenBit = uint64_t{1} << kSignificandBits;
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint64_t fraction = bits & (kHiddenBit - 1);
+  const int biased_exponent = static_cast<int>(bits >> kSignificandBits);
+  const DiyFp v =
+      biased_exponent == 0
+          ? DiyFp{fraction, 1 - kExponentBias}
+          : DiyFp{fraction + kHiddenBit, biased_exponent - kExponentBias};
+
+  // Halfway to the neighbours, which is closer below powers of two.
+  const DiyFp plus = Normalize({(v.f << 1) + 1, v.e - 1});
+  DiyFp minus = fraction == 0 && biased_exponent > 1
+                    ? DiyFp{(v.f << 2) - 1, v.e - 2}
+                    : DiyFp{(v.f << 1) - 1, v.e - 1};
+  minus.f <<= minus.e - plus.e;
+  minus.e = plus.e;
+
+  const DiyFp w = Normalize(v);
+  const CachedPower& cached = CachedPowerFor(w.e);
+  const DiyFp ten_k = {cached.f, cached.e};
+  int kappa;
+  if (!GenerateDigits(Multiply(minus, ten_k), Multiply(w, ten_k),
+                      Multiply(plus, ten_k), digits, num_digits, &kappa)) {
+    return false;
+  }
+  *exponent = kappa - cached.k + *num_digits - 1;
+  return true;
+}
+
+// Shortest of 15 to 17 digits that round trip, for what Grisu3 gives up on.
+// `%.*e` prints "d.ddde+XX", which makes digits and exponent easy to pick.
+void SearchDigits(const double value, char* const digits,
+                  int* const num_digits, int* const exponent) {
+  char sci[kMaxDoubleChars];
+  for (int n = kMinRoundTripDigits; n <= kMaxRoundTripDigits; ++n) {
+    std::snprintf(sci, sizeof(sci), "%.*e", n - 1, value);
+    if (std::strtod(sci, nullptr) == value) {
+      break;
+    }
+  }
+  const char* p = sci;
+  *num_digits = 0;
+  for (; *p != 'e'; ++p) {
+    if (*p != '.') {
+      digits[(*num_digits)++] = *p;
+    }
+  }
+  *exponent = std::atoi(p + 1);
+}
+}  // namespace
+
+int FormatUint(uint64_t value, char* const out) {
+  char tmp[kMaxIntegerChars];
+  char* p = tmp + kMaxIntegerChars;
+  while (value >= 100) {
+    const int pair = static_cast<int>(value % 100) * 2;
+    value /= 100;
+    *--p = kDigitPairs[pair + 1];
+    *--p = kDigitPairs[pair];
+  }
+  if (value >= 10) {
+    const int pair = static_cast<int>(value) * 2;
+    *--p = kDigitPairs[pair + 1];
+    *--p = kDigitPairs[pair];
+  } else {
+    *--p = static_cast<char>('0' + value);
+  }
+
+  const int size = static_cast<int>(tmp + kMaxIntegerChars - p);
+  std::memcpy(out, p, size);
+  return size;
+}
+
+int FormatInt(const int64_t value, char* const out) {
+  if (value >= 0) {
+    return FormatUint(static_cast<uint64_t>(value), out);
+  }
+  out[0] = '-';
+  // Negate in unsigned arithmetic so that INT64_MIN does not overflow.
+  return 1 + FormatUint(0 - static_cast<uint64_t>(value), out + 1);
+}
+
+int FormatDouble(const double value, char* const out) {
+  if (std::isnan(value)) {
+    return CopyLiteral("nan", out);
+  }
+  if (std::isinf(value)) {
+    return CopyLiteral(value < 0 ? "-inf" : "inf", out);
+  }
+  if (value == 0.) {
+    return CopyLiteral(std::signbit(value) ? "-0" : "0", out);
+  }
+  // Integral values are the common case in scripts and need no search.
+  if (std::fabs(value) < 1e15 && value == std::trunc(value)) {
+    return FormatInt(static_cast<int64_t>(value), out);
+  }
+
+  int size = 0;
+  if (value < 0) {
+    out[size++] = '-';
+  }
+  // One spare for the digit Grisu3 may generate before giving up.
+  char mantissa[kMaxRoundTripDigits + 2];
+  int num_digits;
+  int exponent;
+  if (!Grisu3(std::fabs(value), mantissa, &num_digits, &exponent)) {
+    SearchDigits(std::fabs(value), mantissa, &num_digits, &exponent);
+  }
+  while (num_digits > 1 && mantissa[num_digits - 1] == '0') {
+    --num_digits;
+  }
+
+  if (exponent < kMinFixedExponent || exponent >= kMaxFixedExponent) {
+    out[size++] = mantissa[0];
+    if (num_digits > 1) {
+      out[size++] = '.';
+      std::memcpy(out + size, mantissa + 1, num_digits - 1);
+      size += num_digits - 1;
+    }
+    out[size++] = 'e';
+    out[size++] = exponent < 0 ? '-' : '+';
+    const int abs_exponent = exponent < 0 ? -exponent : exponent;
+    if (abs_exponent < 10) {
+      out[size++] = '0';
+    }
+    return size + FormatUint(abs_exponent, out + size);
+  }
+
+  if (exponent < 0) {
+    out[size++] = '0';
+    out[size++] = '.';
+    for (int i = exponent + 1; i < 0; ++i) {
+      out[size++] = '0';
+    }
+    std::memcpy(out + size, mantissa, num_digits);
+    return size + num_digits;
+  }
+
+  const int integer_digits = exponent + 1;
+  if (num_digits <= integer_digits) {
+    std::memcpy(out + size, mantissa, num_digits);
+    size += num_digits;
+    for (int i = num_digits; i < integer_digits; ++i) {
+      out[size++] = '0';
+    }
+    return size;
+  }
+  std::memcpy(out + size, mantissa, integer_digits);
+  size += integer_digits;
+  out[size++] = '.';
+  std::memcpy(out + size, mantissa + integer_digits,
+              num_digits - integer_digits);
+  return size + num_digits - integer_digits;
+}
+
+}  // namespace runtime
+}  // namespace elsh
@@ -0,0 +1,53 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_NUMBER_FORMAT_H_
+#define RUNTIME_NUMBER_FORMAT_H_
+
+#include <cstdint>
+
+namespace elsh {
+namespace runtime {
+
+/// @brief Enough room for any 64bit integer, sign included.
+constexpr int kMaxIntegerChars = 20;
+/// @brief Enough room for any double formatted by `FormatDouble`.
+constexpr int kMaxDoubleChars = 32;
+
+/// @brief Write the decimal representation of `value` to `out` and return the
+/// number of characters written. No terminating null is appended. `out` must
+/// have room for at least `kMaxIntegerChars` characters.
+int FormatInt(const int64_t value, char* const out);
+int FormatUint(const uint64_t value, char* const out);
+
+/// @brief Write the shortest decimal representation of `value` which reads
+/// back to the very same double. The layout follows `%g` (scientific notation
+/// for very small or large exponents), but without its fixed precision.
+/// Digits come from Grisu3, with a `snprintf` search for the rare doubles it
+/// can not decide. `out` must have room for at least `kMaxDoubleChars`
+/// characters.
+int FormatDouble(const double value, char* const out);
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_NUMBER_FORMAT_H_
@@ -0,0 +1,120 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/output_buffer.h"
+
+#include <errno.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "runtime/number_format.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+// Keep room for one formatted number at least.
+constexpr size_t kMinCapacity = 64;
+}  // namespace
+
+constexpr size_t OutputBuffer::kDefaultCapacity;
+
+OutputBuffer::OutputBuffer(const int fd, const size_t capacity)
+    : fd_(fd),
+      capacity_(std::max(capacity, kMinCapacity)),
+      buffer_(new char[capacity_]) {}
+
+OutputBuffer::~OutputBuffer() { Flush(); }
+
+bool OutputBuffer::IsTerminal() const { return isatty(fd_) == 1; }
+
+void OutputBuffer::Write(const char* const data, const size_t size) {
+  if (size > capacity_ - size_) {
+    Flush();
+    // Large chunks go straight to the file descriptor instead of being split.
+    if (size >= capacity_) {
+      write_failed_ = !WriteAll(data, size) || write_failed_;
+      return;
+    }
+  }
+  std::memcpy(buffer_.get() + size_, data, size);
+  size_ += size;
+  if (line_buffered_ && std::memchr(data, '\n', size) != nullptr) {
+    Flush();
+  }
+}
+
+void OutputBuffer::PutChar(const char c) {
+  if (size_ == capacity_) {
+    Flush();
+  }
+  buffer_[size_++] = c;
+  if (line_buffered_ && c == '\n') {
+    Flush();
+  }
+}
+
+void OutputBuffer::PrintInt(const int64_t value) {
+  if (capacity_ - size_ < kMaxIntegerChars) {
+    Flush();
+  }
+  size_ += FormatInt(value, buffer_.get() + size_);
+}
+
+void OutputBuffer::PrintUint(const uint64_t value) {
+  if (capacity_ - size_ < kMaxIntegerChars) {
+    Flush();
+  }
+  size_ += FormatUint(value, buffer_.get() + size_);
+}
+
+void OutputBuffer::PrintDouble(const double value) {
+  if (capacity_ - size_ < kMaxDoubleChars) {
+    Flush();
+  }
+  size_ += FormatDouble(value, buffer_.get() + size_);
+}
+
+bool OutputBuffer::Flush() {
+  const bool ok = WriteAll(buffer_.get(), size_) && !write_failed_;
+  size_ = 0;
+  write_failed_ = false;
+  return ok;
+}
+
+bool OutputBuffer::WriteAll(const char* data, size_t size) {
+  while (size > 0) {
+    const ssize_t written = write(fd_, data, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+}  // namespace runtime
+}  // namespace elsh
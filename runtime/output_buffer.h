@@ -0,0 +1,89 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_OUTPUT_BUFFER_H_
+#define RUNTIME_OUTPUT_BUFFER_H_
+
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace elsh {
+namespace runtime {
+
+/// @brief Output sink of the `print` and `putc` builtins.
+///
+/// Everything is collected in one large buffer which is handed to `write(2)`
+/// only when it is full, when `Flush()` is called or when the buffer is
+/// destroyed. Numbers are formatted in place without going through iostreams,
+/// so printing in a tight loop costs a `memcpy` most of the time.
+class OutputBuffer {
+ public:
+  static constexpr size_t kDefaultCapacity = 64 * 1024;
+
+  explicit OutputBuffer(const int fd = STDOUT_FILENO,
+                        const size_t capacity = kDefaultCapacity);
+  ~OutputBuffer();
+
+  OutputBuffer(const OutputBuffer&) = delete;
+  OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+  /// @brief Flush at every '\n' instead of only when the buffer is full.
+  void SetLineBuffered(const bool line_buffered) {
+    line_buffered_ = line_buffered;
+  }
+  /// @brief Whether the underlying file descriptor refers to a terminal.
+  bool IsTerminal() const;
+
+  void Write(const char* const data, const size_t size);
+  void Write(const std::string& str) { Write(str.data(), str.size()); }
+  void PutChar(const char c);
+  void PrintInt(const int64_t value);
+  void PrintUint(const uint64_t value);
+  void PrintDouble(const double value);
+
+  /// @brief Hand everything buffered so far to the file descriptor. Return
+  /// false if any write failed since the last flush.
+  bool Flush();
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+
+ private:
+  bool WriteAll(const char* data, size_t size);
+
+ private:
+  const int fd_;
+  const size_t capacity_;
+  std::unique_ptr<char[]> buffer_;
+  size_t size_ = 0;
+  bool line_buffered_ = false;
+  bool write_failed_ = false;
+};
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_OUTPUT_BUFFER_H_
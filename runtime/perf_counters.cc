@@ -0,0 +1,227 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/perf_counters.h"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+struct EventConfig {
+  uint32_t type;
+  uint64_t config;
+};
+
+// Indexed by `PerfEvent`.
+const EventConfig kEventConfigs[kNumPerfEvents] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+};
+
+int OpenEvent(const EventConfig& event_config) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = event_config.type;
+  attr.config = event_config.config;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // User space only, which unprivileged processes may count at the default
+  // perf_event_paranoid level.
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return static_cast<int>(
+      syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+std::string OpenError(const int error) {
+  switch (error) {
+    case ENOENT:
+    case EOPNOTSUPP:
+      return "not supported by this cpu or hypervisor";
+    case EACCES:
+    case EPERM:
+      return "not permitted, see /proc/sys/kernel/perf_event_paranoid";
+    case ENOSYS:
+      return "perf_event_open is not available";
+    default:
+      return strerror(error);
+  }
+}
+
+uint64_t ReadEvent(const int fd) {
+  // value, time enabled, time running.
+  uint64_t data[3];
+  if (read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) ||
+      data[2] == 0) {
+    return 0;
+  }
+  if (data[2] == data[1]) {
+    return data[0];
+  }
+  return static_cast<uint64_t>(static_cast<double>(data[0]) * data[1] /
+                               data[2]);
+}
+
+}  // namespace
+
+const char* PerfEventName(const PerfEvent event) {
+  switch (event) {
+    case PerfEvent::kCycles:
+      return "cycles";
+    case PerfEvent::kInstructions:
+      return "instructions";
+    case PerfEvent::kBranchMisses:
+      return "branch-misses";
+    case PerfEvent::kL1dMisses:
+      return "L1d-misses";
+    case PerfEvent::kLlcMisses:
+      return "LLC-misses";
+  }
+  return "unknown";
+}
+
+double PerfValues::Ipc() const {
+  const uint64_t cycles = (*this)[PerfEvent::kCycles];
+  return cycles == 0 ? 0. : static_cast<double>(
+                                (*this)[PerfEvent::kInstructions]) /
+                                cycles;
+}
+
+PerfValues& PerfValues::operator+=(const PerfValues& other) {
+  for (size_t i = 0; i < kNumPerfEvents; ++i) {
+    counts[i] += other.counts[i];
+  }
+  return *this;
+}
+
+PerfValues PerfValues::operator-(const PerfValues& other) const {
+  PerfValues difference;
+  for (size_t i = 0; i < kNumPerfEvents; ++i) {
+    difference.counts[i] =
+        counts[i] > other.counts[i] ? counts[i] - other.counts[i] : 0;
+  }
+  return difference;
+}
+
+PerfCounters::ScopedRegion::ScopedRegion(const PerfCounters* const counters,
+                                         PerfValues* const total)
+    : counters_(counters), total_(total), start_(counters->Read()) {}
+
+PerfCounters::ScopedRegion::~ScopedRegion() {
+  *total_ += counters_->Read() - start_;
+}
+
+PerfCounters::PerfCounters() {
+  for (size_t i = 0; i < kNumPerfEvents; ++i) {
+    fds_[i] = OpenEvent(kEventConfigs[i]);
+    // Before building strings, which may allocate and clobber it.
+    const int open_errno = errno;
+    if (fds_[i] < 0 && error_.empty()) {
+      error_ = std::string(PerfEventName(static_cast<PerfEvent>(i))) + ": " +
+               OpenError(open_errno);
+    }
+  }
+}
+
+PerfCounters::~PerfCounters() {
+  for (const int fd : fds_) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+}
+
+bool PerfCounters::available() const {
+  for (const int fd : fds_) {
+    if (fd >= 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool PerfCounters::IsOpen(const PerfEvent event) const {
+  return fds_[static_cast<size_t>(event)] >= 0;
+}
+
+PerfValues PerfCounters::Read() const {
+  PerfValues values;
+  for (size_t i = 0; i < kNumPerfEvents; ++i) {
+    if (fds_[i] >= 0) {
+      values.counts[i] = ReadEvent(fds_[i]);
+    }
+  }
+  return values;
+}
+
+void PerfCounters::Report(const PerfValues& values, const uint64_t units,
+                          const char* const unit_name,
+                          std::ostream* const os) const {
+  // Leave the caller's stream formatted as it was.
+  const std::ios_base::fmtflags flags = os->flags();
+  const std::streamsize precision = os->precision();
+  *os << std::fixed << std::setprecision(2);
+  for (size_t i = 0; i < kNumPerfEvents; ++i) {
+    const PerfEvent event = static_cast<PerfEvent>(i);
+    *os << "  " << std::left << std::setw(16) << PerfEventName(event)
+        << std::right;
+    if (!IsOpen(event)) {
+      *os << std::setw(16) << "n/a" << "\n";
+      continue;
+    }
+    *os << std::setw(16) << values[event];
+    if (units > 0) {
+      *os << std::setw(14) << static_cast<double>(values[event]) / units
+          << " /" << unit_name;
+    }
+    *os << "\n";
+  }
+  *os << "  " << std::left << std::setw(16) << "IPC" << std::right
+      << std::setw(16);
+  if (IsOpen(PerfEvent::kCycles) && IsOpen(PerfEvent::kInstructions)) {
+    *os << values.Ipc();
+  } else {
+    *os << "n/a";
+  }
+  os->flags(flags);
+  os->precision(precision);
+  *os << "\n" << std::flush;
+}
+
+}  // namespace runtime
+}  // namespace elsh
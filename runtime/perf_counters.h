@@ -0,0 +1,127 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_PERF_COUNTERS_H_
+#define RUNTIME_PERF_COUNTERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace elsh {
+namespace runtime {
+
+/// @brief Hardware events `PerfCounters` counts.
+enum class PerfEvent : uint8_t {
+  kCycles = 0,
+  kInstructions = 1,
+  kBranchMisses = 2,
+  kL1dMisses = 3,
+  kLlcMisses = 4,
+};
+
+constexpr size_t kNumPerfEvents = 5;
+
+const char* PerfEventName(const PerfEvent event);
+
+/// @brief Event counts of one region, zero for events that are not open.
+struct PerfValues {
+  uint64_t counts[kNumPerfEvents] = {};
+
+  uint64_t operator[](const PerfEvent event) const {
+    return counts[static_cast<size_t>(event)];
+  }
+  /// @brief Instructions per cycle, 0 without cycles.
+  double Ipc() const;
+
+  PerfValues& operator+=(const PerfValues& other);
+  /// @brief Per event difference, 0 where `other` is larger. Scaled counts of
+  /// multiplexed events are estimates and may go backwards between reads.
+  PerfValues operator-(const PerfValues& other) const;
+};
+
+/// @brief Hardware performance counters of the calling thread, read through
+/// Linux `perf_event_open`.
+///
+///   PerfCounters counters;
+///   PerfValues lex;
+///   {
+///     PerfCounters::ScopedRegion region(&counters, &lex);
+///     ...
+///   }
+///   counters.Report(lex, tokens.size(), "token", &std::cerr);
+///
+/// Every event is opened on its own, user space only, and counts from
+/// construction on. Events the kernel or the cpu do not offer, as in most
+/// containers and virtual machines, stay closed and read as zero; nothing
+/// else changes, so callers need no special case. When the kernel
+/// multiplexes the events, counts are scaled to the time they were enabled.
+class PerfCounters {
+ public:
+  PerfCounters();
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  /// @brief Add everything counted between construction and destruction to
+  /// `*total`.
+  class ScopedRegion {
+   public:
+    ScopedRegion(const PerfCounters* const counters, PerfValues* const total);
+    ~ScopedRegion();
+
+    ScopedRegion(const ScopedRegion&) = delete;
+    ScopedRegion& operator=(const ScopedRegion&) = delete;
+
+   private:
+    const PerfCounters* const counters_;
+    PerfValues* const total_;
+    const PerfValues start_;
+  };
+
+  /// @brief Whether at least one event is open.
+  bool available() const;
+  bool IsOpen(const PerfEvent event) const;
+  /// @brief Why the first event that failed to open did, empty if all are
+  /// open.
+  const std::string& error() const { return error_; }
+
+  /// @brief Counts since construction.
+  PerfValues Read() const;
+
+  /// @brief Print every event of `values`, in total and divided by `units`
+  /// (say tokens or ops, skipped if 0), and the IPC. Closed events print as
+  /// "n/a".
+  void Report(const PerfValues& values, const uint64_t units,
+              const char* const unit_name, std::ostream* const os) const;
+
+ private:
+  int fds_[kNumPerfEvents];
+  std::string error_;
+};
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_PERF_COUNTERS_H_
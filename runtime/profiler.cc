@@ -0,0 +1,212 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/profiler.h"
+
+#include <signal.h>
+#include <sys/time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <utility>
+#include <vector>
+
+namespace elsh {
+namespace runtime {
+namespace {
+std::atomic<uint32_t> g_pending_samples(0);
+std::atomic<bool> g_profiler_running(false);
+// Long scripts have far too many lines to list them all.
+constexpr size_t kMaxReportRows = 40;
+
+void OnProfilingSignal(int) {
+  g_pending_samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool ArmTimer(const int interval_us) {
+  itimerval timer;
+  timer.it_interval.tv_sec = interval_us / 1000000;
+  timer.it_interval.tv_usec = interval_us % 1000000;
+  timer.it_value = timer.it_interval;
+  return setitimer(ITIMER_PROF, &timer, nullptr) == 0;
+}
+
+// Executed entries with their index, most sampled first.
+std::vector<std::pair<size_t, Profiler::Entry>> SortedBySamples(
+    const std::vector<Profiler::Entry>& entries) {
+  std::vector<std::pair<size_t, Profiler::Entry>> sorted;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (entries[i].count > 0) {
+      sorted.emplace_back(i, entries[i]);
+    }
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const std::pair<size_t, Profiler::Entry>& a,
+               const std::pair<size_t, Profiler::Entry>& b) {
+              if (a.second.samples != b.second.samples) {
+                return a.second.samples > b.second.samples;
+              }
+              if (a.second.count != b.second.count) {
+                return a.second.count > b.second.count;
+              }
+              return a.first < b.first;
+            });
+  return sorted;
+}
+}  // namespace
+
+Profiler::Profiler(const int interval_us)
+    : interval_us_(std::max(interval_us, 1)) {}
+
+Profiler::~Profiler() { Stop(); }
+
+bool Profiler::Start() {
+  if (running_ || g_profiler_running.exchange(true)) {
+    return false;
+  }
+  struct sigaction action;
+  action.sa_handler = OnProfilingSignal;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGPROF, &action, &old_action_) != 0) {
+    g_profiler_running = false;
+    return false;
+  }
+  if (!ArmTimer(interval_us_)) {
+    sigaction(SIGPROF, &old_action_, nullptr);
+    g_profiler_running = false;
+    return false;
+  }
+  g_pending_samples = 0;
+  running_ = true;
+  return true;
+}
+
+void Profiler::Stop() {
+  if (!running_) {
+    return;
+  }
+  ArmTimer(0);
+  // A tick still pending must not reach the restored action, the default one
+  // terminates the process. Block it, take it and only then restore.
+  sigset_t prof;
+  sigemptyset(&prof);
+  sigaddset(&prof, SIGPROF);
+  sigset_t old_mask;
+  pthread_sigmask(SIG_BLOCK, &prof, &old_mask);
+  const timespec no_wait = {0, 0};
+  while (sigtimedwait(&prof, nullptr, &no_wait) == SIGPROF) {
+  }
+  sigaction(SIGPROF, &old_action_, nullptr);
+  pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+  running_ = false;
+  g_profiler_running = false;
+}
+
+uint64_t Profiler::TakePendingSamples() {
+  return running_ ? g_pending_samples.exchange(0, std::memory_order_relaxed)
+                  : 0;
+}
+
+void Profiler::Record(const int line, const uint16_t op) {
+  const uint64_t samples = TakePendingSamples();
+  // Tokens without a position are accounted to line 0.
+  const size_t line_index = line > 0 ? line : 0;
+  if (line_index >= lines_.size()) {
+    lines_.resize(std::max(line_index + 1, lines_.size() * 2));
+  }
+  if (op >= ops_.size()) {
+    ops_.resize(op + 1);
+  }
+  Entry& line_entry = lines_[line_index];
+  ++line_entry.count;
+  line_entry.samples += samples;
+  Entry& op_entry = ops_[op];
+  ++op_entry.count;
+  op_entry.samples += samples;
+  if (samples > 0) {
+    total_samples_ += samples;
+    locations_[static_cast<uint64_t>(line_index) << 16 | op] += samples;
+  }
+}
+
+Profiler::Entry Profiler::line(const int line) const {
+  return line >= 0 && static_cast<size_t>(line) < lines_.size() ? lines_[line]
+                                                                : Entry();
+}
+
+Profiler::Entry Profiler::op(const uint16_t op) const {
+  return op < ops_.size() ? ops_[op] : Entry();
+}
+
+void Profiler::Report(const OpNamer& op_namer, std::ostream* const os) const {
+  const double ms_per_sample = interval_us_ / 1000.;
+  // Leave the caller's stream formatted as it was.
+  const std::ios_base::fmtflags flags = os->flags();
+  const std::streamsize precision = os->precision();
+  *os << "Samples: " << total_samples_ << " (every " << interval_us_
+      << "us of cpu time)\n\n";
+  *os << std::setw(8) << "Line" << std::setw(14) << "Count" << std::setw(10)
+      << "Samples" << std::setw(12) << "Time(ms)" << "\n";
+  const auto sorted_lines = SortedBySamples(lines_);
+  for (size_t i = 0; i < sorted_lines.size() && i < kMaxReportRows; ++i) {
+    const auto& line = sorted_lines[i];
+    *os << std::setw(8) << line.first << std::setw(14) << line.second.count
+        << std::setw(10) << line.second.samples << std::setw(12)
+        << std::fixed << std::setprecision(1)
+        << line.second.samples * ms_per_sample << "\n";
+  }
+  if (sorted_lines.size() > kMaxReportRows) {
+    *os << std::setw(8) << "..." << " " << sorted_lines.size() - kMaxReportRows
+        << " more lines\n";
+  }
+  *os << "\n"
+      << std::setw(25) << "Op" << std::setw(14) << "Count" << std::setw(10)
+      << "Samples" << std::setw(12) << "Time(ms)" << "\n";
+  for (const auto& op : SortedBySamples(ops_)) {
+    *os << std::setw(25) << op_namer(static_cast<uint16_t>(op.first))
+        << std::setw(14) << op.second.count << std::setw(10)
+        << op.second.samples << std::setw(12) << std::fixed
+        << std::setprecision(1) << op.second.samples * ms_per_sample << "\n";
+  }
+  os->flags(flags);
+  os->precision(precision);
+  *os << std::flush;
+}
+
+void Profiler::WriteFolded(const std::string& root, const OpNamer& op_namer,
+                           std::ostream* const os) const {
+  std::vector<std::pair<uint64_t, uint64_t>> sorted(locations_.begin(),
+                                                    locations_.end());
+  std::sort(sorted.begin(), sorted.end());
+  for (const auto& location : sorted) {
+    const int line = static_cast<int32_t>(location.first >> 16);
+    const uint16_t op = static_cast<uint16_t>(location.first & 0xffff);
+    *os << root << ";line " << line << ";" << op_namer(op) << " "
+        << location.second << "\n";
+  }
+  *os << std::flush;
+}
+
+}  // namespace runtime
+}  // namespace elsh
@@ -0,0 +1,105 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_PROFILER_H_
+#define RUNTIME_PROFILER_H_
+
+#include <signal.h>
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace elsh {
+namespace runtime {
+
+/// @brief Sampling profiler keyed by source line and opcode.
+///
+/// While started, a `SIGPROF` interval timer ticks on consumed CPU time and
+/// the signal handler only bumps a counter. Every `Record()` call counts one
+/// execution of (line, op) and charges the ticks seen since the previous call
+/// to it, so the cost per execution is two array increments and nothing at
+/// all when the profiler is not used.
+///
+/// Only one profiler can be started at a time, the timer is process wide.
+class Profiler {
+ public:
+  using OpNamer = std::function<std::string(const uint16_t op)>;
+
+  struct Entry {
+    uint64_t count = 0;
+    uint64_t samples = 0;
+  };
+
+  explicit Profiler(const int interval_us = 1000);
+  ~Profiler();
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  /// @brief Install the signal handler and arm the timer. Return false if
+  /// another profiler is running or the timer can not be armed.
+  bool Start();
+  /// @brief Disarm the timer, drop the samples still pending and give
+  /// `SIGPROF` back to the action installed before `Start`.
+  void Stop();
+
+  /// @brief Account one execution of `op` at source line `line`.
+  void Record(const int line, const uint16_t op);
+
+  /// @brief Print per line and per op tables, most sampled first. Only the
+  /// hottest lines are listed.
+  void Report(const OpNamer& op_namer, std::ostream* const os) const;
+  /// @brief Write samples in Brendan Gregg's folded stack format, one
+  /// "root;line N;op samples" line per sampled location, ready for
+  /// flamegraph.pl.
+  void WriteFolded(const std::string& root, const OpNamer& op_namer,
+                   std::ostream* const os) const;
+
+  Entry line(const int line) const;
+  Entry op(const uint16_t op) const;
+  uint64_t total_samples() const { return total_samples_; }
+  int interval_us() const { return interval_us_; }
+
+ private:
+  uint64_t TakePendingSamples();
+
+ private:
+  const int interval_us_;
+  bool running_ = false;
+  // The host's `SIGPROF` action, restored by `Stop`.
+  struct sigaction old_action_;
+  uint64_t total_samples_ = 0;
+  // Both indexed directly, lines and ops are small dense integers.
+  std::vector<Entry> lines_;
+  std::vector<Entry> ops_;
+  // Samples per (line, op), key is line << 16 | op.
+  std::unordered_map<uint64_t, uint64_t> locations_;
+};
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_PROFILER_H_
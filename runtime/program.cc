@@ -0,0 +1,146 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/program.h"
+
+#include <sstream>
+#include <utility>
+
+#include "lex/token_loader.h"
+#include "runtime/token_printer.h"
+
+namespace elsh {
+namespace runtime {
+
+constexpr int Program::kNoSlot;
+
+std::shared_ptr<const Program> Program::Compile(const std::string& source,
+                                                std::string* const error) {
+  std::istringstream ss(source);
+  lex::TokenLoader loader(&ss);
+  std::shared_ptr<Program> program(new Program);
+  program->tokens_ = loader.GetAllTokens();
+
+  const lex::Token& last = program->tokens_.back();
+  if (last.tok_type == lex::TokenType::kTokenUnknown) {
+    if (error != nullptr) {
+      *error = "line " + std::to_string(last.err_ln) + ", col " +
+               std::to_string(last.err_col) + ": " + last.str;
+    }
+    return nullptr;
+  }
+
+  program->token_slots_.reserve(program->tokens_.size());
+  for (const auto& token : program->tokens_) {
+    if (token.tok_type != lex::TokenType::kTokenIdentifier) {
+      program->token_slots_.push_back(kNoSlot);
+      continue;
+    }
+    const auto it = program->slot_index_.emplace(
+        token.str, static_cast<int>(program->slot_names_.size()));
+    if (it.second) {
+      program->slot_names_.push_back(token.str);
+    }
+    program->token_slots_.push_back(it.first->second);
+  }
+  return program;
+}
+
+int Program::FindSlot(const std::string& name) const {
+  const auto it = slot_index_.find(name);
+  return it == slot_index_.end() ? kNoSlot : it->second;
+}
+
+Context::Context(std::shared_ptr<const Program> program, const int output_fd,
+                 const size_t output_capacity)
+    : program_(std::move(program)),
+      registers_(program_->num_slots()),
+      bound_(program_->num_slots(), false),
+      output_(output_fd, output_capacity) {}
+
+bool Context::SetInput(const std::string& name, const int64_t value) {
+  lex::Token token(lex::TokenType::kTokenValueInt, -1, -1);
+  token.value_int = value;
+  return Bind(name, token);
+}
+
+bool Context::SetInput(const std::string& name, const double value) {
+  return Bind(name,
+              lex::Token(lex::TokenType::kTokenValueDouble, -1, -1, value));
+}
+
+bool Context::SetInput(const std::string& name, const std::string& value) {
+  return Bind(name,
+              lex::Token(lex::TokenType::kTokenValueString, -1, -1, value));
+}
+
+void Context::ClearInputs() { bound_.assign(bound_.size(), false); }
+
+bool Context::Bind(const std::string& name, const lex::Token& value) {
+  const int slot = program_->FindSlot(name);
+  if (slot == Program::kNoSlot) {
+    return false;
+  }
+  registers_[slot] = value;
+  bound_[slot] = true;
+  return true;
+}
+
+bool Context::Run() {
+  const auto& tokens = program_->tokens();
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    Step(i);
+  }
+  pc_ = 0;
+  return output_.Flush();
+}
+
+Context::RunState Context::Resume(int64_t* const fuel) {
+  const size_t size = program_->tokens().size();
+  while (pc_ < size) {
+    if (*fuel <= 0) {
+      return RunState::kPreempted;
+    }
+    --*fuel;
+    Step(pc_++);
+  }
+  pc_ = 0;
+  return output_.Flush() ? RunState::kDone : RunState::kFailed;
+}
+
+void Context::Step(const size_t index) {
+  const lex::Token& token = program_->tokens()[index];
+  const int slot = program_->token_slot(index);
+  if (slot == Program::kNoSlot || !bound_[slot]) {
+    PrintToken(token, &output_);
+    return;
+  }
+  // The register is ours, so report the value at the identifier's position
+  // without copying it.
+  lex::Token& value = registers_[slot];
+  value.err_ln = token.err_ln;
+  value.err_col = token.err_col;
+  PrintToken(value, &output_);
+}
+
+}  // namespace runtime
+}  // namespace elsh
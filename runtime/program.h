@@ -0,0 +1,132 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_PROGRAM_H_
+#define RUNTIME_PROGRAM_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "lex/types.h"
+#include "runtime/output_buffer.h"
+
+namespace elsh {
+namespace runtime {
+
+/// @brief Embedding API. A script is compiled once into an immutable
+/// `Program`, which any number of threads may then run at the same time, each
+/// in its own `Context`:
+///
+///   std::string error;
+///   const auto program = Program::Compile(source, &error);
+///   // On every thread:
+///   Context context(program, fd);
+///   context.SetInput("limit", int64_t{100});
+///   context.Run();
+///
+/// Everything a run touches is either owned by its context or read-only in the
+/// program, name lookups happen in `Compile` and `SetInput` only.
+class Program {
+ public:
+  static constexpr int kNoSlot = -1;
+
+  /// @brief Return nullptr and describe the first lexical error in `error` if
+  /// `source` is not valid.
+  static std::shared_ptr<const Program> Compile(const std::string& source,
+                                                std::string* const error);
+
+  const std::vector<lex::Token>& tokens() const { return tokens_; }
+  /// @brief Slot of the identifier at token `index`, `kNoSlot` for every
+  /// other token.
+  int token_slot(const size_t index) const { return token_slots_[index]; }
+  /// @brief Slot of the identifier `name`, `kNoSlot` if the program never
+  /// uses it.
+  int FindSlot(const std::string& name) const;
+  size_t num_slots() const { return slot_names_.size(); }
+  const std::string& slot_name(const int slot) const {
+    return slot_names_[slot];
+  }
+
+ private:
+  Program() = default;
+
+ private:
+  std::vector<lex::Token> tokens_;
+  std::vector<int> token_slots_;
+  std::vector<std::string> slot_names_;
+  std::unordered_map<std::string, int> slot_index_;
+};
+
+/// @brief Per run state: input registers and the output sink. Cheap to create,
+/// not shareable between threads.
+///
+/// A context has no heap of its own yet: a run creates no values, host
+/// strings are copied into their registers when they are bound. Token names
+/// come from the constant table of `lex::TokenName`.
+class Context {
+ public:
+  enum class RunState { kDone, kPreempted, kFailed };
+
+  Context(std::shared_ptr<const Program> program, const int output_fd,
+          const size_t output_capacity = OutputBuffer::kDefaultCapacity);
+
+  /// @brief Bind a host value to the identifier `name`. Return false if the
+  /// program does not use `name`.
+  bool SetInput(const std::string& name, const int64_t value);
+  bool SetInput(const std::string& name, const double value);
+  bool SetInput(const std::string& name, const std::string& value);
+  void ClearInputs();
+
+  /// @brief Run the program. Identifiers bound with `SetInput` are replaced by
+  /// their values. Return false if writing the output failed.
+  bool Run();
+
+  /// @brief Run on from where the last call stopped, charging one unit of
+  /// `fuel` for every step, that is every token of the program. A preempted
+  /// run resumes at the step it stopped before. Return `kPreempted` once
+  /// `fuel` is used up, `kFailed` if writing the output failed, and `kDone`
+  /// at the end of the program, after which the next call starts over.
+  RunState Resume(int64_t* const fuel);
+
+  OutputBuffer* output() { return &output_; }
+
+ private:
+  bool Bind(const std::string& name, const lex::Token& value);
+  void Step(const size_t index);
+
+ private:
+  const std::shared_ptr<const Program> program_;
+  // One register per program slot.
+  std::vector<lex::Token> registers_;
+  std::vector<bool> bound_;
+  // Next token to run, for resuming preempted runs.
+  size_t pc_ = 0;
+  OutputBuffer output_;
+};
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_PROGRAM_H_
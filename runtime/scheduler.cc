@@ -0,0 +1,144 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "runtime/stats.h"
+
+namespace elsh {
+namespace runtime {
+
+Scheduler::Scheduler(const int num_workers) {
+  for (int i = 0; i < std::max(num_workers, 1); ++i) {
+    workers_.emplace_back(&Scheduler::WorkerLoop, this);
+  }
+}
+
+Scheduler::~Scheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+int Scheduler::Submit(const Slice& slice, const Limits& limits) {
+  std::unique_ptr<Script> script(new Script);
+  script->slice = slice;
+  script->limits = limits;
+  int id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    id = static_cast<int>(scripts_.size());
+    scripts_.push_back(std::move(script));
+    run_queue_.push_back(id);
+    ++unfinished_;
+  }
+  work_cv_.notify_one();
+  return id;
+}
+
+int Scheduler::Submit(std::shared_ptr<Context> context, const Limits& limits) {
+  return Submit(
+      [context](int64_t* const fuel) { return context->Resume(fuel); },
+      limits);
+}
+
+void Scheduler::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_cv_.wait(lock, [this]() { return unfinished_ == 0; });
+}
+
+Scheduler::Status Scheduler::status(const int id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return scripts_[id]->status;
+}
+
+std::vector<int> Scheduler::finish_order() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return finish_order_;
+}
+
+void Scheduler::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    work_cv_.wait(lock, [this]() { return stop_ || !run_queue_.empty(); });
+    if (stop_) {
+      return;
+    }
+    const int id = run_queue_.front();
+    run_queue_.pop_front();
+    Script* const script = scripts_[id].get();
+    lock.unlock();
+    const bool runnable = RunSlice(script);
+    lock.lock();
+    if (runnable) {
+      run_queue_.push_back(id);
+      continue;
+    }
+    finish_order_.push_back(id);
+    if (--unfinished_ == 0) {
+      idle_cv_.notify_all();
+    }
+  }
+}
+
+bool Scheduler::RunSlice(Script* const script) {
+  const Limits& limits = script->limits;
+  Status* const status = &script->status;
+  // A slice without fuel would never make progress nor use up `max_fuel`.
+  int64_t budget = std::max<int64_t>(limits.slice_fuel, 1);
+  if (limits.max_fuel >= 0) {
+    budget = std::min(budget, limits.max_fuel - status->fuel_used);
+  }
+  int64_t fuel = budget;
+  const int64_t live_bytes = ThreadLiveBytes();
+  const Context::RunState state = script->slice(&fuel);
+  status->live_bytes += ThreadLiveBytes() - live_bytes;
+  status->fuel_used += budget - fuel;
+  ++status->slices;
+
+  if (state == Context::RunState::kDone) {
+    status->outcome = Outcome::kDone;
+  } else if (state == Context::RunState::kFailed) {
+    status->outcome = Outcome::kFailed;
+  } else if (limits.max_memory >= 0 &&
+             status->live_bytes > limits.max_memory) {
+    status->outcome = Outcome::kOutOfMemory;
+  } else if (limits.max_fuel >= 0 && status->fuel_used >= limits.max_fuel) {
+    status->outcome = Outcome::kOutOfFuel;
+  } else {
+    return true;
+  }
+  // Drop the script's state now rather than when the scheduler goes away.
+  script->slice = Slice();
+  return false;
+}
+
+}  // namespace runtime
+}  // namespace elsh
@@ -0,0 +1,130 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_SCHEDULER_H_
+#define RUNTIME_SCHEDULER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "runtime/program.h"
+
+namespace elsh {
+namespace runtime {
+
+/// @brief M:N scheduler running many scripts as green threads on a fixed set
+/// of workers.
+///
+/// A script runs in slices of `Limits::slice_fuel` steps. When a slice runs
+/// out of fuel the script goes to the back of the run queue, so a runaway
+/// loop only ever delays the others by one slice per round. Scripts are
+/// stopped for good once they used up `max_fuel` in total or hold more than
+/// `max_memory` heap bytes at the end of a slice.
+///
+/// `max_memory` is a soft limit: it is only checked between slices, so a
+/// script may overshoot it by whatever it allocates within one slice. Keep
+/// `slice_fuel` small where that matters.
+///
+///   Scheduler scheduler(4);
+///   for (...) {
+///     scheduler.Submit(std::make_shared<Context>(program, fd), limits);
+///   }
+///   scheduler.Wait();
+class Scheduler {
+ public:
+  /// @brief One slice of a script: run on until `*fuel` is used up.
+  using Slice = std::function<Context::RunState(int64_t* const fuel)>;
+
+  struct Limits {
+    /// @brief Steps per slice, values below 1 count as 1.
+    int64_t slice_fuel = 10000;
+    /// @brief Negative for no limit.
+    int64_t max_fuel = -1;
+    int64_t max_memory = -1;
+  };
+
+  enum class Outcome { kPending, kDone, kFailed, kOutOfFuel, kOutOfMemory };
+
+  struct Status {
+    Outcome outcome = Outcome::kPending;
+    int64_t fuel_used = 0;
+    int64_t slices = 0;
+    int64_t live_bytes = 0;
+  };
+
+  /// @brief `num_workers` threads, at least one.
+  explicit Scheduler(const int num_workers);
+  ~Scheduler();
+
+  Scheduler(const Scheduler&) = delete;
+  Scheduler& operator=(const Scheduler&) = delete;
+
+  /// @brief Queue a script and return its id for `status`.
+  int Submit(const Slice& slice, const Limits& limits);
+  int Submit(std::shared_ptr<Context> context, const Limits& limits);
+
+  /// @brief Block until every submitted script has finished.
+  void Wait();
+
+  /// @brief State of script `id`. Only valid while no script runs, that is
+  /// after `Wait` returned.
+  Status status(const int id) const;
+  /// @brief Ids in the order the scripts finished.
+  std::vector<int> finish_order() const;
+
+ private:
+  struct Script {
+    Slice slice;
+    Limits limits;
+    Status status;
+  };
+
+  void WorkerLoop();
+  /// @brief Run one slice of `script`, return whether it should be queued
+  /// again.
+  bool RunSlice(Script* const script);
+
+ private:
+  std::vector<std::thread> workers_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable idle_cv_;
+  // Scripts are only touched by the worker that popped them, their slots in
+  // `scripts_` never move.
+  std::deque<std::unique_ptr<Script>> scripts_;
+  std::deque<int> run_queue_;
+  std::vector<int> finish_order_;
+  int unfinished_ = 0;
+  bool stop_ = false;
+};
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_SCHEDULER_H_
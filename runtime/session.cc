@@ -0,0 +1,128 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/session.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "lex/token_loader.h"
+#include "runtime/token_printer.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+bool IsLiteral(const lex::TokenType type) {
+  return type == lex::TokenType::kTokenValueInt ||
+         type == lex::TokenType::kTokenValueDouble ||
+         type == lex::TokenType::kTokenValueChar ||
+         type == lex::TokenType::kTokenValueString ||
+         type == lex::TokenType::kTokenValueBool;
+}
+
+}  // namespace
+
+Session::Session(const int output_fd) : output_(output_fd) {
+  output_.SetLineBuffered(output_.IsTerminal());
+}
+
+bool Session::Eval(const std::string& input, std::string* const error) {
+  std::istringstream ss(input);
+  lex::TokenLoader loader(&ss, next_line_);
+  std::vector<lex::Token> tokens = loader.GetAllTokens();
+  next_line_ += static_cast<int>(std::count(input.begin(), input.end(), '\n'));
+  if (input.empty() || input.back() != '\n') {
+    ++next_line_;
+  }
+  const lex::Token& last = tokens.back();
+  if (last.tok_type == lex::TokenType::kTokenUnknown) {
+    if (error != nullptr) {
+      *error = "line " + std::to_string(last.err_ln) + ", col " +
+               std::to_string(last.err_col) + ": " + last.str;
+    }
+    return false;
+  }
+  tokens.pop_back();
+
+  const size_t begin = tokens_.size();
+  for (auto& token : tokens) {
+    token_slots_.push_back(token.tok_type == lex::TokenType::kTokenIdentifier
+                               ? ResolveSlot(token.str)
+                               : -1);
+    tokens_.push_back(std::move(token));
+  }
+  Run(begin);
+  return output_.Flush();
+}
+
+int Session::FindSlot(const std::string& name) const {
+  const auto it = slot_index_.find(name);
+  return it == slot_index_.end() ? -1 : it->second;
+}
+
+bool Session::IsBound(const std::string& name) const {
+  const int slot = FindSlot(name);
+  return slot >= 0 && bound_[slot];
+}
+
+int Session::ResolveSlot(const std::string& name) {
+  const auto it =
+      slot_index_.emplace(name, static_cast<int>(slot_names_.size()));
+  if (it.second) {
+    slot_names_.push_back(name);
+    registers_.emplace_back();
+    bound_.push_back(false);
+  }
+  return it.first->second;
+}
+
+void Session::Run(const size_t begin) {
+  for (size_t i = begin; i < tokens_.size(); ++i) {
+    const int slot = token_slots_[i];
+    if (slot < 0) {
+      PrintToken(tokens_[i], &output_);
+      continue;
+    }
+    if (i + 3 < tokens_.size() &&
+        tokens_[i + 1].tok_type == lex::TokenType::kTokenOpAssign &&
+        IsLiteral(tokens_[i + 2].tok_type) &&
+        tokens_[i + 3].tok_type == lex::TokenType::kTokenSymSemiColon) {
+      // The target of a definition is printed as written.
+      registers_[slot] = tokens_[i + 2];
+      bound_[slot] = true;
+      PrintToken(tokens_[i], &output_);
+      continue;
+    }
+    if (!bound_[slot]) {
+      PrintToken(tokens_[i], &output_);
+      continue;
+    }
+    lex::Token& value = registers_[slot];
+    value.err_ln = tokens_[i].err_ln;
+    value.err_col = tokens_[i].err_col;
+    PrintToken(value, &output_);
+  }
+}
+
+}  // namespace runtime
+}  // namespace elsh
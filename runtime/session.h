@@ -0,0 +1,90 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_SESSION_H_
+#define RUNTIME_SESSION_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "lex/types.h"
+#include "runtime/output_buffer.h"
+
+namespace elsh {
+namespace runtime {
+
+/// @brief State of an interactive session: the symbol table, the code of all
+/// inputs so far and the values of the session's variables.
+///
+/// Every input is lexed and resolved on its own and then run. Nothing that
+/// came before is looked at again, so the cost of an input only depends on
+/// its own size, not on the length of the session:
+///
+///   Session session(STDOUT_FILENO);
+///   session.Eval("limit = 10;", &error);
+///   session.Eval("print(limit);", &error);  // prints Value_int 10
+///
+/// `name = <literal>;` binds `name` for the rest of the session, running an
+/// input prints its tokens with bound names replaced by their values, the
+/// same way `Context::Run` does.
+class Session {
+ public:
+  explicit Session(const int output_fd);
+
+  /// @brief Lex, resolve and run `input`. On a lexical error describe it in
+  /// `error` and leave the symbols, code and values as they were, the input
+  /// still counts its lines.
+  bool Eval(const std::string& input, std::string* const error);
+
+  /// @brief Line the next input starts at.
+  int next_line() const { return next_line_; }
+  /// @brief Tokens of all inputs so far, without their end markers.
+  const std::vector<lex::Token>& tokens() const { return tokens_; }
+  size_t num_slots() const { return slot_names_.size(); }
+  /// @brief Slot of `name`, -1 if no input used it.
+  int FindSlot(const std::string& name) const;
+  /// @brief Whether a value is bound to `name`.
+  bool IsBound(const std::string& name) const;
+
+  OutputBuffer* output() { return &output_; }
+
+ private:
+  int ResolveSlot(const std::string& name);
+  /// @brief Run the tokens from `begin` on.
+  void Run(const size_t begin);
+
+ private:
+  int next_line_ = 1;
+  std::vector<lex::Token> tokens_;
+  std::vector<int> token_slots_;
+  std::vector<std::string> slot_names_;
+  std::unordered_map<std::string, int> slot_index_;
+  std::vector<lex::Token> registers_;
+  std::vector<bool> bound_;
+  OutputBuffer output_;
+};
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_SESSION_H_
@@ -0,0 +1,145 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/stats.h"
+
+#include <iomanip>
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+// `, "perf": {...}` with null for the events that are not open.
+void WritePerfJson(const PerfCounters& counters, const PerfValues& perf,
+                   std::ostream* const os) {
+  *os << ", \"perf\": {";
+  for (size_t i = 0; i < kNumPerfEvents; ++i) {
+    const PerfEvent event = static_cast<PerfEvent>(i);
+    *os << (i == 0 ? "" : ", ") << "\"" << PerfEventName(event) << "\": ";
+    if (counters.IsOpen(event)) {
+      *os << perf[event];
+    } else {
+      *os << "null";
+    }
+  }
+  *os << "}";
+}
+
+}  // namespace
+
+Stats::ScopedPhase::ScopedPhase(Stats* const stats, const char* const name)
+    : stats_(stats),
+      name_(name),
+      start_(std::chrono::steady_clock::now()),
+      start_allocations_(AllocationCount()),
+      start_allocated_bytes_(AllocatedBytes()),
+      start_perf_(stats->perf_counters_ != nullptr
+                      ? stats->perf_counters_->Read()
+                      : PerfValues()) {}
+
+Stats::ScopedPhase::~ScopedPhase() {
+  const auto wall = std::chrono::steady_clock::now() - start_;
+  // Read the counters before `Add`, which may allocate itself.
+  const uint64_t allocations = AllocationCount() - start_allocations_;
+  const uint64_t allocated_bytes = AllocatedBytes() - start_allocated_bytes_;
+  const PerfValues perf = stats_->perf_counters_ != nullptr
+                              ? stats_->perf_counters_->Read() - start_perf_
+                              : PerfValues();
+  stats_->Add(
+      name_,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(wall).count(),
+      allocations, allocated_bytes, perf);
+}
+
+void Stats::Add(const char* const name, const uint64_t wall_ns,
+                const uint64_t allocations, const uint64_t allocated_bytes,
+                const PerfValues& perf) {
+  Phase* phase = nullptr;
+  for (auto& existing : phases_) {
+    if (existing.name == name) {
+      phase = &existing;
+      break;
+    }
+  }
+  if (phase == nullptr) {
+    phases_.emplace_back();
+    phase = &phases_.back();
+    phase->name = name;
+  }
+  phase->wall_ns += wall_ns;
+  phase->allocations += allocations;
+  phase->allocated_bytes += allocated_bytes;
+  phase->perf += perf;
+}
+
+Stats::Phase Stats::Total() const {
+  Phase total;
+  total.name = "total";
+  for (const auto& phase : phases_) {
+    total.wall_ns += phase.wall_ns;
+    total.allocations += phase.allocations;
+    total.allocated_bytes += phase.allocated_bytes;
+    total.perf += phase.perf;
+  }
+  return total;
+}
+
+void Stats::Report(std::ostream* const os) const {
+  *os << std::setw(12) << "Phase" << std::setw(14) << "Wall(ms)"
+      << std::setw(14) << "Allocations" << std::setw(16) << "Bytes" << "\n";
+  std::vector<Phase> rows = phases_;
+  rows.push_back(Total());
+  for (const auto& phase : rows) {
+    *os << std::setw(12) << phase.name << std::setw(14) << std::fixed
+        << std::setprecision(3) << phase.wall_ns / 1e6 << std::setw(14)
+        << phase.allocations << std::setw(16) << phase.allocated_bytes
+        << "\n";
+  }
+  *os << std::flush;
+}
+
+void Stats::WriteJson(std::ostream* const os) const {
+  *os << "{\"phases\": [";
+  for (size_t i = 0; i < phases_.size(); ++i) {
+    const auto& phase = phases_[i];
+    // Phase names are identifiers chosen by the caller, nothing to escape.
+    *os << (i == 0 ? "" : ", ") << "{\"name\": \"" << phase.name
+        << "\", \"wall_ns\": " << phase.wall_ns
+        << ", \"allocations\": " << phase.allocations
+        << ", \"allocated_bytes\": " << phase.allocated_bytes;
+    if (perf_counters_ != nullptr) {
+      WritePerfJson(*perf_counters_, phase.perf, os);
+    }
+    *os << "}";
+  }
+  const Phase total = Total();
+  *os << "], \"total\": {\"wall_ns\": " << total.wall_ns
+      << ", \"allocations\": " << total.allocations
+      << ", \"allocated_bytes\": " << total.allocated_bytes;
+  if (perf_counters_ != nullptr) {
+    WritePerfJson(*perf_counters_, total.perf, os);
+  }
+  *os << "}}\n" << std::flush;
+}
+
+}  // namespace runtime
+}  // namespace elsh
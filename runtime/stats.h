@@ -0,0 +1,116 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_STATS_H_
+#define RUNTIME_STATS_H_
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "runtime/perf_counters.h"
+
+namespace elsh {
+namespace runtime {
+
+/// @brief Process wide heap allocation counters, maintained by the replacement
+/// `operator new` linked in together with `Stats`. Each thread counts its own
+/// allocations without locked instructions, so they are cheap enough to stay
+/// enabled in production builds; reading sums over all threads under a lock.
+uint64_t AllocationCount();
+uint64_t AllocatedBytes();
+/// @brief Bytes the calling thread allocated minus the bytes it freed, in
+/// allocator block sizes. Memory freed by another thread than the one that
+/// allocated it moves between the two threads' counts, so only differences
+/// taken on one thread are meaningful. Always 0 outside glibc, which is the
+/// only allocator this build can ask for block sizes.
+int64_t ThreadLiveBytes();
+
+/// @brief Wall time and heap allocations per pipeline phase.
+///
+///   Stats stats;
+///   {
+///     Stats::ScopedPhase phase(&stats, "lex");
+///     ...
+///   }
+///   stats.Report(&std::cerr);
+///
+/// With `set_perf_counters`, phases also collect hardware counters.
+class Stats {
+ public:
+  struct Phase {
+    std::string name;
+    uint64_t wall_ns = 0;
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+    PerfValues perf;
+  };
+
+  /// @brief Account everything between construction and destruction to the
+  /// phase `name`. Phases with the same name accumulate.
+  class ScopedPhase {
+   public:
+    ScopedPhase(Stats* const stats, const char* const name);
+    ~ScopedPhase();
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+   private:
+    Stats* const stats_;
+    const char* const name_;
+    const std::chrono::steady_clock::time_point start_;
+    const uint64_t start_allocations_;
+    const uint64_t start_allocated_bytes_;
+    const PerfValues start_perf_;
+  };
+
+  /// @brief Phases in order of their first appearance.
+  const std::vector<Phase>& phases() const { return phases_; }
+  Phase Total() const;
+
+  /// @brief Counters phases read from now on, null to stop. Must outlive the
+  /// phases.
+  void set_perf_counters(const PerfCounters* const perf_counters) {
+    perf_counters_ = perf_counters;
+  }
+  const PerfCounters* perf_counters() const { return perf_counters_; }
+
+  void Report(std::ostream* const os) const;
+  void WriteJson(std::ostream* const os) const;
+
+ private:
+  void Add(const char* const name, const uint64_t wall_ns,
+           const uint64_t allocations, const uint64_t allocated_bytes,
+           const PerfValues& perf);
+
+ private:
+  std::vector<Phase> phases_;
+  const PerfCounters* perf_counters_ = nullptr;
+};
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_STATS_H_
@@ -0,0 +1,319 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/string_kernels.h"
+
+#include <cstring>
+
+#include "lex/simd_targets.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+size_t Offset(const size_t base, const size_t found) {
+  return found == kNotFound ? kNotFound : base + found;
+}
+
+// Scalar kernels, used as they are on other architectures and for the tails
+// of the vectorized ones. memchr is the fastest portable way to find a byte.
+
+size_t FindByteScalar(const char* const data, const size_t size,
+                      const char c) {
+  if (size == 0) {
+    return kNotFound;
+  }
+  const void* const found = memchr(data, c, size);
+  return found == nullptr ? kNotFound
+                          : static_cast<const char*>(found) - data;
+}
+
+size_t CountByteScalar(const char* const data, const size_t size,
+                       const char c) {
+  size_t count = 0;
+  for (size_t i = 0; i < size; ++i) {
+    count += data[i] == c;
+  }
+  return count;
+}
+
+size_t FindScalar(const char* const data, const size_t size,
+                  const char* const needle, const size_t needle_size) {
+  if (needle_size > size) {
+    return kNotFound;
+  }
+  // Candidates are the first bytes of the needle, up to the last position the
+  // needle still fits at.
+  const size_t candidates = size - needle_size + 1;
+  size_t i = 0;
+  while (i < candidates) {
+    const size_t found = FindByteScalar(data + i, candidates - i, needle[0]);
+    if (found == kNotFound) {
+      return kNotFound;
+    }
+    i += found;
+    if (memcmp(data + i + 1, needle + 1, needle_size - 1) == 0) {
+      return i;
+    }
+    ++i;
+  }
+  return kNotFound;
+}
+
+const StringKernels kScalarKernels = {FindByteScalar, CountByteScalar,
+                                      FindScalar};
+
+#ifdef ELSH_X86_KERNELS
+
+// SSE2, 16 bytes per instruction.
+
+// Four blocks are compared per step and only checked one by one once any of
+// them matches, as the loop is bound by the branch otherwise.
+ELSH_TARGET_SSE2 size_t FindByteSse2(const char* const data, const size_t size,
+                                     const char c) {
+  const __m128i v = _mm_set1_epi8(c);
+  const __m128i* const blocks = reinterpret_cast<const __m128i*>(data);
+  size_t i = 0;
+  for (; i + 64 <= size; i += 64) {
+    const __m128i* const step = blocks + i / 16;
+    const __m128i eq0 = _mm_cmpeq_epi8(_mm_loadu_si128(step), v);
+    const __m128i eq1 = _mm_cmpeq_epi8(_mm_loadu_si128(step + 1), v);
+    const __m128i eq2 = _mm_cmpeq_epi8(_mm_loadu_si128(step + 2), v);
+    const __m128i eq3 = _mm_cmpeq_epi8(_mm_loadu_si128(step + 3), v);
+    if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(eq0, eq1),
+                                       _mm_or_si128(eq2, eq3))) != 0) {
+      break;
+    }
+  }
+  for (; i + 16 <= size; i += 16) {
+    const int mask = _mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_loadu_si128(blocks + i / 16), v));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return Offset(i, FindByteScalar(data + i, size - i, c));
+}
+
+// Matches subtract -1 from per-byte counters, which are summed up with psadbw
+// before any of them can overflow.
+ELSH_TARGET_SSE2 size_t CountByteSse2(const char* const data,
+                                      const size_t size, const char c) {
+  const __m128i v = _mm_set1_epi8(c);
+  const __m128i zero = _mm_setzero_si128();
+  __m128i total = zero;
+  size_t i = 0;
+  while (i + 16 <= size) {
+    __m128i counts = zero;
+    for (int step = 0; step < 255 && i + 16 <= size; ++step, i += 16) {
+      const __m128i block =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+      counts = _mm_sub_epi8(counts, _mm_cmpeq_epi8(block, v));
+    }
+    total = _mm_add_epi64(total, _mm_sad_epu8(counts, zero));
+  }
+  uint64_t lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), total);
+  return lanes[0] + lanes[1] + CountByteScalar(data + i, size - i, c);
+}
+
+ELSH_TARGET_SSE2 size_t FindSse2(const char* const data, const size_t size,
+                                 const char* const needle,
+                                 const size_t needle_size) {
+  if (needle_size > size) {
+    return kNotFound;
+  }
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i last = _mm_set1_epi8(needle[needle_size - 1]);
+  size_t i = 0;
+  // 16 candidate positions per step, their last bytes are loaded from
+  // `needle_size - 1` further on.
+  for (; i + needle_size - 1 + 16 <= size; i += 16) {
+    const __m128i block_first =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i block_last = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(data + i + needle_size - 1));
+    uint32_t mask = _mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last)));
+    while (mask != 0) {
+      const size_t candidate = i + __builtin_ctz(mask);
+      if (memcmp(data + candidate + 1, needle + 1, needle_size - 2) == 0) {
+        return candidate;
+      }
+      mask &= mask - 1;
+    }
+  }
+  return Offset(i, FindScalar(data + i, size - i, needle, needle_size));
+}
+
+const StringKernels kSse2Kernels = {FindByteSse2, CountByteSse2, FindSse2};
+
+// AVX2, 32 bytes per instruction.
+
+ELSH_TARGET_AVX2 size_t FindByteAvx2(const char* const data, const size_t size,
+                                     const char c) {
+  const __m256i v = _mm256_set1_epi8(c);
+  const __m256i* const blocks = reinterpret_cast<const __m256i*>(data);
+  size_t i = 0;
+  for (; i + 128 <= size; i += 128) {
+    const __m256i* const step = blocks + i / 32;
+    const __m256i eq0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(step), v);
+    const __m256i eq1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(step + 1), v);
+    const __m256i eq2 = _mm256_cmpeq_epi8(_mm256_loadu_si256(step + 2), v);
+    const __m256i eq3 = _mm256_cmpeq_epi8(_mm256_loadu_si256(step + 3), v);
+    if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(eq0, eq1),
+                                             _mm256_or_si256(eq2, eq3))) != 0) {
+      break;
+    }
+  }
+  for (; i + 32 <= size; i += 32) {
+    const uint32_t mask = _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_loadu_si256(blocks + i / 32), v));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return Offset(i, FindByteSse2(data + i, size - i, c));
+}
+
+ELSH_TARGET_AVX2 size_t CountByteAvx2(const char* const data,
+                                      const size_t size, const char c) {
+  const __m256i v = _mm256_set1_epi8(c);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i total = zero;
+  size_t i = 0;
+  while (i + 32 <= size) {
+    __m256i counts = zero;
+    for (int step = 0; step < 255 && i + 32 <= size; ++step, i += 32) {
+      const __m256i block =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+      counts = _mm256_sub_epi8(counts, _mm256_cmpeq_epi8(block, v));
+    }
+    total = _mm256_add_epi64(total, _mm256_sad_epu8(counts, zero));
+  }
+  uint64_t lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), total);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+         CountByteScalar(data + i, size - i, c);
+}
+
+ELSH_TARGET_AVX2 size_t FindAvx2(const char* const data, const size_t size,
+                                 const char* const needle,
+                                 const size_t needle_size) {
+  if (needle_size > size) {
+    return kNotFound;
+  }
+  const __m256i first = _mm256_set1_epi8(needle[0]);
+  const __m256i last = _mm256_set1_epi8(needle[needle_size - 1]);
+  size_t i = 0;
+  for (; i + needle_size - 1 + 32 <= size; i += 32) {
+    const __m256i block_first =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const __m256i block_last = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(data + i + needle_size - 1));
+    uint32_t mask = _mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first),
+                         _mm256_cmpeq_epi8(block_last, last)));
+    while (mask != 0) {
+      const size_t candidate = i + __builtin_ctz(mask);
+      if (memcmp(data + candidate + 1, needle + 1, needle_size - 2) == 0) {
+        return candidate;
+      }
+      mask &= mask - 1;
+    }
+  }
+  return Offset(i, FindSse2(data + i, size - i, needle, needle_size));
+}
+
+const StringKernels kAvx2Kernels = {FindByteAvx2, CountByteAvx2, FindAvx2};
+
+#endif  // ELSH_X86_KERNELS
+
+}  // namespace
+
+const StringKernels& GetStringKernels(const KernelSet kernel_set) {
+#ifdef ELSH_X86_KERNELS
+  if (IsSupported(kernel_set)) {
+    if (kernel_set == KernelSet::kAvx2) {
+      return kAvx2Kernels;
+    } else if (kernel_set == KernelSet::kSse2) {
+      return kSse2Kernels;
+    }
+  }
+#endif
+  return kScalarKernels;
+}
+
+const StringKernels& GetStringKernels() {
+  return GetStringKernels(DetectKernelSet());
+}
+
+size_t StringFind(const StringSlice& str, const StringSlice& needle,
+                  const size_t from) {
+  if (from > str.size) {
+    return kNotFound;
+  }
+  if (needle.size == 0) {
+    return from;
+  }
+  const StringKernels& kernels = GetStringKernels();
+  const char* const data = str.data + from;
+  const size_t size = str.size - from;
+  return Offset(from, needle.size == 1
+                          ? kernels.find_byte(data, size, needle.data[0])
+                          : kernels.find(data, size, needle.data,
+                                         needle.size));
+}
+
+size_t StringCount(const StringSlice& str, const StringSlice& needle) {
+  if (needle.size == 0) {
+    return str.size + 1;
+  }
+  if (needle.size == 1) {
+    return GetStringKernels().count_byte(str.data, str.size, needle.data[0]);
+  }
+  size_t count = 0;
+  for (size_t i = StringFind(str, needle); i != kNotFound;
+       i = StringFind(str, needle, i + needle.size)) {
+    ++count;
+  }
+  return count;
+}
+
+void StringSplit(const StringSlice& str, const StringSlice& separator,
+                 std::vector<StringSlice>* const fields) {
+  fields->clear();
+  if (separator.size == 0) {
+    fields->push_back(str);
+    return;
+  }
+  size_t start = 0;
+  for (size_t end = StringFind(str, separator); end != kNotFound;
+       end = StringFind(str, separator, start)) {
+    fields->emplace_back(str.data + start, end - start);
+    start = end + separator.size;
+  }
+  fields->emplace_back(str.data + start, str.size - start);
+}
+
+}  // namespace runtime
+}  // namespace elsh
@@ -0,0 +1,98 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_STRING_KERNELS_H_
+#define RUNTIME_STRING_KERNELS_H_
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "runtime/array_kernels.h"
+
+namespace elsh {
+namespace runtime {
+
+/// @brief Offset the searches return when there is no match.
+constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+/// @brief Bytes of a string owned elsewhere. Split results point into the
+/// string they were split from, which has to outlive them.
+struct StringSlice {
+  StringSlice() : data(nullptr), size(0) {}
+  StringSlice(const char* const data, const size_t size)
+      : data(data), size(size) {}
+  // Explicit, so that a temporary string is not silently sliced and gone by
+  // the time its slices are used.
+  explicit StringSlice(const std::string& str)
+      : data(str.data()), size(str.size()) {}
+  // Implicit, so builtins can take literals as they are.
+  StringSlice(const char* const str) : data(str), size(strlen(str)) {}
+
+  std::string ToString() const { return std::string(data, size); }
+
+  const char* data;
+  size_t size;
+};
+
+/// @brief Byte and substring scans for the string builtins. Substring search
+/// compares the first and the last byte of the needle against a whole vector
+/// of positions at once and only checks the bytes in between at positions
+/// where both match.
+struct StringKernels {
+  /// Offset of the first `c` in `data`, `kNotFound` if there is none.
+  size_t (*find_byte)(const char* const data, const size_t size,
+                      const char c);
+  /// Number of bytes equal to `c`.
+  size_t (*count_byte)(const char* const data, const size_t size,
+                       const char c);
+  /// Offset of the first `needle`, which is at least 2 bytes long.
+  size_t (*find)(const char* const data, const size_t size,
+                 const char* const needle, const size_t needle_size);
+};
+
+/// @brief Kernels of `kernel_set`, falling back to scalar code if the cpu does
+/// not support it.
+const StringKernels& GetStringKernels(const KernelSet kernel_set);
+/// @brief Kernels of `DetectKernelSet()`.
+const StringKernels& GetStringKernels();
+
+/// @brief Offset of the first `needle` in `str` at or after `from`,
+/// `kNotFound` if there is none. An empty needle matches at `from`.
+size_t StringFind(const StringSlice& str, const StringSlice& needle,
+                  const size_t from = 0);
+inline bool StringContains(const StringSlice& str, const StringSlice& needle) {
+  return StringFind(str, needle) != kNotFound;
+}
+/// @brief Number of non-overlapping `needle`s in `str`. An empty needle
+/// matches between every two bytes and at both ends, `str.size + 1` times.
+size_t StringCount(const StringSlice& str, const StringSlice& needle);
+/// @brief Replaces `fields` with the pieces of `str` between the `separator`s,
+/// without copying them. An empty separator leaves `str` whole.
+void StringSplit(const StringSlice& str, const StringSlice& separator,
+                 std::vector<StringSlice>* const fields);
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_STRING_KERNELS_H_
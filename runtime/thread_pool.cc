@@ -0,0 +1,164 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/thread_pool.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+// Whether the current thread is running a loop body.
+thread_local bool t_inside_loop = false;
+// Aim for this many chunks per thread: enough to even out uneven iterations
+// through stealing, few enough to keep the deques quiet.
+constexpr int64_t kChunksPerThread = 8;
+}  // namespace
+
+ThreadPool::ThreadPool(const int num_threads) : remaining_(0) {
+  const int workers =
+      num_threads >= 0
+          ? num_threads
+          : std::max(
+                static_cast<int>(std::thread::hardware_concurrency()) - 1, 0);
+  // Queue 0 belongs to the thread calling `ParallelFor`.
+  for (int i = 0; i <= workers; ++i) {
+    queues_.emplace_back(new WorkerQueue);
+  }
+  for (int i = 1; i <= workers; ++i) {
+    threads_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    stop_ = true;
+  }
+  state_cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPool::ParallelFor(const int64_t begin, const int64_t end,
+                             const RangeBody& body, const int64_t min_grain) {
+  if (end <= begin) {
+    return;
+  }
+  if (t_inside_loop || threads_.empty()) {
+    body(begin, end);
+    return;
+  }
+
+  std::lock_guard<std::mutex> loop_lock(loop_mutex_);
+  const int64_t size = end - begin;
+  const int64_t num_queues = concurrency();
+  body_ = &body;
+  grain_ = std::max(std::max(min_grain, int64_t{1}),
+                    size / (num_queues * kChunksPerThread));
+  remaining_ = size;
+  const int64_t num_ranges =
+      std::max(std::min(num_queues, size / grain_), int64_t{1});
+  for (int64_t i = 0; i < num_ranges; ++i) {
+    const Range range{begin + size * i / num_ranges,
+                      begin + size * (i + 1) / num_ranges};
+    std::lock_guard<std::mutex> lock(queues_[i]->mutex);
+    queues_[i]->ranges.push_back(range);
+  }
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    ++generation_;
+  }
+  state_cv_.notify_all();
+
+  t_inside_loop = true;
+  Work(0);
+  t_inside_loop = false;
+  body_ = nullptr;
+}
+
+void ThreadPool::WorkerLoop(const int index) {
+  t_inside_loop = true;
+  uint64_t seen_generation = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(state_mutex_);
+      state_cv_.wait(lock, [this, seen_generation]() {
+        return stop_ || generation_ != seen_generation;
+      });
+      if (stop_) {
+        return;
+      }
+      seen_generation = generation_;
+    }
+    Work(index);
+  }
+}
+
+void ThreadPool::Work(const int index) {
+  Range range;
+  while (remaining_.load() > 0) {
+    if (!Pop(index, &range) && !Steal(index, &range)) {
+      // Everything left is already being run by other threads.
+      std::this_thread::yield();
+      continue;
+    }
+    // Both halves stay at least one grain large.
+    while (range.end - range.begin >= 2 * grain_) {
+      const int64_t middle = range.begin + (range.end - range.begin) / 2;
+      {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->ranges.push_back({middle, range.end});
+      }
+      range.end = middle;
+    }
+    (*body_)(range.begin, range.end);
+    remaining_.fetch_sub(range.end - range.begin);
+  }
+}
+
+bool ThreadPool::Pop(const int index, Range* const range) {
+  WorkerQueue& queue = *queues_[index];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.ranges.empty()) {
+    return false;
+  }
+  *range = queue.ranges.back();
+  queue.ranges.pop_back();
+  return true;
+}
+
+bool ThreadPool::Steal(const int index, Range* const range) {
+  const int num_queues = concurrency();
+  for (int offset = 1; offset < num_queues; ++offset) {
+    WorkerQueue& victim = *queues_[(index + offset) % num_queues];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.ranges.empty()) {
+      *range = victim.ranges.front();
+      victim.ranges.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace runtime
+}  // namespace elsh
@@ -0,0 +1,181 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_THREAD_POOL_H_
+#define RUNTIME_THREAD_POOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "runtime/output_buffer.h"
+
+namespace elsh {
+namespace runtime {
+
+/// @brief Work stealing pool backing `parallel for` loops.
+///
+/// A loop over [begin, end) starts as one range per worker. Workers split
+/// ranges in halves while they span at least two grains, keep working on the
+/// lower half and push the upper half to the back of their own deque. Idle
+/// workers steal from the front of the other deques, where the largest ranges
+/// are. The calling thread takes part in every loop, so a pool without worker
+/// threads simply runs loops sequentially.
+class ThreadPool {
+ public:
+  using RangeBody = std::function<void(const int64_t begin, const int64_t end)>;
+
+  /// @brief `num_threads` workers besides the calling thread. Negative means
+  /// one less than the hardware threads.
+  explicit ThreadPool(const int num_threads = -1);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /// @brief Threads running a loop, the calling thread included.
+  int concurrency() const { return static_cast<int>(queues_.size()); }
+
+  /// @brief Call `body` on disjoint chunks covering [begin, end) and return
+  /// once all of them are done. Chunks are never smaller than `min_grain`
+  /// unless the whole range is. Loops started from inside a loop body run
+  /// sequentially on the calling worker.
+  void ParallelFor(const int64_t begin, const int64_t end,
+                   const RangeBody& body, const int64_t min_grain = 1);
+
+  /// @brief Reduce [begin, end): `body(chunk_begin, chunk_end)` yields the
+  /// value of one chunk and the chunk values are combined in iteration order,
+  /// so the result does not depend on scheduling even for non associative
+  /// operations like floating point addition.
+  template <typename T, typename Body, typename Combine>
+  T ParallelReduce(const int64_t begin, const int64_t end, T identity,
+                   const Body& body, const Combine& combine,
+                   const int64_t min_grain = 1);
+
+  /// @brief Run [begin, end) with `body(i, &chunk_output)` and write the
+  /// output of all iterations to `out` ordered by iteration index, exactly
+  /// as a sequential loop would.
+  template <typename Body>
+  void ParallelForOrdered(const int64_t begin, const int64_t end,
+                          const Body& body, OutputBuffer* const out,
+                          const int64_t min_grain = 1);
+
+ private:
+  struct Range {
+    int64_t begin;
+    int64_t end;
+  };
+
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Range> ranges;
+  };
+
+  void WorkerLoop(const int index);
+  /// @brief Run ranges of the current loop until none is left anywhere.
+  void Work(const int index);
+  bool Pop(const int index, Range* const range);
+  bool Steal(const int index, Range* const range);
+
+ private:
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::vector<std::thread> threads_;
+
+  // Serializes loops started by different threads.
+  std::mutex loop_mutex_;
+
+  // Workers sleep until a new loop starts.
+  std::mutex state_mutex_;
+  std::condition_variable state_cv_;
+  uint64_t generation_ = 0;
+  bool stop_ = false;
+
+  // State of the running loop. `remaining_` is stored last when a loop starts
+  // and only reaches zero after every chunk returned.
+  const RangeBody* body_ = nullptr;
+  int64_t grain_ = 1;
+  std::atomic<int64_t> remaining_;
+};
+
+template <typename T, typename Body, typename Combine>
+T ThreadPool::ParallelReduce(const int64_t begin, const int64_t end,
+                             T identity, const Body& body,
+                             const Combine& combine, const int64_t min_grain) {
+  std::mutex mutex;
+  std::vector<std::pair<int64_t, T>> partials;
+  ParallelFor(
+      begin, end,
+      [&](const int64_t chunk_begin, const int64_t chunk_end) {
+        T value = body(chunk_begin, chunk_end);
+        std::lock_guard<std::mutex> lock(mutex);
+        partials.emplace_back(chunk_begin, std::move(value));
+      },
+      min_grain);
+  std::sort(partials.begin(), partials.end(),
+            [](const std::pair<int64_t, T>& a, const std::pair<int64_t, T>& b) {
+              return a.first < b.first;
+            });
+  T result = std::move(identity);
+  for (auto& partial : partials) {
+    result = combine(std::move(result), std::move(partial.second));
+  }
+  return result;
+}
+
+template <typename Body>
+void ThreadPool::ParallelForOrdered(const int64_t begin, const int64_t end,
+                                    const Body& body, OutputBuffer* const out,
+                                    const int64_t min_grain) {
+  // Chunks cover contiguous index ranges, so joining their outputs in chunk
+  // order gives iteration order.
+  auto chunks = ParallelReduce(
+      begin, end, std::vector<std::string>(),
+      [&body](const int64_t chunk_begin, const int64_t chunk_end) {
+        std::vector<std::string> chunk(1);
+        for (int64_t i = chunk_begin; i < chunk_end; ++i) {
+          body(i, &chunk.front());
+        }
+        return chunk;
+      },
+      [](std::vector<std::string> all, std::vector<std::string> chunk) {
+        all.push_back(std::move(chunk.front()));
+        return all;
+      },
+      min_grain);
+  for (const auto& chunk : chunks) {
+    out->Write(chunk);
+  }
+}
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_THREAD_POOL_H_
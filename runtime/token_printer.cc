@@ -0,0 +1,79 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/token_printer.h"
+
+#include <cstring>
+#include <string>
+
+#include "runtime/number_format.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+void PrintRightAligned(const char* const str, const size_t size,
+                       const size_t width, OutputBuffer* const out) {
+  for (size_t i = size; i < width; ++i) {
+    out->PutChar(' ');
+  }
+  out->Write(str, size);
+}
+
+void PrintRightAligned(const std::string& str, const size_t width,
+                       OutputBuffer* const out) {
+  PrintRightAligned(str.data(), str.size(), width, out);
+}
+
+void PrintRightAligned(const int64_t value, const size_t width,
+                       OutputBuffer* const out) {
+  char str[kMaxIntegerChars];
+  PrintRightAligned(str, FormatInt(value, str), width, out);
+}
+
+}  // namespace
+
+void PrintToken(const lex::Token& token, OutputBuffer* const out) {
+  PrintRightAligned(token.err_ln, 6, out);
+  out->Write(": ", 2);
+  PrintRightAligned(token.err_col, 3, out);
+  const char* const name = lex::TokenName(token.tok_type);
+  PrintRightAligned(name, strlen(name), 25, out);
+  switch (token.tok_type) {
+    case lex::TokenType::kTokenValueInt:
+      PrintRightAligned(token.value_int, 12, out);
+      break;
+    case lex::TokenType::kTokenValueChar:
+      PrintRightAligned(static_cast<int>(token.value_char), 12, out);
+      break;
+    case lex::TokenType::kTokenIdentifier:
+    case lex::TokenType::kTokenValueString:
+      PrintRightAligned(token.str, 12, out);
+      break;
+    default:
+      break;
+  }
+  out->PutChar('\n');
+}
+
+}  // namespace runtime
+}  // namespace elsh
@@ -0,0 +1,137 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "runtime/typed_array.h"
+
+#include "runtime/array_kernels.h"
+
+namespace elsh {
+namespace runtime {
+
+void Fill(TypedArray<int32_t>* const array, const int32_t value) {
+  GetArrayKernels().fill_int32(array->data(), array->size(), value);
+}
+
+void Fill(TypedArray<double>* const array, const double value) {
+  GetArrayKernels().fill_double(array->data(), array->size(), value);
+}
+
+int64_t Sum(const TypedArray<int32_t>& array) {
+  return GetArrayKernels().sum_int32(array.data(), array.size());
+}
+
+double Sum(const TypedArray<double>& array) {
+  return GetArrayKernels().sum_double(array.data(), array.size());
+}
+
+bool Min(const TypedArray<int32_t>& array, int32_t* const min) {
+  if (array.size() == 0) {
+    return false;
+  }
+  *min = GetArrayKernels().min_int32(array.data(), array.size());
+  return true;
+}
+
+bool Min(const TypedArray<double>& array, double* const min) {
+  if (array.size() == 0) {
+    return false;
+  }
+  *min = GetArrayKernels().min_double(array.data(), array.size());
+  return true;
+}
+
+bool Max(const TypedArray<int32_t>& array, int32_t* const max) {
+  if (array.size() == 0) {
+    return false;
+  }
+  *max = GetArrayKernels().max_int32(array.data(), array.size());
+  return true;
+}
+
+bool Max(const TypedArray<double>& array, double* const max) {
+  if (array.size() == 0) {
+    return false;
+  }
+  *max = GetArrayKernels().max_double(array.data(), array.size());
+  return true;
+}
+
+bool Add(const TypedArray<int32_t>& a, const TypedArray<int32_t>& b,
+         TypedArray<int32_t>* const out) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  out->Resize(a.size());
+  GetArrayKernels().add_int32(a.data(), b.data(), out->data(), a.size());
+  return true;
+}
+
+bool Add(const TypedArray<double>& a, const TypedArray<double>& b,
+         TypedArray<double>* const out) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  out->Resize(a.size());
+  GetArrayKernels().add_double(a.data(), b.data(), out->data(), a.size());
+  return true;
+}
+
+bool Mul(const TypedArray<int32_t>& a, const TypedArray<int32_t>& b,
+         TypedArray<int32_t>* const out) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  out->Resize(a.size());
+  GetArrayKernels().mul_int32(a.data(), b.data(), out->data(), a.size());
+  return true;
+}
+
+bool Mul(const TypedArray<double>& a, const TypedArray<double>& b,
+         TypedArray<double>* const out) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  out->Resize(a.size());
+  GetArrayKernels().mul_double(a.data(), b.data(), out->data(), a.size());
+  return true;
+}
+
+bool Dot(const TypedArray<int32_t>& a, const TypedArray<int32_t>& b,
+         int64_t* const dot) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  *dot = GetArrayKernels().dot_int32(a.data(), b.data(), a.size());
+  return true;
+}
+
+bool Dot(const TypedArray<double>& a, const TypedArray<double>& b,
+         double* const dot) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  *dot = GetArrayKernels().dot_double(a.data(), b.data(), a.size());
+  return true;
+}
+
+}  // namespace runtime
+}  // namespace elsh
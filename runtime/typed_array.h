@@ -0,0 +1,115 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RUNTIME_TYPED_ARRAY_H_
+#define RUNTIME_TYPED_ARRAY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace elsh {
+namespace runtime {
+
+/// @brief Fixed-type array (`int32[]`, `double[]`, ...) stored as one
+/// contiguous buffer of unboxed elements.
+///
+/// Single element access is checked. A loop over a known index range checks
+/// the whole range once with `InBounds` and then uses the unchecked
+/// `operator[]`, which is how the compiler hoists bounds checks out of loops.
+template <typename T>
+class TypedArray {
+ public:
+  TypedArray() = default;
+  explicit TypedArray(const size_t size, const T value = T())
+      : elements_(size, value) {}
+
+  size_t size() const { return elements_.size(); }
+  T* data() { return elements_.data(); }
+  const T* data() const { return elements_.data(); }
+  void Resize(const size_t size) { elements_.resize(size); }
+
+  /// @brief Whether every index in [begin, end) is valid.
+  bool InBounds(const int64_t begin, const int64_t end) const {
+    return 0 <= begin && begin <= end &&
+           static_cast<uint64_t>(end) <= elements_.size();
+  }
+
+  /// @brief Whether `index` is valid. Not `InBounds(index, index + 1)`, which
+  /// overflows for the largest index.
+  bool IsIndex(const int64_t index) const {
+    return 0 <= index && static_cast<uint64_t>(index) < elements_.size();
+  }
+
+  /// @brief Checked access, return false if `index` is out of bounds.
+  bool Get(const int64_t index, T* const value) const {
+    if (!IsIndex(index)) {
+      return false;
+    }
+    *value = elements_[index];
+    return true;
+  }
+  bool Set(const int64_t index, const T value) {
+    if (!IsIndex(index)) {
+      return false;
+    }
+    elements_[index] = value;
+    return true;
+  }
+
+  /// @brief Unchecked access, only valid for indexes covered by `InBounds`.
+  T& operator[](const size_t index) { return elements_[index]; }
+  const T& operator[](const size_t index) const { return elements_[index]; }
+
+ private:
+  std::vector<T> elements_;
+};
+
+/// @brief Bulk builtins, running the vectorized kernels picked for this cpu.
+/// Element-wise operations resize `out` to the size of the operands and
+/// return false if the operands differ in size, `Min` and `Max` return false
+/// for empty arrays.
+void Fill(TypedArray<int32_t>* const array, const int32_t value);
+void Fill(TypedArray<double>* const array, const double value);
+int64_t Sum(const TypedArray<int32_t>& array);
+double Sum(const TypedArray<double>& array);
+bool Min(const TypedArray<int32_t>& array, int32_t* const min);
+bool Min(const TypedArray<double>& array, double* const min);
+bool Max(const TypedArray<int32_t>& array, int32_t* const max);
+bool Max(const TypedArray<double>& array, double* const max);
+bool Add(const TypedArray<int32_t>& a, const TypedArray<int32_t>& b,
+         TypedArray<int32_t>* const out);
+bool Add(const TypedArray<double>& a, const TypedArray<double>& b,
+         TypedArray<double>* const out);
+bool Mul(const TypedArray<int32_t>& a, const TypedArray<int32_t>& b,
+         TypedArray<int32_t>* const out);
+bool Mul(const TypedArray<double>& a, const TypedArray<double>& b,
+         TypedArray<double>* const out);
+bool Dot(const TypedArray<int32_t>& a, const TypedArray<int32_t>& b,
+         int64_t* const dot);
+bool Dot(const TypedArray<double>& a, const TypedArray<double>& b,
+         double* const dot);
+
+}  // namespace runtime
+}  // namespace elsh
+
+#endif  // RUNTIME_TYPED_ARRAY_H_
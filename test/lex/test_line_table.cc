@@ -0,0 +1,113 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lex/line_table.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace lex {
+namespace {
+
+LineTable View(const LineTableBuilder& builder) {
+  return LineTable(builder.bytes().data(), builder.bytes().size(),
+                   builder.checkpoints().data(), builder.size());
+}
+
+}  // namespace
+
+SIMPLE_TEST(LineTable, OneBytePerTypicalPosition) {
+  LineTableBuilder builder;
+  builder.Add(1, 1);
+  builder.Add(1, 5);
+  builder.Add(2, 3);
+  builder.Add(2, 66);
+  EXPECT_EQ(4, builder.size());
+  EXPECT_EQ(4, builder.bytes().size());
+  EXPECT_EQ(1, builder.checkpoints().size());
+  // Too far for the short forms: marker byte and two varints.
+  builder.Add(2, 200);
+  builder.Add(9, 1);
+  builder.Add(10, 64);
+  EXPECT_EQ(4 + (1 + 1 + 2) + (1 + 1 + 1) + (1 + 1 + 2),
+            builder.bytes().size());
+}
+
+SIMPLE_TEST(LineTable, RoundTrip) {
+  std::vector<std::pair<int32_t, int32_t>> positions;
+  for (int32_t i = 0; i < 1000; ++i) {
+    positions.emplace_back(1 + i / 5, 1 + (i % 5) * (i % 7) * 9);
+  }
+  // Jumps back, far ahead and to the unknown position.
+  positions.emplace_back(3, 4);
+  positions.emplace_back(100000, 1 << 20);
+  positions.emplace_back(-1, -1);
+  positions.emplace_back(-1, -1);
+  positions.emplace_back(2147483647, 0);
+
+  LineTableBuilder builder;
+  for (const auto& position : positions) {
+    builder.Add(position.first, position.second);
+  }
+  const LineTable table = View(builder);
+  EXPECT_EQ(positions.size(), table.size());
+  EXPECT_EQ(LineTable::NumCheckpoints(positions.size()),
+            builder.checkpoints().size());
+
+  LineTable::Cursor cursor(table, 0);
+  int32_t line;
+  int32_t col;
+  for (const auto& position : positions) {
+    EXPECT(cursor.Next(&line, &col));
+    EXPECT_EQ(position.first, line);
+    EXPECT_EQ(position.second, col);
+  }
+  EXPECT(!cursor.Next(&line, &col));
+
+  for (const size_t index : {0, 1, 63, 64, 65, 511, 999, 1000, 1001, 1004}) {
+    EXPECT(table.Lookup(index, &line, &col));
+    EXPECT_EQ(positions[index].first, line);
+    EXPECT_EQ(positions[index].second, col);
+    LineTable::Cursor from(table, index);
+    EXPECT(from.Next(&line, &col));
+    EXPECT_EQ(positions[index].first, line);
+  }
+  EXPECT(!table.Lookup(positions.size(), &line, &col));
+}
+
+SIMPLE_TEST(LineTable, TruncatedTable) {
+  LineTableBuilder builder;
+  builder.Add(1, 1);
+  builder.Add(100000, 1);
+  const LineTable table(builder.bytes().data(), builder.bytes().size() - 1,
+                        builder.checkpoints().data(), builder.size());
+  int32_t line;
+  int32_t col;
+  EXPECT(table.Lookup(0, &line, &col));
+  EXPECT(!table.Lookup(1, &line, &col));
+}
+
+}  // namespace lex
+}  // namespace elsh
@@ -0,0 +1,162 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "lex/token_image.h"
+#include "lex/token_loader.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace lex {
+namespace {
+
+std::string TempPath(const std::string& name) {
+  return "/tmp/elsh_test_" + std::to_string(getpid()) + "_" + name +
+         image::kFileSuffix;
+}
+
+std::vector<Token> Lex(const std::string& source) {
+  std::stringstream ss(source);
+  TokenLoader loader(&ss);
+  return loader.GetAllTokens();
+}
+
+}  // namespace
+
+SIMPLE_TEST(TokenImage, RoundTrip) {
+  const std::string source =
+      "int a = 42;\ndouble b = 1.5;\nchar c = 'x';\n"
+      "string s = \"abc\";\nbool t = true;\nprint(a);\n";
+  const auto tokens = Lex(source);
+  const std::string path = TempPath("round_trip");
+  const uint64_t hash = HashSource(source.data(), source.size());
+  EXPECT(WriteTokenImage(tokens, hash, path));
+
+  const auto token_image = TokenImage::Load(path);
+  EXPECT(token_image != nullptr);
+  if (token_image) {
+    EXPECT_EQ(hash, token_image->source_hash());
+    EXPECT_EQ(tokens.size(), token_image->size());
+    const auto loaded = token_image->GetAllTokens();
+    for (size_t i = 0; i < tokens.size() && i < loaded.size(); ++i) {
+      EXPECT_EQ(tokens[i].tok_type, loaded[i].tok_type);
+      EXPECT_EQ(tokens[i].err_ln, loaded[i].err_ln);
+      EXPECT_EQ(tokens[i].err_col, loaded[i].err_col);
+      EXPECT_EQ(tokens[i].str, loaded[i].str);
+    }
+    EXPECT_EQ(42, loaded[3].value_int);
+    EXPECT_EQ(1.5, loaded[8].value_double);
+    EXPECT_EQ('x', loaded[13].value_char);
+    EXPECT_EQ("abc", loaded[18].str);
+    EXPECT_EQ(TokenType::kTokenEOI, loaded.back().tok_type);
+    for (size_t i = 0; i < tokens.size(); i += 7) {
+      EXPECT_EQ(tokens[i].err_ln, token_image->GetToken(i).err_ln);
+      EXPECT_EQ(tokens[i].err_col, token_image->GetToken(i).err_col);
+    }
+    EXPECT_EQ(TokenType::kTokenUnknown,
+              token_image->GetToken(tokens.size()).tok_type);
+  }
+  std::remove(path.c_str());
+}
+
+SIMPLE_TEST(TokenImage, InternsStringsAndConstants) {
+  std::string small_source;
+  std::string large_source;
+  for (int i = 0; i < 100; ++i) {
+    large_source += "counter = counter + 1;\n";
+  }
+  small_source = "counter = counter + 1;\n";
+  const std::string small_path = TempPath("small");
+  const std::string large_path = TempPath("large");
+  EXPECT(WriteTokenImage(Lex(small_source), 0, small_path));
+  EXPECT(WriteTokenImage(Lex(large_source), 0, large_path));
+
+  std::ifstream small_fs(small_path, std::ios::binary | std::ios::ate);
+  std::ifstream large_fs(large_path, std::ios::binary | std::ios::ate);
+  // Only the code and the line table grow: 8 bytes per token, 1 byte per
+  // position and one checkpoint per 64 positions.
+  const int64_t growth = static_cast<int64_t>(large_fs.tellg()) -
+                         static_cast<int64_t>(small_fs.tellg());
+  EXPECT_EQ(99 * 6 * (8 + 1) + 9 * sizeof(line_table::Checkpoint), growth);
+  std::remove(small_path.c_str());
+  std::remove(large_path.c_str());
+}
+
+SIMPLE_TEST(TokenImage, RejectsInvalidImages) {
+  const std::string path = TempPath("invalid");
+  EXPECT(TokenImage::Load(path) == nullptr);
+
+  {
+    std::ofstream fs(path, std::ios::binary);
+    fs << "int a = 0;\n";
+  }
+  EXPECT(TokenImage::Load(path) == nullptr);
+
+  EXPECT(WriteTokenImage(Lex("int a = 0;\n"), 0, path));
+  {
+    // Bump the version.
+    std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+    fs.seekp(sizeof(image::kMagic));
+    const uint32_t version = image::kVersion + 1;
+    fs.write(reinterpret_cast<const char*>(&version), sizeof(version));
+  }
+  EXPECT(TokenImage::Load(path) == nullptr);
+
+  EXPECT(WriteTokenImage(Lex("int a = 0;\n"), 0, path));
+  {
+    // Images of the lexer before UTF-8 literals hold different tokens.
+    std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+    fs.seekp(sizeof(image::kMagic));
+    const uint32_t version = 2;
+    fs.write(reinterpret_cast<const char*>(&version), sizeof(version));
+  }
+  EXPECT(TokenImage::Load(path) == nullptr);
+
+  for (const uint16_t type : {406, 600, 65535}) {
+    EXPECT(WriteTokenImage(Lex("int a = 0;\n"), 0, path));
+    // Overwrite the type of the last token with one that is not a type.
+    std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+    image::Header header;
+    fs.read(reinterpret_cast<char*>(&header), sizeof(header));
+    fs.seekp(header.code_offset +
+             (header.num_tokens - 1) * sizeof(image::TokenRecord));
+    fs.write(reinterpret_cast<const char*>(&type), sizeof(type));
+    fs.close();
+    EXPECT(TokenImage::Load(path) == nullptr);
+  }
+
+  EXPECT(WriteTokenImage(Lex("int a = 0;\n"), 0, path));
+  EXPECT(TokenImage::Load(path) != nullptr);
+  // Cut off the string pool and the line table.
+  EXPECT_EQ(0, truncate(path.c_str(), sizeof(image::Header) + 16));
+  EXPECT(TokenImage::Load(path) == nullptr);
+  std::remove(path.c_str());
+}
+
+}  // namespace lex
+}  // namespace elsh
@@ -236,5 +236,168 @@ SIMPLE_TEST(Lex, Comments) {
     EXPECT_EQ(TokenType::kTokenEOI, tokens[3].tok_type);
   }
 }
+
+SIMPLE_TEST(Lex, Brackets) {
+  std::stringstream ss;
+  ss << "int32[] a; a[1] = 2;" << std::endl;
+  TokenLoader loader(&ss);
+  const auto tokens = loader.GetAllTokens();
+  EXPECT_EQ(13, tokens.size());
+  EXPECT_EQ(TokenType::kTokenDtInt32, tokens[0].tok_type);
+  EXPECT_EQ(TokenType::kTokenSymLbracket, tokens[1].tok_type);
+  EXPECT_EQ(TokenType::kTokenSymRbracket, tokens[2].tok_type);
+  EXPECT_EQ(TokenType::kTokenIdentifier, tokens[3].tok_type);
+  EXPECT_EQ(TokenType::kTokenSymLbracket, tokens[6].tok_type);
+  EXPECT_EQ(TokenType::kTokenValueInt, tokens[7].tok_type);
+  EXPECT_EQ(TokenType::kTokenSymRbracket, tokens[8].tok_type);
+  EXPECT_EQ(TokenType::kTokenEOI, tokens[12].tok_type);
+}
+
+SIMPLE_TEST(Lex, ParallelFor) {
+  std::stringstream ss;
+  ss << "parallel for(int i = 0; i < n; i += 1) {}" << std::endl;
+  TokenLoader loader(&ss);
+  const auto tokens = loader.GetAllTokens();
+  EXPECT_EQ(20, tokens.size());
+  EXPECT_EQ(TokenType::kTokenKwParallel, tokens[0].tok_type);
+  EXPECT_EQ(TokenType::kTokenKwFor, tokens[1].tok_type);
+  EXPECT_EQ(TokenType::kTokenSymLparen, tokens[2].tok_type);
+  EXPECT_EQ(TokenType::kTokenEOI, tokens[19].tok_type);
+}
+
+SIMPLE_TEST(Lex, FirstLine) {
+  std::stringstream ss;
+  ss << "a = 1;" << std::endl << "b" << std::endl;
+  TokenLoader loader(&ss, 41);
+  const auto tokens = loader.GetAllTokens();
+  EXPECT_EQ(6, tokens.size());
+  EXPECT_EQ(41, tokens[0].err_ln);
+  EXPECT_EQ(1, tokens[0].err_col);
+  EXPECT_EQ(42, tokens[4].err_ln);
+  EXPECT_EQ(1, tokens[4].err_col);
+}
+
+SIMPLE_TEST(Lex, Utf8Strings) {
+  {
+    // Columns count code points: "é" and "ö" take two bytes each.
+    std::stringstream ss;
+    ss << "s = \"h\xC3\xA9llo w\xC3\xB6rld\"; t;" << std::endl;
+    TokenLoader loader(&ss);
+    const auto tokens = loader.GetAllTokens();
+    EXPECT_EQ(7, tokens.size());
+    EXPECT_EQ(TokenType::kTokenValueString, tokens[2].tok_type);
+    EXPECT_EQ("h\xC3\xA9llo w\xC3\xB6rld", tokens[2].str);
+    EXPECT_EQ(5, tokens[2].err_col);
+    EXPECT_EQ(18, tokens[3].err_col);
+    EXPECT_EQ(20, tokens[4].err_col);
+  }
+  {
+    std::stringstream ss;
+    ss << "\"\\u00e9\\u4E2D\\n\"" << std::endl;
+    TokenLoader loader(&ss);
+    const auto tokens = loader.GetAllTokens();
+    EXPECT_EQ(2, tokens.size());
+    EXPECT_EQ(TokenType::kTokenValueString, tokens[0].tok_type);
+    EXPECT_EQ("\xC3\xA9\xE4\xB8\xAD\\n", tokens[0].str);
+  }
+  {
+    // Escaped backslashes are kept and do not start a \u escape.
+    std::stringstream ss;
+    ss << "\"C:\\\\users\" \"\\\\u00e9\"" << std::endl;
+    TokenLoader loader(&ss);
+    const auto tokens = loader.GetAllTokens();
+    EXPECT_EQ(3, tokens.size());
+    EXPECT_EQ(TokenType::kTokenValueString, tokens[0].tok_type);
+    EXPECT_EQ("C:\\\\users", tokens[0].str);
+    EXPECT_EQ(TokenType::kTokenValueString, tokens[1].tok_type);
+    EXPECT_EQ("\\\\u00e9", tokens[1].str);
+  }
+  {
+    std::stringstream ss;
+    ss << "\"bad \xC3\x28 byte\"" << std::endl;
+    TokenLoader loader(&ss);
+    const auto tokens = loader.GetAllTokens();
+    EXPECT_EQ(1, tokens.size());
+    EXPECT_EQ(TokenType::kTokenUnknown, tokens[0].tok_type);
+    EXPECT_EQ("invalid UTF-8 in string", tokens[0].str);
+  }
+  {
+    std::stringstream ss;
+    ss << "\"\\uD800\"" << std::endl;
+    TokenLoader loader(&ss);
+    const auto tokens = loader.GetAllTokens();
+    EXPECT_EQ(1, tokens.size());
+    EXPECT_EQ(TokenType::kTokenUnknown, tokens[0].tok_type);
+  }
+  {
+    std::stringstream ss;
+    ss << "\"\\u12G4\"" << std::endl;
+    TokenLoader loader(&ss);
+    const auto tokens = loader.GetAllTokens();
+    EXPECT_EQ(1, tokens.size());
+    EXPECT_EQ(TokenType::kTokenUnknown, tokens[0].tok_type);
+  }
+}
+
+SIMPLE_TEST(Lex, Utf8Chars) {
+  {
+    std::stringstream ss;
+    ss << "'\\u0041' 'b'" << std::endl;
+    TokenLoader loader(&ss);
+    const auto tokens = loader.GetAllTokens();
+    EXPECT_EQ(3, tokens.size());
+    EXPECT_EQ(TokenType::kTokenValueChar, tokens[0].tok_type);
+    EXPECT_EQ('A', tokens[0].value_char);
+    EXPECT_EQ('b', tokens[1].value_char);
+    EXPECT_EQ(10, tokens[1].err_col);
+  }
+  {
+    std::stringstream ss;
+    ss << "'\xC3\xA9'" << std::endl;
+    TokenLoader loader(&ss);
+    const auto tokens = loader.GetAllTokens();
+    EXPECT_EQ(1, tokens.size());
+    EXPECT_EQ("character constant out of range", tokens[0].str);
+  }
+  {
+    std::stringstream ss;
+    ss << "'\xE9'" << std::endl;
+    TokenLoader loader(&ss);
+    const auto tokens = loader.GetAllTokens();
+    EXPECT_EQ(1, tokens.size());
+    EXPECT_EQ("invalid UTF-8 in character constant", tokens[0].str);
+  }
+}
+
+SIMPLE_BENCH(Lex, Utf8Strings) {
+  const std::string source =
+      "string s = \"gr\xC3\xBC\xC3\x9F" "e aus K\xC3\xB6ln\"; "
+      "string t = \"\xE4\xBD\xA0\xE5\xA5\xBD, \xE4\xB8\x96\xE7\x95\x8C\";\n";
+  while (state->KeepRunning()) {
+    std::istringstream ss(source);
+    TokenLoader loader(&ss);
+    DoNotOptimize(loader.GetAllTokens());
+  }
+}
+
+SIMPLE_BENCH(Lex, Statement) {
+  const std::string source = "for(int i = 0; i < limit; i += 1) { print(i); }";
+  while (state->KeepRunning()) {
+    std::istringstream ss(source);
+    TokenLoader loader(&ss);
+    DoNotOptimize(loader.GetAllTokens());
+  }
+}
+
+SIMPLE_BENCH(Lex, LiteralsAndComments) {
+  const std::string source =
+      "// counters\ndouble d = 3.1415926; string s = \"hello, world\";\n"
+      "char c = '\\n'; /* block\ncomment */ int big = 1234567890;\n";
+  while (state->KeepRunning()) {
+    std::istringstream ss(source);
+    TokenLoader loader(&ss);
+    DoNotOptimize(loader.GetAllTokens());
+  }
+}
 }  // namespace lex
 }  // namespace elsh
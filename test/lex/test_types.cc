@@ -0,0 +1,102 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstring>
+#include <set>
+#include <string>
+
+#include "lex/types.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace lex {
+
+SIMPLE_TEST(Types, TokenNames) {
+  EXPECT_EQ(std::string("Unknown_token"), TokenName(TokenType::kTokenUnknown));
+  EXPECT_EQ(std::string("End_of_input"), TokenName(TokenType::kTokenEOI));
+  EXPECT_EQ(std::string("Op_or"), TokenName(TokenType::kTokenOpOr));
+  EXPECT_EQ(std::string("Keyword_parallel"),
+            TokenName(TokenType::kTokenKwParallel));
+  EXPECT_EQ(std::string("Symbol_Comma"), TokenName(TokenType::kTokenSymComma));
+  EXPECT_EQ(std::string("Type_void"), TokenName(TokenType::kTokenDtVoid));
+  EXPECT_EQ(std::string("Value_bool"), TokenName(TokenType::kTokenValueBool));
+
+  // Every type has a name of its own, gaps and values past the enum do not.
+  const TokenType types[] = {
+      TokenType::kTokenEOI,          TokenType::kTokenOpMul,
+      TokenType::kTokenOpDiv,        TokenType::kTokenOpMod,
+      TokenType::kTokenOpAdd,        TokenType::kTokenOpSub,
+      TokenType::kTokenOpNegate,     TokenType::kTokenOpNot,
+      TokenType::kTokenOpLss,        TokenType::kTokenOpLeq,
+      TokenType::kTokenOpGtr,        TokenType::kTokenOpGeq,
+      TokenType::kTokenOpEq,         TokenType::kTokenOpNeq,
+      TokenType::kTokenOpAssign,     TokenType::kTokenOpAnd,
+      TokenType::kTokenOpOr,         TokenType::kTokenKwIf,
+      TokenType::kTokenKwElse,       TokenType::kTokenKwWhile,
+      TokenType::kTokenKwBreak,      TokenType::kTokenKwContinue,
+      TokenType::kTokenKwDo,         TokenType::kTokenKwFor,
+      TokenType::kTokenKwPrint,      TokenType::kTokenKwPutc,
+      TokenType::kTokenKwReturn,     TokenType::kTokenKwConst,
+      TokenType::kTokenKwParallel,   TokenType::kTokenSymLparen,
+      TokenType::kTokenSymRparen,    TokenType::kTokenSymLbrace,
+      TokenType::kTokenSymRbrace,    TokenType::kTokenSymLbracket,
+      TokenType::kTokenSymRbracket,  TokenType::kTokenSymSemiColon,
+      TokenType::kTokenSymComma,     TokenType::kTokenDtInt32,
+      TokenType::kTokenDtInt64,      TokenType::kTokenDtUint32,
+      TokenType::kTokenDtUint64,     TokenType::kTokenDtDouble,
+      TokenType::kTokenDtChar,       TokenType::kTokenDtVoid,
+      TokenType::kTokenDtBool,       TokenType::kTokenDtString,
+      TokenType::kTokenIdentifier,   TokenType::kTokenValueInt,
+      TokenType::kTokenValueDouble,  TokenType::kTokenValueChar,
+      TokenType::kTokenValueString,  TokenType::kTokenValueBool};
+  std::set<std::string> names;
+  for (const auto type : types) {
+    const std::string name = TokenName(type);
+    EXPECT(name != "Unknown_token");
+    EXPECT(names.insert(name).second);
+  }
+  EXPECT_EQ(std::string("Unknown_token"),
+            TokenName(static_cast<TokenType>(406)));
+  EXPECT_EQ(std::string("Unknown_token"),
+            TokenName(static_cast<TokenType>(116)));
+  EXPECT_EQ(std::string("Unknown_token"),
+            TokenName(static_cast<TokenType>(9999)));
+}
+
+SIMPLE_TEST(Types, KeywordType) {
+  const char* const identifiers[] = {"", "i", "in", "int3", "int320", "a",
+                                     "zz", "whiles", "Bool", "break_"};
+  for (const char* const text : identifiers) {
+    EXPECT_EQ(TokenType::kTokenIdentifier, KeywordType(text, strlen(text)));
+  }
+  EXPECT_EQ(TokenType::kTokenDtBool, KeywordType("bool", 4));
+  EXPECT_EQ(TokenType::kTokenDtInt32, KeywordType("int", 3));
+  EXPECT_EQ(TokenType::kTokenDtInt32, KeywordType("int32", 5));
+  EXPECT_EQ(TokenType::kTokenDtInt64, KeywordType("int64", 5));
+  EXPECT_EQ(TokenType::kTokenValueBool, KeywordType("true", 4));
+  EXPECT_EQ(TokenType::kTokenKwWhile, KeywordType("while", 5));
+  // Only `size` characters count.
+  EXPECT_EQ(TokenType::kTokenKwDo, KeywordType("double", 2));
+}
+
+}  // namespace lex
+}  // namespace elsh
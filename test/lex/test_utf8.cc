@@ -0,0 +1,130 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <string>
+
+#include "lex/utf8.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace lex {
+namespace {
+
+const utf8::Kernel kKernels[] = {utf8::Kernel::kScalar, utf8::Kernel::kSse2,
+                                 utf8::Kernel::kAvx2};
+
+}  // namespace
+
+SIMPLE_TEST(Utf8, Decode) {
+  uint32_t code_point = 0;
+  EXPECT_EQ(1, utf8::Decode("a", 1, &code_point));
+  EXPECT_EQ(0x61, code_point);
+  EXPECT_EQ(2, utf8::Decode("\xC3\xA9", 2, &code_point));
+  EXPECT_EQ(0xE9, code_point);
+  EXPECT_EQ(3, utf8::Decode("\xE4\xB8\xAD", 3, &code_point));
+  EXPECT_EQ(0x4E2D, code_point);
+  EXPECT_EQ(4, utf8::Decode("\xF0\x9F\x98\x80", 4, &code_point));
+  EXPECT_EQ(0x1F600, code_point);
+
+  // Truncated, stray continuation, overlong, surrogate, beyond U+10FFFF.
+  EXPECT_EQ(0, utf8::Decode("\xC3", 1, &code_point));
+  EXPECT_EQ(0, utf8::Decode("\xA9", 1, &code_point));
+  EXPECT_EQ(0, utf8::Decode("\xC0\xAF", 2, &code_point));
+  EXPECT_EQ(0, utf8::Decode("\xE0\x80\xAF", 3, &code_point));
+  EXPECT_EQ(0, utf8::Decode("\xED\xA0\x80", 3, &code_point));
+  EXPECT_EQ(0, utf8::Decode("\xF4\x90\x80\x80", 4, &code_point));
+  EXPECT_EQ(0, utf8::Decode("\xC3\x28", 2, &code_point));
+}
+
+SIMPLE_TEST(Utf8, AppendRoundTrips) {
+  const uint32_t code_points[] = {0x24, 0xA2, 0x7FF, 0x800, 0x20AC, 0xFFFF,
+                                  0x10000, 0x10348, 0x10FFFF};
+  for (const uint32_t expected : code_points) {
+    std::string out;
+    EXPECT(utf8::Append(expected, &out));
+    uint32_t code_point = 0;
+    EXPECT_EQ(out.size(), utf8::Decode(out.data(), out.size(), &code_point));
+    EXPECT_EQ(expected, code_point);
+  }
+  std::string out;
+  EXPECT(!utf8::Append(0xD800, &out));
+  EXPECT(!utf8::Append(0x110000, &out));
+  EXPECT(out.empty());
+}
+
+SIMPLE_TEST(Utf8, AsciiPrefixAllKernels) {
+  // Long enough for several vector steps and a tail, with the first
+  // non-ASCII byte at every offset.
+  for (const auto kernel : kKernels) {
+    for (size_t at = 0; at <= 100; ++at) {
+      std::string text(100, 'x');
+      if (at < text.size()) {
+        text[at] = '\xC3';
+      }
+      EXPECT_EQ(at, utf8::AsciiPrefix(text.data(), text.size(), kernel));
+    }
+  }
+}
+
+SIMPLE_TEST(Utf8, ValidateAllKernels) {
+  const std::string mixed =
+      "plain ascii text that is longer than one avx2 register, "
+      "caf\xC3\xA9 \xE4\xB8\xAD\xE6\x96\x87 \xF0\x9F\x98\x80 and ascii again.";
+  for (const auto kernel : kKernels) {
+    EXPECT(utf8::Validate("", 0, kernel));
+    EXPECT(utf8::Validate(mixed.data(), mixed.size(), kernel));
+
+    std::string broken = mixed;
+    broken.insert(40, "\xE4\xB8");
+    size_t error_offset = 0;
+    EXPECT(!utf8::Validate(broken.data(), broken.size(), kernel,
+                           &error_offset));
+    EXPECT_EQ(40, error_offset);
+
+    // Truncated at the very end.
+    broken = mixed + "\xF0\x9F\x98";
+    EXPECT(!utf8::Validate(broken.data(), broken.size(), kernel,
+                           &error_offset));
+    EXPECT_EQ(mixed.size(), error_offset);
+  }
+}
+
+SIMPLE_BENCH(Utf8, ValidateAscii) {
+  const std::string text(4096, 'a');
+  while (state->KeepRunning()) {
+    DoNotOptimize(utf8::Validate(text.data(), text.size()));
+  }
+}
+
+SIMPLE_BENCH(Utf8, ValidateMixed) {
+  std::string text;
+  while (text.size() < 4096) {
+    text += "Gr\xC3\xBC\xC3\x9F" "e aus K\xC3\xB6ln und "
+            "\xE4\xBD\xA0\xE5\xA5\xBD. ";
+  }
+  while (state->KeepRunning()) {
+    DoNotOptimize(utf8::Validate(text.data(), text.size()));
+  }
+}
+
+}  // namespace lex
+}  // namespace elsh
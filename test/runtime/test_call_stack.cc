@@ -0,0 +1,252 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <string>
+#include <vector>
+
+#include "runtime/call_stack.h"
+#include "runtime/stats.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+constexpr int kReturnToHost = -1;
+
+// What the compiler would emit for
+//   func fib(n) { if (n < 2) return n; a = fib(n - 1); return a + fib(n - 2); }
+// with one resume point per call site.
+bool Fib(CallStack* const stack, const FrameLayout& layout, const int64_t n,
+         int64_t* const result) {
+  const int n_slot = layout.FindSlot("n");
+  const int a_slot = layout.FindSlot("a");
+  stack->PrepareArgs(1)[n_slot].i = n;
+  Slot* frame = stack->Call(layout, kReturnToHost);
+  int pc = 0;
+  int64_t value = 0;
+  while (frame != nullptr) {
+    Slot* args;
+    switch (pc) {
+      case 0:
+        if (frame[n_slot].i < 2) {
+          value = frame[n_slot].i;
+          break;
+        }
+        args = stack->PrepareArgs(1);
+        args[n_slot].i = frame[n_slot].i - 1;
+        frame = stack->Call(layout, 1);
+        continue;
+      case 1:
+        frame[a_slot].i = value;
+        args = stack->PrepareArgs(1);
+        args[n_slot].i = frame[n_slot].i - 2;
+        frame = stack->Call(layout, 2);
+        pc = 0;
+        continue;
+      case 2:
+        value += frame[a_slot].i;
+        break;
+    }
+    pc = stack->Return();
+    if (pc == kReturnToHost) {
+      *result = value;
+      return true;
+    }
+    frame = stack->locals();
+  }
+  return false;
+}
+
+// func sum(n, acc) { if (n == 0) return acc; return sum(n - 1, acc + n); }
+int64_t TailSum(CallStack* const stack, const FrameLayout& layout,
+                const int64_t n) {
+  Slot* args = stack->PrepareArgs(2);
+  args[0].i = n;
+  args[1].i = 0;
+  Slot* frame = stack->Call(layout, kReturnToHost);
+  while (frame[0].i != 0) {
+    args = stack->PrepareArgs(2);
+    args[0].i = frame[0].i - 1;
+    args[1].i = frame[1].i + frame[0].i;
+    frame = stack->TailCall(layout);
+  }
+  const int64_t result = frame[1].i;
+  stack->Return();
+  return result;
+}
+
+// func sum(n) { if (n == 0) return 0; return n + sum(n - 1); }
+bool Sum(CallStack* const stack, const FrameLayout& layout, const int64_t n,
+         int64_t* const result) {
+  stack->PrepareArgs(1)[0].i = n;
+  Slot* frame = stack->Call(layout, kReturnToHost);
+  while (frame != nullptr && frame[0].i != 0) {
+    Slot* const args = stack->PrepareArgs(1);
+    if (args == nullptr) {
+      frame = nullptr;
+      break;
+    }
+    args[0].i = frame[0].i - 1;
+    frame = stack->Call(layout, 0);
+  }
+  if (frame == nullptr) {
+    while (stack->depth() > 0) {
+      stack->Return();
+    }
+    return false;
+  }
+  int64_t value = 0;
+  while (stack->Return() != kReturnToHost) {
+    value += stack->locals()[0].i;
+  }
+  *result = value;
+  return true;
+}
+
+}  // namespace
+
+SIMPLE_TEST(FrameLayout, ResolvesSlots) {
+  FrameLayout layout({"x", "y"});
+  EXPECT_EQ(2, layout.num_params());
+  EXPECT_EQ(0, layout.FindSlot("x"));
+  EXPECT_EQ(1, layout.FindSlot("y"));
+  EXPECT_EQ(2, layout.Declare("tmp"));
+  EXPECT_EQ(2, layout.Declare("tmp"));
+  EXPECT_EQ(1, layout.Declare("y"));
+  EXPECT_EQ(3, layout.num_slots());
+  EXPECT_EQ(FrameLayout::kNoSlot, layout.FindSlot("z"));
+}
+
+SIMPLE_TEST(CallStack, CallAndReturn) {
+  FrameLayout layout({"x"});
+  layout.Declare("local");
+  CallStack stack(16, 4);
+  stack.PrepareArgs(1)[0].i = 42;
+  Slot* frame = stack.Call(layout, 7);
+  EXPECT(frame != nullptr);
+  EXPECT_EQ(42, frame[0].i);
+  EXPECT_EQ(0, frame[1].i);
+  frame[1].d = 0.5;
+  stack.PrepareArgs(1)[0].i = 43;
+  Slot* inner = stack.Call(layout, 9);
+  EXPECT(inner == frame + 2);
+  EXPECT_EQ(43, inner[0].i);
+  EXPECT_EQ(2, stack.depth());
+  EXPECT_EQ(9, stack.Return());
+  EXPECT(stack.locals() == frame);
+  EXPECT_EQ(0.5, frame[1].d);
+  EXPECT_EQ(7, stack.Return());
+  EXPECT_EQ(0, stack.depth());
+  EXPECT_EQ(2, stack.max_depth_reached());
+}
+
+SIMPLE_TEST(CallStack, FramesFillingTheStack) {
+  // Only parameters, so the locals to clear start one past the last slot.
+  FrameLayout layout({"x", "y"});
+  CallStack stack(2, 4);
+  Slot* const args = stack.PrepareArgs(2);
+  args[0].i = 1;
+  args[1].i = 2;
+  Slot* const frame = stack.Call(layout, 3);
+  EXPECT(frame == args);
+  EXPECT_EQ(2, frame[1].i);
+  EXPECT(stack.PrepareArgs(0) != nullptr);
+  EXPECT(stack.PrepareArgs(1) == nullptr);
+  // No room to stage the arguments of a tail call above the frame.
+  EXPECT(stack.TailCall(layout) == nullptr);
+  EXPECT_EQ(3, stack.Return());
+}
+
+SIMPLE_TEST(CallStack, Fib) {
+  FrameLayout layout({"n"});
+  layout.Declare("a");
+  CallStack stack;
+  int64_t result = 0;
+  EXPECT(Fib(&stack, layout, 0, &result));
+  EXPECT_EQ(0, result);
+  EXPECT(Fib(&stack, layout, 1, &result));
+  EXPECT_EQ(1, result);
+  EXPECT(Fib(&stack, layout, 20, &result));
+  EXPECT_EQ(6765, result);
+  EXPECT_EQ(20, stack.max_depth_reached());
+  EXPECT_EQ(0, stack.depth());
+}
+
+SIMPLE_TEST_SERIAL(CallStack, CallsDoNotAllocate) {
+  FrameLayout layout({"n"});
+  layout.Declare("a");
+  CallStack stack;
+  int64_t result = 0;
+  const uint64_t allocations = AllocationCount();
+  EXPECT(Fib(&stack, layout, 15, &result));
+  EXPECT_EQ(allocations, AllocationCount());
+  EXPECT_EQ(610, result);
+}
+
+SIMPLE_TEST(CallStack, DeepRecursion) {
+  FrameLayout layout({"n"});
+  CallStack stack(CallStack::kDefaultCapacity, 200000);
+  int64_t result = 0;
+  EXPECT(Sum(&stack, layout, 100000, &result));
+  EXPECT_EQ(5000050000, result);
+  EXPECT_EQ(100001, stack.max_depth_reached());
+  // Running out of frames fails the call instead of overrunning the stack.
+  EXPECT(!Sum(&stack, layout, 300000, &result));
+  EXPECT_EQ(0, stack.depth());
+  CallStack small(1000, 200000);
+  EXPECT(!Sum(&small, layout, 5000, &result));
+  EXPECT_EQ(1000, small.max_depth_reached());
+}
+
+SIMPLE_TEST(CallStack, TailCallsRunInConstantSpace) {
+  FrameLayout layout({"n", "acc"});
+  CallStack stack(16, 4);
+  EXPECT_EQ(500000500000, TailSum(&stack, layout, 1000000));
+  EXPECT_EQ(1, stack.max_depth_reached());
+  EXPECT_EQ(0, stack.depth());
+}
+
+SIMPLE_TEST(CallStack, TailCallToOtherLayout) {
+  FrameLayout outer({"a"});
+  outer.Declare("b");
+  outer.Declare("c");
+  FrameLayout inner({"x", "y"});
+  CallStack stack(16, 4);
+  stack.PrepareArgs(1)[0].i = 1;
+  Slot* frame = stack.Call(outer, 5);
+  frame[1].i = 2;
+  frame[2].i = 3;
+  // Arguments swapped from the frame they replace.
+  Slot* args = stack.PrepareArgs(2);
+  args[0].i = frame[2].i;
+  args[1].i = frame[1].i;
+  Slot* tail = stack.TailCall(inner);
+  EXPECT(tail == frame);
+  EXPECT_EQ(3, tail[0].i);
+  EXPECT_EQ(2, tail[1].i);
+  EXPECT_EQ(5, stack.Return());
+  EXPECT(stack.TailCall(inner) == nullptr);
+}
+
+}  // namespace runtime
+}  // namespace elsh
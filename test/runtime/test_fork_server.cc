@@ -0,0 +1,208 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "runtime/fork_server.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+std::string SocketPath() {
+  return "/tmp/elsh_test_fork_server." + std::to_string(getpid()) + ".sock";
+}
+
+int ConnectRaw() {
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, SocketPath().c_str(), sizeof(address.sun_path) - 1);
+  const int connection = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (connect(connection, reinterpret_cast<const sockaddr*>(&address),
+              sizeof(address)) != 0) {
+    close(connection);
+    return -1;
+  }
+  return connection;
+}
+
+// Sends a request that passes only `fd` instead of stdout and stderr.
+bool SendOneFd(const int fd) {
+  const int connection = ConnectRaw();
+  if (connection < 0) {
+    return false;
+  }
+  char request[] = "one fd";
+  iovec iov{request, sizeof(request) - 1};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+  msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  cmsghdr* const header = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type = SCM_RIGHTS;
+  header->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(header), &fd, sizeof(fd));
+  const bool sent = sendmsg(connection, &message, 0) >= 0;
+  close(connection);
+  return sent;
+}
+
+}  // namespace
+
+// Forks the test process, keep it away from the parallel tests.
+SIMPLE_TEST_SERIAL(ForkServer, ChildrenStartFromPreparedState) {
+  std::string error;
+  const auto server = ForkServer::Listen(SocketPath(), &error);
+  EXPECT(server != nullptr);
+  if (server == nullptr) {
+    return;
+  }
+  EXPECT(ForkServer::Listen(SocketPath(), &error) == nullptr);
+  EXPECT(error.find("already listening") != std::string::npos);
+
+  // A child of the host process, which the server must not reap.
+  const pid_t unrelated = fork();
+  if (unrelated == 0) {
+    _exit(7);
+  }
+
+  // The children see every `prepare` the server ran before forking them.
+  int prepared = 0;
+  std::thread serving([&server, &prepared]() {
+    server->Serve([&prepared](const std::string&) { ++prepared; },
+                  [&prepared](const std::string& request) {
+                    const std::string reply = "hello " + request + "\n";
+                    if (write(STDOUT_FILENO, reply.data(), reply.size()) < 0) {
+                      return -1;
+                    }
+                    return prepared;
+                  },
+                  2);
+  });
+
+  int fds[2];
+  EXPECT_EQ(0, pipe(fds));
+  char reply[64];
+  for (int i = 1; i <= 2; ++i) {
+    int status = 0;
+    const std::string request = "request " + std::to_string(i);
+    EXPECT(SendForkRequest(SocketPath(), request, fds[1], fds[1], &status));
+    EXPECT_EQ(i, status);
+    const ssize_t size = read(fds[0], reply, sizeof(reply));
+    EXPECT_EQ("hello " + request + "\n",
+              std::string(reply, size > 0 ? size : 0));
+  }
+  serving.join();
+  close(fds[0]);
+  close(fds[1]);
+
+  int status = 0;
+  EXPECT_EQ(unrelated, waitpid(unrelated, &status, 0));
+  EXPECT(WIFEXITED(status));
+  EXPECT_EQ(7, WEXITSTATUS(status));
+  // The server waited for its own children before returning.
+  EXPECT_EQ(-1, waitpid(-1, nullptr, WNOHANG));
+}
+
+SIMPLE_TEST_SERIAL(ForkServer, MalformedRequestsLeakNoFds) {
+  std::string error;
+  const auto server = ForkServer::Listen(SocketPath(), &error);
+  EXPECT(server != nullptr);
+  if (server == nullptr) {
+    return;
+  }
+  std::thread serving([&server]() {
+    server->Serve([](const std::string&) {},
+                  [](const std::string&) { return 0; }, 1);
+  });
+
+  // The server has to close the one descriptor it got, or the pipe never
+  // reads end of file.
+  int fds[2];
+  EXPECT_EQ(0, pipe(fds));
+  EXPECT(SendOneFd(fds[1]));
+  close(fds[1]);
+  pollfd pfd{fds[0], POLLIN, 0};
+  EXPECT_EQ(1, poll(&pfd, 1, 5000));
+  char byte;
+  EXPECT_EQ(0, read(fds[0], &byte, 1));
+  close(fds[0]);
+
+  // The malformed request did not count, this one ends `Serve`.
+  int status = -1;
+  EXPECT(SendForkRequest(SocketPath(), "done", STDOUT_FILENO, STDERR_FILENO,
+                         &status));
+  EXPECT_EQ(0, status);
+  serving.join();
+}
+
+SIMPLE_TEST_SERIAL(ForkServer, SilentClientsTimeOut) {
+  std::string error;
+  const auto server = ForkServer::Listen(SocketPath(), &error);
+  EXPECT(server != nullptr);
+  if (server == nullptr) {
+    return;
+  }
+  struct stat st;
+  EXPECT_EQ(0, stat(SocketPath().c_str(), &st));
+  EXPECT_EQ(0600, st.st_mode & 0777);
+
+  std::thread serving([&server]() {
+    server->Serve([](const std::string&) {},
+                  [](const std::string&) { return 0; }, 1);
+  });
+  // Connects and never sends, the next request is served all the same.
+  const int silent = ConnectRaw();
+  EXPECT(silent >= 0);
+  int status = -1;
+  EXPECT(SendForkRequest(SocketPath(), "after", STDOUT_FILENO, STDERR_FILENO,
+                         &status));
+  EXPECT_EQ(0, status);
+  serving.join();
+  close(silent);
+}
+
+SIMPLE_TEST(ForkServer, NoServer) {
+  int status = 0;
+  EXPECT(!SendForkRequest("/tmp/elsh_test_no_such.sock", "x", STDOUT_FILENO,
+                          STDERR_FILENO, &status));
+  std::string error;
+  EXPECT(ForkServer::Listen(std::string(200, 'x'), &error) == nullptr);
+}
+
+}  // namespace runtime
+}  // namespace elsh
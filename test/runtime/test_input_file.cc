@@ -0,0 +1,197 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "runtime/input_file.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+// Temporary file holding `contents`, removed with the object.
+class TempFile {
+ public:
+  explicit TempFile(const std::string& contents) {
+    char path[] = "/tmp/elsh_input_XXXXXX";
+    const int fd = mkstemp(path);
+    close(fd);
+    path_ = path;
+    std::ofstream(path_, std::ios::binary) << contents;
+  }
+  ~TempFile() { unlink(path_.c_str()); }
+
+  const std::string& path() const { return path_; }
+
+ private:
+  std::string path_;
+};
+
+std::vector<std::string> Lines(InputFile* const input) {
+  std::vector<std::string> lines;
+  InputFile::View line;
+  while (input->NextLine(&line)) {
+    lines.push_back(line.ToString());
+  }
+  return lines;
+}
+
+}  // namespace
+
+SIMPLE_TEST(InputFile, MappedLines) {
+  const TempFile file("first\n\nthird\nno newline");
+  std::string error;
+  const auto input = InputFile::Open(file.path(), &error);
+  EXPECT(input != nullptr);
+  EXPECT(input->mode() == InputFile::Mode::kMapped);
+  const auto lines = Lines(input.get());
+  EXPECT_EQ(4, lines.size());
+  EXPECT_EQ("first", lines[0]);
+  EXPECT_EQ("", lines[1]);
+  EXPECT_EQ("third", lines[2]);
+  EXPECT_EQ("no newline", lines[3]);
+  EXPECT(!input->failed());
+}
+
+SIMPLE_TEST(InputFile, MappedViewsStayValid) {
+  const TempFile file("a\nb\n");
+  std::string error;
+  const auto input = InputFile::Open(file.path(), &error);
+  InputFile::View first;
+  InputFile::View second;
+  EXPECT(input->NextLine(&first));
+  EXPECT(input->NextLine(&second));
+  EXPECT(!input->NextLine(&second));
+  EXPECT_EQ("a", first.ToString());
+  EXPECT_EQ("b", second.ToString());
+}
+
+SIMPLE_TEST(InputFile, EmptyAndMissingFiles) {
+  const TempFile file("");
+  std::string error;
+  const auto input = InputFile::Open(file.path(), &error);
+  EXPECT(input != nullptr);
+  EXPECT(input->mode() == InputFile::Mode::kBuffered);
+  InputFile::View line;
+  EXPECT(!input->NextLine(&line));
+  EXPECT(!input->NextChunk(16, &line));
+
+  EXPECT(InputFile::Open("/nonexistent/input", &error) == nullptr);
+  EXPECT(error.find("/nonexistent/input") != std::string::npos);
+}
+
+SIMPLE_TEST(InputFile, BufferedLinesAcrossRefills) {
+  // A tiny buffer forces refills in the middle of lines and growing it for
+  // the long one.
+  std::string contents;
+  std::vector<std::string> expected;
+  for (int i = 0; i < 100; ++i) {
+    expected.push_back("line " + std::to_string(i));
+  }
+  expected.push_back(std::string(100, 'x'));
+  expected.push_back("last");
+  for (const auto& line : expected) {
+    contents += line + "\n";
+  }
+  const TempFile file(contents);
+  std::string error;
+  const auto input = InputFile::Open(file.path(), &error, 0, 8);
+  EXPECT(input->mode() == InputFile::Mode::kBuffered);
+  const auto lines = Lines(input.get());
+  EXPECT_EQ(expected.size(), lines.size());
+  for (size_t i = 0; i < expected.size() && i < lines.size(); ++i) {
+    EXPECT_EQ(expected[i], lines[i]);
+  }
+}
+
+SIMPLE_TEST(InputFile, Chunks) {
+  const TempFile file("0123456789abcdefghij");
+  for (const size_t map_threshold : {InputFile::kDefaultMapThreshold,
+                                     static_cast<size_t>(0)}) {
+    std::string error;
+    const auto input = InputFile::Open(file.path(), &error, map_threshold, 4);
+    std::vector<std::string> chunks;
+    InputFile::View chunk;
+    while (input->NextChunk(7, &chunk)) {
+      chunks.push_back(chunk.ToString());
+    }
+    EXPECT_EQ(3, chunks.size());
+    EXPECT_EQ("0123456", chunks[0]);
+    EXPECT_EQ("789abcd", chunks[1]);
+    EXPECT_EQ("efghij", chunks[2]);
+  }
+}
+
+SIMPLE_TEST(InputFile, GeneratedFiles) {
+  // Regular, but with a size of 0 until read.
+  std::string error;
+  const auto input = InputFile::Open("/proc/self/status", &error);
+  EXPECT(input != nullptr);
+  EXPECT(input->mode() == InputFile::Mode::kBuffered);
+  const auto lines = Lines(input.get());
+  EXPECT(!lines.empty());
+  EXPECT_EQ(0, lines[0].find("Name:"));
+}
+
+SIMPLE_TEST(InputFile, DegenerateSizes) {
+  const TempFile file("abc\n");
+  std::string error;
+  const auto input = InputFile::Open(file.path(), &error, 0, 0);
+  InputFile::View chunk;
+  EXPECT(!input->NextChunk(0, &chunk));
+  EXPECT(input->NextChunk(2, &chunk));
+  EXPECT_EQ("ab", chunk.ToString());
+  const auto lines = Lines(input.get());
+  EXPECT_EQ(1, lines.size());
+  EXPECT_EQ("c", lines[0]);
+  EXPECT(!input->failed());
+}
+
+SIMPLE_TEST(InputFile, Pipe) {
+  int fds[2];
+  EXPECT_EQ(0, pipe(fds));
+  const std::string contents = "from\na pipe\n";
+  EXPECT_EQ(static_cast<ssize_t>(contents.size()),
+            write(fds[1], contents.data(), contents.size()));
+  close(fds[1]);
+  const auto input = InputFile::FromFd(fds[0], 4);
+  const auto lines = Lines(input.get());
+  EXPECT_EQ(2, lines.size());
+  EXPECT_EQ("a pipe", lines[1]);
+  close(fds[0]);
+
+  // Reading an invalid descriptor is an error, not an empty input. Not the
+  // one just closed, which a test on another thread may be given again.
+  const auto invalid = InputFile::FromFd(-1);
+  InputFile::View line;
+  EXPECT(!invalid->NextLine(&line));
+  EXPECT(invalid->failed());
+}
+
+}  // namespace runtime
+}  // namespace elsh
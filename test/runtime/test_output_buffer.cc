@@ -0,0 +1,193 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <unistd.h>
+
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+#include "runtime/number_format.h"
+#include "runtime/output_buffer.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+std::string Int(const int64_t value) {
+  char str[kMaxIntegerChars];
+  return std::string(str, FormatInt(value, str));
+}
+
+std::string Double(const double value) {
+  char str[kMaxDoubleChars];
+  return std::string(str, FormatDouble(value, str));
+}
+
+std::string ReadAll(const int fd) {
+  std::string result;
+  char chunk[256];
+  ssize_t size;
+  while ((size = read(fd, chunk, sizeof(chunk))) > 0) {
+    result.append(chunk, size);
+  }
+  return result;
+}
+
+}  // namespace
+
+SIMPLE_TEST(Runtime, FormatInt) {
+  EXPECT_EQ("0", Int(0));
+  EXPECT_EQ("7", Int(7));
+  EXPECT_EQ("42", Int(42));
+  EXPECT_EQ("-100", Int(-100));
+  EXPECT_EQ("9223372036854775807",
+            Int(std::numeric_limits<int64_t>::max()));
+  EXPECT_EQ("-9223372036854775808",
+            Int(std::numeric_limits<int64_t>::min()));
+
+  char str[kMaxIntegerChars];
+  EXPECT_EQ(20, FormatUint(std::numeric_limits<uint64_t>::max(), str));
+  EXPECT_EQ("18446744073709551615", std::string(str, 20));
+}
+
+SIMPLE_TEST(Runtime, FormatDouble) {
+  EXPECT_EQ("0", Double(0.));
+  EXPECT_EQ("-0", Double(-0.));
+  EXPECT_EQ("100", Double(100.));
+  EXPECT_EQ("1.5", Double(1.5));
+  EXPECT_EQ("-2.25", Double(-2.25));
+  EXPECT_EQ("0.1", Double(0.1));
+  EXPECT_EQ("0.30000000000000004", Double(0.1 + 0.2));
+  EXPECT_EQ("0.0001", Double(1e-4));
+  EXPECT_EQ("1e-05", Double(1e-5));
+  EXPECT_EQ("1.2345e+20", Double(1.2345e20));
+  EXPECT_EQ("1e+17", Double(1e17));
+  EXPECT_EQ("1234567890123456", Double(1234567890123456.));
+  EXPECT_EQ("inf", Double(std::numeric_limits<double>::infinity()));
+  EXPECT_EQ("nan", Double(std::numeric_limits<double>::quiet_NaN()));
+
+  const double values[] = {3.141592653589793, 2.718281828459045e-300,
+                           1.7976931348623157e308, 5e-324, 123.456};
+  for (const double value : values) {
+    EXPECT_EQ(value, std::strtod(Double(value).c_str(), nullptr));
+  }
+}
+
+SIMPLE_TEST(Runtime, FormatDoubleShortest) {
+  // Subnormals need fewer than 15 digits, and some normals need 16 digits
+  // that are not `%.16e`.
+  EXPECT_EQ("5e-324", Double(5e-324));
+  EXPECT_EQ("1.6e-322", Double(1.6e-322));
+  EXPECT_EQ("2.225073858507201e-308", Double(2.225073858507201e-308));
+  EXPECT_EQ("6.083493012144512e-210", Double(6.083493012144512e-210));
+  EXPECT_EQ("1.7976931348623157e+308", Double(1.7976931348623157e308));
+  EXPECT_EQ("9007199254740992", Double(9007199254740993.));
+
+  // Every double reads back, and one digit less never does.
+  std::mt19937_64 rng(42);
+  for (int i = 0; i < 100000; ++i) {
+    const uint64_t bits = rng();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    // Integral values print all their digits, trailing zeros included.
+    if (!std::isfinite(value) || value == std::trunc(value)) {
+      continue;
+    }
+    const std::string formatted = Double(value);
+    EXPECT_EQ(value, std::strtod(formatted.c_str(), nullptr));
+    const size_t end = formatted.find('e');
+    int num_digits = 0;
+    bool leading = true;
+    for (size_t j = 0; j < formatted.size() && j < end; ++j) {
+      if (formatted[j] >= '1' && formatted[j] <= '9') {
+        leading = false;
+      }
+      num_digits += !leading && std::isdigit(formatted[j]);
+    }
+    if (num_digits > 1) {
+      char shorter[kMaxDoubleChars];
+      std::snprintf(shorter, sizeof(shorter), "%.*e", num_digits - 2, value);
+      EXPECT(std::strtod(shorter, nullptr) != value);
+    }
+  }
+}
+
+SIMPLE_TEST(Runtime, OutputBuffer) {
+  int fds[2];
+  EXPECT_EQ(0, pipe(fds));
+  {
+    OutputBuffer out(fds[1]);
+    out.Write("a = ");
+    out.PrintInt(-3);
+    out.PutChar(',');
+    out.PrintDouble(0.5);
+    out.PutChar('\n');
+    // Nothing is written before the buffer is flushed or destroyed.
+    EXPECT_EQ(11, out.size());
+    EXPECT(out.Flush());
+    EXPECT_EQ(0, out.size());
+    out.Write("tail");
+  }
+  close(fds[1]);
+  EXPECT_EQ("a = -3,0.5\ntail", ReadAll(fds[0]));
+  close(fds[0]);
+}
+
+SIMPLE_TEST(Runtime, OutputBufferSmallCapacity) {
+  int fds[2];
+  EXPECT_EQ(0, pipe(fds));
+  std::string expected;
+  {
+    OutputBuffer out(fds[1], 64);
+    EXPECT_EQ(64, out.capacity());
+    for (int i = 0; i < 100; ++i) {
+      out.PrintInt(i);
+      out.PutChar(' ');
+      expected += std::to_string(i) + " ";
+      EXPECT_LE(out.size(), out.capacity());
+    }
+    // Larger than the whole buffer, written through.
+    const std::string large(200, 'x');
+    out.Write(large);
+    expected += large;
+    EXPECT_EQ(0, out.size());
+
+    out.SetLineBuffered(true);
+    out.Write("line\n");
+    expected += "line\n";
+    EXPECT_EQ(0, out.size());
+  }
+  close(fds[1]);
+  EXPECT_EQ(expected, ReadAll(fds[0]));
+  close(fds[0]);
+}
+
+}  // namespace runtime
+}  // namespace elsh
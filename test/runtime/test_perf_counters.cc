@@ -0,0 +1,125 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <sstream>
+#include <string>
+
+#include "runtime/perf_counters.h"
+#include "runtime/stats.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+volatile uint64_t g_sink = 0;
+
+void Spin(const int iterations) {
+  for (int i = 0; i < iterations; ++i) {
+    g_sink = g_sink + i;
+  }
+}
+}  // namespace
+
+SIMPLE_TEST(PerfCounters, ValuesArithmetic) {
+  PerfValues a;
+  a.counts[static_cast<size_t>(PerfEvent::kCycles)] = 200;
+  a.counts[static_cast<size_t>(PerfEvent::kInstructions)] = 300;
+  PerfValues b = a;
+  b += a;
+  EXPECT_EQ(400, b[PerfEvent::kCycles]);
+  EXPECT_EQ(600, b[PerfEvent::kInstructions]);
+  EXPECT_EQ(200, (b - a)[PerfEvent::kCycles]);
+  // Scaled estimates going backwards do not wrap around.
+  EXPECT_EQ(0, (a - b)[PerfEvent::kCycles]);
+  EXPECT_EQ(1.5, a.Ipc());
+  EXPECT_EQ(0., PerfValues().Ipc());
+}
+
+// Counters may be missing altogether here, in containers and virtual
+// machines, the checks only use the events that opened.
+SIMPLE_TEST(PerfCounters, CountsOrDegrades) {
+  const PerfCounters counters;
+  EXPECT(counters.available() || !counters.error().empty());
+
+  PerfValues values;
+  {
+    PerfCounters::ScopedRegion region(&counters, &values);
+    Spin(100000);
+  }
+  for (size_t i = 0; i < kNumPerfEvents; ++i) {
+    const PerfEvent event = static_cast<PerfEvent>(i);
+    if (!counters.IsOpen(event)) {
+      EXPECT_EQ(0, values[event]);
+    }
+  }
+  if (counters.IsOpen(PerfEvent::kInstructions)) {
+    EXPECT(values[PerfEvent::kInstructions] >= 100000);
+  }
+}
+
+SIMPLE_TEST(PerfCounters, Report) {
+  const PerfCounters counters;
+  PerfValues values;
+  values.counts[static_cast<size_t>(PerfEvent::kInstructions)] = 1000;
+  std::ostringstream os;
+  const std::ios_base::fmtflags flags = os.flags();
+  const std::streamsize precision = os.precision();
+  counters.Report(values, 10, "token", &os);
+  EXPECT(os.flags() == flags);
+  EXPECT_EQ(precision, os.precision());
+  const std::string report = os.str();
+  EXPECT(report.find("branch-misses") != std::string::npos);
+  EXPECT(report.find("IPC") != std::string::npos);
+  if (counters.IsOpen(PerfEvent::kInstructions)) {
+    EXPECT(report.find("100.00 /token") != std::string::npos);
+  } else {
+    EXPECT(report.find("n/a") != std::string::npos);
+  }
+}
+
+SIMPLE_TEST(PerfCounters, StatsPhases) {
+  const PerfCounters counters;
+  Stats stats;
+  stats.set_perf_counters(&counters);
+  {
+    Stats::ScopedPhase phase(&stats, "lex");
+    Spin(1000);
+  }
+  std::ostringstream os;
+  stats.WriteJson(&os);
+  EXPECT(os.str().find("\"perf\": {\"cycles\": ") != std::string::npos);
+  if (counters.IsOpen(PerfEvent::kInstructions)) {
+    EXPECT(stats.phases()[0].perf[PerfEvent::kInstructions] > 0);
+  }
+
+  // Without counters the json stays as it was.
+  Stats plain;
+  {
+    Stats::ScopedPhase phase(&plain, "lex");
+  }
+  os.str("");
+  plain.WriteJson(&os);
+  EXPECT(os.str().find("perf") == std::string::npos);
+}
+
+}  // namespace runtime
+}  // namespace elsh
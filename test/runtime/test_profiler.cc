@@ -0,0 +1,146 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <signal.h>
+
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include "runtime/profiler.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+std::string OpName(const uint16_t op) { return "op" + std::to_string(op); }
+
+int g_host_signals = 0;
+void OnHostSignal(int) { ++g_host_signals; }
+
+}  // namespace
+
+SIMPLE_TEST(Profiler, CountsExecutions) {
+  Profiler profiler;
+  profiler.Record(1, 7);
+  profiler.Record(1, 8);
+  profiler.Record(2, 7);
+  EXPECT_EQ(2, profiler.line(1).count);
+  EXPECT_EQ(1, profiler.line(2).count);
+  EXPECT_EQ(0, profiler.line(3).count);
+  EXPECT_EQ(2, profiler.op(7).count);
+  EXPECT_EQ(1, profiler.op(8).count);
+  // Not started, so nothing is sampled.
+  EXPECT_EQ(0, profiler.total_samples());
+
+  std::ostringstream report;
+  const std::ios_base::fmtflags flags = report.flags();
+  const std::streamsize precision = report.precision();
+  profiler.Report(OpName, &report);
+  EXPECT(report.str().find("op7") != std::string::npos);
+  EXPECT(report.flags() == flags);
+  EXPECT_EQ(precision, report.precision());
+  std::ostringstream folded;
+  profiler.WriteFolded("script", OpName, &folded);
+  EXPECT_EQ("", folded.str());
+}
+
+// Serial, as the sampling timer is process wide.
+SIMPLE_TEST_SERIAL(Profiler, SamplesBusyLoop) {
+  Profiler profiler(1000);
+  EXPECT(profiler.Start());
+  Profiler other;
+  // The timer is process wide.
+  EXPECT(!other.Start());
+
+  const auto end =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+  volatile uint64_t sink = 0;
+  while (std::chrono::steady_clock::now() < end) {
+    for (int i = 0; i < 1000; ++i) {
+      sink = sink + i;
+    }
+    profiler.Record(3, 1);
+  }
+  profiler.Stop();
+  EXPECT_GT(profiler.total_samples(), 0);
+  EXPECT_EQ(profiler.total_samples(), profiler.line(3).samples);
+
+  std::ostringstream folded;
+  profiler.WriteFolded("script", OpName, &folded);
+  EXPECT_EQ(0, folded.str().find("script;line 3;op1 "));
+
+  EXPECT(other.Start());
+  other.Stop();
+}
+
+SIMPLE_TEST_SERIAL(Profiler, NegativeLinesAreLineZero) {
+  Profiler profiler(1000);
+  EXPECT(profiler.Start());
+  const auto end =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+  volatile uint64_t sink = 0;
+  while (std::chrono::steady_clock::now() < end) {
+    for (int i = 0; i < 1000; ++i) {
+      sink = sink + i;
+    }
+    profiler.Record(-1, 2);
+  }
+  profiler.Stop();
+  EXPECT_GT(profiler.total_samples(), 0);
+  EXPECT_EQ(profiler.total_samples(), profiler.line(0).samples);
+
+  std::ostringstream folded;
+  profiler.WriteFolded("script", OpName, &folded);
+  EXPECT_EQ(0, folded.str().find("script;line 0;op2 "));
+}
+
+SIMPLE_TEST_SERIAL(Profiler, RestoresTheHostHandler) {
+  struct sigaction host;
+  memset(&host, 0, sizeof(host));
+  host.sa_handler = OnHostSignal;
+  sigemptyset(&host.sa_mask);
+  struct sigaction old;
+  EXPECT_EQ(0, sigaction(SIGPROF, &host, &old));
+
+  Profiler profiler(100);
+  EXPECT(profiler.Start());
+  const auto end =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(20);
+  while (std::chrono::steady_clock::now() < end) {
+  }
+  profiler.Stop();
+  // The profiler's ticks never reach the host's handler.
+  EXPECT_EQ(0, g_host_signals);
+
+  struct sigaction current;
+  EXPECT_EQ(0, sigaction(SIGPROF, nullptr, &current));
+  EXPECT(current.sa_handler == OnHostSignal);
+  raise(SIGPROF);
+  EXPECT_EQ(1, g_host_signals);
+  sigaction(SIGPROF, &old, nullptr);
+}
+
+}  // namespace runtime
+}  // namespace elsh
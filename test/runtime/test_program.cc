@@ -0,0 +1,145 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "runtime/program.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+// Run `context` and return everything it printed. A positive `slice_fuel`
+// runs it in preempted slices of that many steps, counted in `slices`.
+std::string RunToString(const std::shared_ptr<const Program>& program,
+                        const std::vector<std::pair<std::string, int64_t>>&
+                            inputs = {},
+                        const int64_t slice_fuel = 0,
+                        int* const slices = nullptr) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return "";
+  }
+  {
+    Context context(program, fds[1]);
+    for (const auto& input : inputs) {
+      context.SetInput(input.first, input.second);
+    }
+    if (slice_fuel <= 0) {
+      context.Run();
+    } else {
+      Context::RunState state = Context::RunState::kPreempted;
+      for (*slices = 0; state == Context::RunState::kPreempted; ++*slices) {
+        int64_t fuel = slice_fuel;
+        state = context.Resume(&fuel);
+      }
+    }
+  }
+  close(fds[1]);
+  std::string result;
+  char chunk[256];
+  ssize_t size;
+  while ((size = read(fds[0], chunk, sizeof(chunk))) > 0) {
+    result.append(chunk, size);
+  }
+  close(fds[0]);
+  return result;
+}
+
+}  // namespace
+
+SIMPLE_TEST(Program, CompileError) {
+  std::string error;
+  EXPECT(Program::Compile("int a = 1;\nchar c = '';\n", &error) == nullptr);
+  EXPECT_EQ("line 2, col 10: empty character constant", error);
+}
+
+SIMPLE_TEST(Program, ResolvesSlots) {
+  std::string error;
+  const auto program = Program::Compile("a = b + a;", &error);
+  EXPECT(program != nullptr);
+  EXPECT_EQ(2, program->num_slots());
+  EXPECT_EQ(0, program->FindSlot("a"));
+  EXPECT_EQ(1, program->FindSlot("b"));
+  EXPECT_EQ(Program::kNoSlot, program->FindSlot("c"));
+  EXPECT_EQ(0, program->token_slot(0));
+  EXPECT_EQ(Program::kNoSlot, program->token_slot(1));
+  EXPECT_EQ(1, program->token_slot(2));
+  EXPECT_EQ(0, program->token_slot(4));
+}
+
+SIMPLE_TEST(Program, BindsInputs) {
+  std::string error;
+  const auto program = Program::Compile("print(limit);", &error);
+  Context context(program, -1);
+  EXPECT(context.SetInput("limit", int64_t{3}));
+  EXPECT(!context.SetInput("other", int64_t{3}));
+
+  const std::string unbound = RunToString(program);
+  EXPECT(unbound.find("Identifier       limit") != std::string::npos);
+  const std::string bound = RunToString(program, {{"limit", 42}});
+  EXPECT(bound.find("     1:   7                Value_int          42\n") !=
+         std::string::npos);
+}
+
+SIMPLE_TEST(Program, ResumesPreemptedRuns) {
+  std::string error;
+  const auto program =
+      Program::Compile("for(int i = 0; i < n; i += 1) { print(i); }", &error);
+  EXPECT_EQ(24, program->tokens().size());
+  const std::string expected = RunToString(program, {{"n", 10}});
+  int slices = 0;
+  EXPECT_EQ(expected, RunToString(program, {{"n", 10}}, 3, &slices));
+  EXPECT_EQ(8, slices);
+  EXPECT_EQ(expected, RunToString(program, {{"n", 10}}, 24, &slices));
+  EXPECT_EQ(1, slices);
+}
+
+SIMPLE_TEST(Program, ConcurrentRuns) {
+  std::string error;
+  const auto program =
+      Program::Compile("for(int i = 0; i < n; i += 1) { print(i); }", &error);
+  const std::string expected = RunToString(program, {{"n", 10}});
+  std::vector<std::string> outputs(4);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    threads.emplace_back([&program, &outputs, i]() {
+      for (int run = 0; run < 100; ++run) {
+        outputs[i] = RunToString(program, {{"n", 10}});
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& output : outputs) {
+    EXPECT_EQ(expected, output);
+  }
+}
+
+}  // namespace runtime
+}  // namespace elsh
@@ -0,0 +1,152 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "runtime/scheduler.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+// A script spinning in `while (true) {}`.
+Context::RunState Spin(int64_t* const fuel) {
+  *fuel = 0;
+  return Context::RunState::kPreempted;
+}
+
+}  // namespace
+
+SIMPLE_TEST(Scheduler, RunsContexts) {
+  std::string error;
+  const auto program =
+      Program::Compile("for(int i = 0; i < n; i += 1) { print(i); }", &error);
+  Scheduler::Limits limits;
+  limits.slice_fuel = 4;
+  const int dev_null = open("/dev/null", O_WRONLY);
+  Scheduler scheduler(2);
+  std::vector<int> ids;
+  for (int i = 0; i < 8; ++i) {
+    auto context = std::make_shared<Context>(program, dev_null);
+    context->SetInput("n", int64_t{i});
+    ids.push_back(scheduler.Submit(context, limits));
+  }
+  scheduler.Wait();
+  for (const int id : ids) {
+    const Scheduler::Status status = scheduler.status(id);
+    EXPECT(status.outcome == Scheduler::Outcome::kDone);
+    EXPECT_EQ(24, status.fuel_used);
+    EXPECT_EQ(6, status.slices);
+  }
+  EXPECT_EQ(8, scheduler.finish_order().size());
+  close(dev_null);
+}
+
+SIMPLE_TEST(Scheduler, RunawayScriptDoesNotStarveOthers) {
+  std::string error;
+  const auto program = Program::Compile("print(1);", &error);
+  Scheduler::Limits runaway_limits;
+  runaway_limits.slice_fuel = 100;
+  runaway_limits.max_fuel = 100000;
+  Scheduler::Limits limits;
+  limits.slice_fuel = 100;
+
+  const int dev_null = open("/dev/null", O_WRONLY);
+
+  // One worker, so every script has to wait for the runaway's slices.
+  Scheduler scheduler(1);
+  const int runaway = scheduler.Submit(Spin, runaway_limits);
+  std::vector<int> ids;
+  for (int i = 0; i < 10; ++i) {
+    ids.push_back(
+        scheduler.Submit(std::make_shared<Context>(program, dev_null), limits));
+  }
+  scheduler.Wait();
+
+  const Scheduler::Status status = scheduler.status(runaway);
+  EXPECT(status.outcome == Scheduler::Outcome::kOutOfFuel);
+  EXPECT_EQ(100000, status.fuel_used);
+  EXPECT_EQ(1000, status.slices);
+  for (const int id : ids) {
+    EXPECT(scheduler.status(id).outcome == Scheduler::Outcome::kDone);
+  }
+  const std::vector<int> order = scheduler.finish_order();
+  EXPECT_EQ(11, order.size());
+  EXPECT_EQ(runaway, order.back());
+  close(dev_null);
+}
+
+SIMPLE_TEST(Scheduler, EmptySlicesStillMakeProgress) {
+  std::string error;
+  const auto program = Program::Compile("print(1);", &error);
+  Scheduler::Limits limits;
+  limits.slice_fuel = 0;
+  const int dev_null = open("/dev/null", O_WRONLY);
+  Scheduler scheduler(1);
+  const int id =
+      scheduler.Submit(std::make_shared<Context>(program, dev_null), limits);
+  scheduler.Wait();
+  const Scheduler::Status status = scheduler.status(id);
+  EXPECT(status.outcome == Scheduler::Outcome::kDone);
+  EXPECT_EQ(status.fuel_used, status.slices);
+  close(dev_null);
+}
+
+SIMPLE_TEST(Scheduler, MemoryLimit) {
+  auto chunks = std::make_shared<std::vector<std::unique_ptr<char[]>>>();
+  const auto hog = [chunks](int64_t* const fuel) {
+    chunks->emplace_back(new char[1 << 20]);
+    chunks->back()[0] = 1;
+    *fuel = 0;
+    return Context::RunState::kPreempted;
+  };
+  Scheduler::Limits limits;
+  // Room for eight chunks and their bookkeeping, but not for nine.
+  limits.max_memory = (8 << 20) + (1 << 19);
+  Scheduler scheduler(2);
+  const int id = scheduler.Submit(hog, limits);
+  scheduler.Wait();
+  const Scheduler::Status status = scheduler.status(id);
+  EXPECT(status.outcome == Scheduler::Outcome::kOutOfMemory);
+  EXPECT_EQ(9, status.slices);
+  EXPECT_GT(status.live_bytes, 9 << 20);
+}
+
+SIMPLE_TEST(Scheduler, FailedRun) {
+  std::string error;
+  const auto program = Program::Compile("print(1);", &error);
+  Scheduler scheduler(1);
+  // Writing to a closed descriptor fails.
+  const int id = scheduler.Submit(std::make_shared<Context>(program, -1),
+                                  Scheduler::Limits());
+  scheduler.Wait();
+  EXPECT(scheduler.status(id).outcome == Scheduler::Outcome::kFailed);
+}
+
+}  // namespace runtime
+}  // namespace elsh
@@ -0,0 +1,107 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "runtime/session.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+// Everything written to the read end of `fds` so far.
+std::string ReadAvailable(const int fd) {
+  std::string result;
+  char chunk[256];
+  ssize_t size;
+  while ((size = read(fd, chunk, sizeof(chunk))) > 0) {
+    result.append(chunk, size);
+  }
+  return result;
+}
+
+}  // namespace
+
+SIMPLE_TEST(Session, KeepsDefinitions) {
+  int fds[2];
+  EXPECT_EQ(0, pipe(fds));
+  fcntl(fds[0], F_SETFL, O_NONBLOCK);
+  Session session(fds[1]);
+  std::string error;
+  EXPECT(session.Eval("limit = 10;\n", &error));
+  EXPECT(session.IsBound("limit"));
+  EXPECT_EQ("     1:   1               Identifier       limit\n"
+            "     1:   7                Op_assign\n"
+            "     1:   9                Value_int          10\n"
+            "     1:  11         Symbol_Semicolon\n",
+            ReadAvailable(fds[0]));
+
+  EXPECT(session.Eval("print(limit, other);\n", &error));
+  EXPECT_EQ(2, session.num_slots());
+  EXPECT(!session.IsBound("other"));
+  const std::string output = ReadAvailable(fds[0]);
+  EXPECT(output.find("     2:   7                Value_int          10\n") !=
+         std::string::npos);
+  EXPECT(output.find("Identifier       other") != std::string::npos);
+  EXPECT_EQ(3, session.next_line());
+  close(fds[0]);
+  close(fds[1]);
+}
+
+SIMPLE_TEST(Session, ErrorsLeaveStateAlone) {
+  Session session(-1);
+  std::string error;
+  EXPECT(!session.Eval("a = 1;\n", &error));  // nowhere to write
+  EXPECT(error.empty());
+  EXPECT(session.IsBound("a"));
+  const size_t num_tokens = session.tokens().size();
+  EXPECT(!session.Eval("b = 2; char c = '';\n", &error));
+  EXPECT_EQ("line 2, col 17: empty character constant", error);
+  EXPECT_EQ(num_tokens, session.tokens().size());
+  EXPECT_EQ(-1, session.FindSlot("b"));
+  EXPECT_EQ(3, session.next_line());
+  EXPECT(!session.Eval("a = 2; b = a;", &error));
+  EXPECT_EQ(4, session.next_line());
+  EXPECT_EQ(3, session.tokens().back().err_ln);
+}
+
+SIMPLE_TEST(Session, ManyDefinitions) {
+  const int dev_null = open("/dev/null", O_WRONLY);
+  Session session(dev_null);
+  std::string error;
+  for (int i = 0; i < 5000; ++i) {
+    const std::string name = "v" + std::to_string(i);
+    EXPECT(session.Eval(name + " = " + std::to_string(i) + ";\n", &error));
+  }
+  EXPECT_EQ(5000, session.num_slots());
+  EXPECT_EQ(20000, session.tokens().size());
+  EXPECT_EQ(4999, session.FindSlot("v4999"));
+  EXPECT_EQ(5000, session.tokens().back().err_ln);
+  close(dev_null);
+}
+
+}  // namespace runtime
+}  // namespace elsh
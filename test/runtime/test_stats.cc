@@ -0,0 +1,113 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "runtime/stats.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+// Keeps the compiler from eliding allocations the tests want to count.
+void* volatile g_sink = nullptr;
+
+int g_new_handler_calls = 0;
+
+void GiveUp() {
+  ++g_new_handler_calls;
+  std::set_new_handler(nullptr);
+}
+}  // namespace
+
+SIMPLE_TEST_SERIAL(Stats, CountsAllocations) {
+  const uint64_t allocations = AllocationCount();
+  const uint64_t allocated_bytes = AllocatedBytes();
+  std::unique_ptr<char[]> chunk(new char[1000]);
+  g_sink = chunk.get();
+  EXPECT_EQ(allocations + 1, AllocationCount());
+  EXPECT_EQ(allocated_bytes + 1000, AllocatedBytes());
+}
+
+SIMPLE_TEST_SERIAL(Stats, CountsExitedThreads) {
+  const uint64_t allocations = AllocationCount();
+  const uint64_t allocated_bytes = AllocatedBytes();
+  std::thread thread([] {
+    std::unique_ptr<char[]> chunk(new char[1000]);
+    g_sink = chunk.get();
+  });
+  thread.join();
+  EXPECT_GE(AllocationCount(), allocations + 1);
+  EXPECT_GE(AllocatedBytes(), allocated_bytes + 1000);
+}
+
+SIMPLE_TEST_SERIAL(Stats, CallsTheNewHandler) {
+  const uint64_t allocations = AllocationCount();
+  volatile std::size_t huge = std::size_t(1) << 62;
+  g_new_handler_calls = 0;
+  std::set_new_handler(GiveUp);
+  g_sink = new (std::nothrow) char[huge];
+  EXPECT(g_sink == nullptr);
+  EXPECT_EQ(1, g_new_handler_calls);
+  EXPECT_EQ(allocations, AllocationCount());
+}
+
+SIMPLE_TEST_SERIAL(Stats, ScopedPhases) {
+  Stats stats;
+  {
+    Stats::ScopedPhase phase(&stats, "lex");
+    std::vector<int> values(100);
+    g_sink = values.data();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  {
+    Stats::ScopedPhase phase(&stats, "execute");
+  }
+  {
+    Stats::ScopedPhase phase(&stats, "lex");
+    std::unique_ptr<int> value(new int(1));
+    g_sink = value.get();
+  }
+
+  const auto& phases = stats.phases();
+  EXPECT_EQ(2, phases.size());
+  EXPECT_EQ("lex", phases[0].name);
+  EXPECT_EQ(2, phases[0].allocations);
+  EXPECT_EQ(100 * sizeof(int) + sizeof(int), phases[0].allocated_bytes);
+  EXPECT_GE(phases[0].wall_ns, 2000000);
+  EXPECT_EQ("execute", phases[1].name);
+  EXPECT_EQ(0, phases[1].allocations);
+  EXPECT_EQ(phases[0].wall_ns + phases[1].wall_ns, stats.Total().wall_ns);
+
+  std::ostringstream json;
+  stats.WriteJson(&json);
+  EXPECT_EQ(0, json.str().find("{\"phases\": [{\"name\": \"lex\", "));
+  EXPECT(json.str().find("\"total\": {") != std::string::npos);
+}
+
+}  // namespace runtime
+}  // namespace elsh
@@ -0,0 +1,186 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "runtime/string_kernels.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+const KernelSet kKernelSets[] = {KernelSet::kScalar, KernelSet::kSse2,
+                                 KernelSet::kAvx2};
+
+// Few distinct letters, so that first and last bytes of needles match often.
+std::string RandomString(const size_t size, std::mt19937* const rng) {
+  std::uniform_int_distribution<int> dist('a', 'd');
+  std::string str(size, ' ');
+  for (auto& c : str) {
+    c = static_cast<char>(dist(*rng));
+  }
+  return str;
+}
+
+size_t CountBytes(const std::string& str, const char c) {
+  size_t count = 0;
+  for (const char b : str) {
+    count += b == c;
+  }
+  return count;
+}
+
+}  // namespace
+
+SIMPLE_TEST(StringKernels, KernelsMatchStdString) {
+  std::mt19937 rng(42);
+  for (const KernelSet kernel_set : kKernelSets) {
+    if (!IsSupported(kernel_set)) {
+      continue;
+    }
+    const StringKernels& kernels = GetStringKernels(kernel_set);
+    for (size_t size = 0; size < 300; ++size) {
+      const std::string str = RandomString(size, &rng);
+      for (const char c : std::string("abcz")) {
+        const size_t expected = str.find(c);
+        EXPECT_EQ(expected == std::string::npos ? kNotFound : expected,
+                  kernels.find_byte(str.data(), str.size(), c));
+        EXPECT_EQ(CountBytes(str, c),
+                  kernels.count_byte(str.data(), str.size(), c));
+      }
+      for (size_t needle_size = 2; needle_size < 40; ++needle_size) {
+        const std::string needle = RandomString(needle_size, &rng);
+        const size_t expected = str.find(needle);
+        EXPECT_EQ(expected == std::string::npos ? kNotFound : expected,
+                  kernels.find(str.data(), str.size(), needle.data(),
+                               needle.size()));
+      }
+    }
+  }
+}
+
+SIMPLE_TEST(StringKernels, MatchesAtTheEnd) {
+  for (const KernelSet kernel_set : kKernelSets) {
+    if (!IsSupported(kernel_set)) {
+      continue;
+    }
+    const StringKernels& kernels = GetStringKernels(kernel_set);
+    for (size_t size = 2; size < 100; ++size) {
+      std::string str(size, 'a');
+      str[size - 1] = 'b';
+      EXPECT_EQ(size - 1, kernels.find_byte(str.data(), str.size(), 'b'));
+      EXPECT_EQ(size - 2, kernels.find(str.data(), str.size(), "ab", 2));
+      EXPECT_EQ(kNotFound, kernels.find(str.data(), str.size() - 1, "ab", 2));
+    }
+  }
+}
+
+SIMPLE_TEST(StringKernels, MatchesInsideUnrolledBlocks) {
+  // The byte scans test 64 or 128 bytes per step and only then look for the
+  // match, put it at every offset of such blocks and of the tails.
+  for (const KernelSet kernel_set : kKernelSets) {
+    if (!IsSupported(kernel_set)) {
+      continue;
+    }
+    const StringKernels& kernels = GetStringKernels(kernel_set);
+    for (const size_t size : {127, 128, 129, 255, 256, 257, 300}) {
+      for (size_t at = 0; at < size; ++at) {
+        std::string str(size, 'x');
+        str[at] = 'y';
+        EXPECT_EQ(at, kernels.find_byte(str.data(), str.size(), 'y'));
+        EXPECT_EQ(1u, kernels.count_byte(str.data(), str.size(), 'y'));
+        for (const std::string needle : {"yx", "yxxxxxxxxxxxxxxxxy"}) {
+          str.replace(at, std::min(needle.size(), size - at), needle, 0,
+                      std::min(needle.size(), size - at));
+          const size_t expected = str.find(needle);
+          EXPECT_EQ(expected == std::string::npos ? kNotFound : expected,
+                    kernels.find(str.data(), str.size(), needle.data(),
+                                 needle.size()));
+        }
+      }
+    }
+  }
+}
+
+SIMPLE_TEST(StringKernels, CountLongStrings) {
+  // Beyond 255 vector steps, where the per-byte counters are flushed.
+  const std::string str(100000, 'x');
+  for (const KernelSet kernel_set : kKernelSets) {
+    if (IsSupported(kernel_set)) {
+      EXPECT_EQ(str.size(), GetStringKernels(kernel_set)
+                                .count_byte(str.data(), str.size(), 'x'));
+    }
+  }
+}
+
+SIMPLE_TEST(StringKernels, Find) {
+  const StringSlice str = "one, two, three";
+  EXPECT_EQ(3u, StringFind(str, ","));
+  EXPECT_EQ(8u, StringFind(str, ",", 4));
+  EXPECT_EQ(5u, StringFind(str, "two"));
+  EXPECT_EQ(kNotFound, StringFind(str, "four"));
+  EXPECT_EQ(kNotFound, StringFind(str, "one", 1));
+  EXPECT_EQ(4u, StringFind(str, "", 4));
+  EXPECT_EQ(kNotFound, StringFind(str, "", str.size + 1));
+  EXPECT(StringContains(str, "three"));
+  EXPECT(!StringContains(str, "threes"));
+  EXPECT(!StringContains(StringSlice(), "a"));
+}
+
+SIMPLE_TEST(StringKernels, Count) {
+  EXPECT_EQ(2u, StringCount("one, two, three", ","));
+  EXPECT_EQ(2u, StringCount("aaaaa", "aa"));
+  EXPECT_EQ(0u, StringCount("abc", "abcd"));
+  EXPECT_EQ(4u, StringCount("abc", ""));
+}
+
+SIMPLE_TEST(StringKernels, SplitReferencesTheString) {
+  const std::string str = "a,,bc,";
+  std::vector<StringSlice> fields;
+  StringSplit(StringSlice(str), ",", &fields);
+  EXPECT_EQ(4u, fields.size());
+  EXPECT_EQ(std::string("a"), fields[0].ToString());
+  EXPECT_EQ(std::string(""), fields[1].ToString());
+  EXPECT_EQ(std::string("bc"), fields[2].ToString());
+  EXPECT_EQ(std::string(""), fields[3].ToString());
+  EXPECT(fields[2].data == str.data() + 3);
+  EXPECT(fields[3].data == str.data() + str.size());
+
+  StringSplit("key := value := more", " := ", &fields);
+  EXPECT_EQ(3u, fields.size());
+  EXPECT_EQ(std::string("value"), fields[1].ToString());
+
+  StringSplit("", ",", &fields);
+  EXPECT_EQ(1u, fields.size());
+  EXPECT_EQ(0u, fields[0].size);
+
+  StringSplit("abc", "", &fields);
+  EXPECT_EQ(1u, fields.size());
+  EXPECT_EQ(3u, fields[0].size);
+}
+
+}  // namespace runtime
+}  // namespace elsh
@@ -0,0 +1,154 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "runtime/thread_pool.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace runtime {
+
+SIMPLE_TEST(ThreadPool, CoversRangeOnce) {
+  for (const int num_threads : {0, 1, 3}) {
+    ThreadPool pool(num_threads);
+    EXPECT_EQ(num_threads + 1, pool.concurrency());
+    std::vector<std::atomic<int>> visits(10007);
+    for (auto& visit : visits) {
+      visit = 0;
+    }
+    pool.ParallelFor(0, visits.size(), [&visits](const int64_t begin,
+                                                 const int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        ++visits[i];
+      }
+    });
+    int wrong = 0;
+    for (const auto& visit : visits) {
+      wrong += visit != 1;
+    }
+    EXPECT_EQ(0, wrong);
+  }
+}
+
+SIMPLE_TEST(ThreadPool, MinGrainAndEmptyRange) {
+  ThreadPool pool(2);
+  std::atomic<int> calls(0);
+  pool.ParallelFor(5, 5, [&calls](int64_t, int64_t) { ++calls; });
+  EXPECT_EQ(0, calls.load());
+
+  std::atomic<int> small_chunks(0);
+  pool.ParallelFor(
+      0, 1000,
+      [&small_chunks](const int64_t begin, const int64_t end) {
+        small_chunks += end - begin < 100;
+      },
+      100);
+  EXPECT_EQ(0, small_chunks.load());
+}
+
+SIMPLE_TEST(ThreadPool, NestedLoopsRunSequentially) {
+  ThreadPool pool(2);
+  std::atomic<int64_t> sum(0);
+  pool.ParallelFor(0, 10, [&pool, &sum](const int64_t begin,
+                                        const int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      pool.ParallelFor(0, 10, [&sum](const int64_t b, const int64_t e) {
+        sum += e - b;
+      });
+    }
+  });
+  EXPECT_EQ(100, sum.load());
+}
+
+SIMPLE_TEST(ThreadPool, DeterministicReduce) {
+  ThreadPool pool(3);
+  // Floating point addition is not associative, chunk values still have to
+  // be combined in index order.
+  const auto sum = [](const int64_t begin, const int64_t end) {
+    double value = 0.;
+    for (int64_t i = begin; i < end; ++i) {
+      value += 1. / (i + 1);
+    }
+    return value;
+  };
+  const double first = pool.ParallelReduce(
+      0, 100000, 0., sum, [](double a, double b) { return a + b; });
+  for (int run = 0; run < 10; ++run) {
+    EXPECT_EQ(first, pool.ParallelReduce(0, 100000, 0., sum,
+                                         [](double a, double b) {
+                                           return a + b;
+                                         }));
+  }
+
+  const std::string joined = pool.ParallelReduce(
+      0, 1000, std::string(),
+      [](const int64_t begin, const int64_t end) {
+        std::string chunk;
+        for (int64_t i = begin; i < end; ++i) {
+          chunk += static_cast<char>('a' + i % 26);
+        }
+        return chunk;
+      },
+      [](std::string a, std::string b) { return a + b; });
+  std::string expected;
+  for (int i = 0; i < 1000; ++i) {
+    expected += static_cast<char>('a' + i % 26);
+  }
+  EXPECT_EQ(expected, joined);
+}
+
+SIMPLE_TEST(ThreadPool, OrderedOutput) {
+  ThreadPool pool(3);
+  int fds[2];
+  EXPECT_EQ(0, pipe(fds));
+  {
+    OutputBuffer out(fds[1]);
+    pool.ParallelForOrdered(
+        0, 2000,
+        [](const int64_t i, std::string* const output) {
+          *output += std::to_string(i) + "\n";
+        },
+        &out);
+  }
+  close(fds[1]);
+  std::string result;
+  char chunk[4096];
+  ssize_t size;
+  while ((size = read(fds[0], chunk, sizeof(chunk))) > 0) {
+    result.append(chunk, size);
+  }
+  close(fds[0]);
+
+  std::string expected;
+  for (int i = 0; i < 2000; ++i) {
+    expected += std::to_string(i) + "\n";
+  }
+  EXPECT_EQ(expected, result);
+}
+
+}  // namespace runtime
+}  // namespace elsh
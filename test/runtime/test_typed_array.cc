@@ -0,0 +1,186 @@
+// MIT License
+
+// Copyright (c) 2020 Edward Liu
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "runtime/array_kernels.h"
+#include "runtime/typed_array.h"
+#include "test/utest_framework/simple_unit_test.h"
+
+namespace elsh {
+namespace runtime {
+namespace {
+
+const KernelSet kKernelSets[] = {KernelSet::kScalar, KernelSet::kSse2,
+                                 KernelSet::kAvx2};
+// Around and beyond every vector width, to cover the scalar tails.
+const size_t kSizes[] = {1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 1000};
+
+std::vector<int32_t> RandomInts(const size_t size, std::mt19937* const rng) {
+  std::uniform_int_distribution<int32_t> dist(
+      std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max());
+  std::vector<int32_t> values(size);
+  for (auto& value : values) {
+    value = dist(*rng);
+  }
+  return values;
+}
+
+// Small integers, so that every summation order gives the exact same double.
+std::vector<double> RandomDoubles(const size_t size, std::mt19937* const rng) {
+  std::uniform_int_distribution<int> dist(-1000, 1000);
+  std::vector<double> values(size);
+  for (auto& value : values) {
+    value = dist(*rng);
+  }
+  return values;
+}
+
+}  // namespace
+
+SIMPLE_TEST(TypedArray, BoundsChecks) {
+  TypedArray<int32_t> array(4, 7);
+  int32_t value = 0;
+  EXPECT(array.Get(3, &value));
+  EXPECT_EQ(7, value);
+  EXPECT(!array.Get(4, &value));
+  EXPECT(!array.Get(-1, &value));
+  EXPECT(array.Set(0, 1));
+  EXPECT(!array.Set(4, 1));
+  EXPECT(!array.Get(std::numeric_limits<int64_t>::max(), &value));
+  EXPECT(!array.Set(std::numeric_limits<int64_t>::max(), 1));
+  EXPECT(!array.Get(std::numeric_limits<int64_t>::min(), &value));
+  EXPECT(array.InBounds(0, 4));
+  EXPECT(array.InBounds(4, 4));
+  EXPECT(!array.InBounds(1, 5));
+  EXPECT(!array.InBounds(-1, 2));
+  EXPECT(!array.InBounds(3, 2));
+}
+
+SIMPLE_TEST(TypedArray, BulkOperations) {
+  TypedArray<int32_t> a(5);
+  Fill(&a, 3);
+  EXPECT_EQ(15, Sum(a));
+  a.Set(2, -4);
+  int32_t min = 0;
+  int32_t max = 0;
+  EXPECT(Min(a, &min));
+  EXPECT(Max(a, &max));
+  EXPECT_EQ(-4, min);
+  EXPECT_EQ(3, max);
+
+  TypedArray<int32_t> sum;
+  EXPECT(Add(a, a, &sum));
+  EXPECT_EQ(5, sum.size());
+  EXPECT_EQ(-8, sum[2]);
+  int64_t dot = 0;
+  EXPECT(Dot(a, a, &dot));
+  EXPECT_EQ(4 * 9 + 16, dot);
+
+  TypedArray<int32_t> other(3);
+  EXPECT(!Add(a, other, &sum));
+  EXPECT(!Dot(a, other, &dot));
+  TypedArray<double> empty;
+  double value = 0.;
+  EXPECT(!Min(empty, &value));
+  EXPECT_EQ(0., Sum(empty));
+}
+
+SIMPLE_TEST(TypedArray, KernelsMatchScalar) {
+  std::mt19937 rng(42);
+  const ArrayKernels& scalar = GetArrayKernels(KernelSet::kScalar);
+  for (const KernelSet kernel_set : kKernelSets) {
+    if (!IsSupported(kernel_set)) {
+      continue;
+    }
+    const ArrayKernels& kernels = GetArrayKernels(kernel_set);
+    for (const size_t size : kSizes) {
+      const auto a = RandomInts(size, &rng);
+      const auto b = RandomInts(size, &rng);
+      EXPECT_EQ(scalar.sum_int32(a.data(), size),
+                kernels.sum_int32(a.data(), size));
+      EXPECT_EQ(scalar.min_int32(a.data(), size),
+                kernels.min_int32(a.data(), size));
+      EXPECT_EQ(scalar.max_int32(a.data(), size),
+                kernels.max_int32(a.data(), size));
+      EXPECT_EQ(scalar.dot_int32(a.data(), b.data(), size),
+                kernels.dot_int32(a.data(), b.data(), size));
+      std::vector<int32_t> expected(size);
+      std::vector<int32_t> actual(size);
+      scalar.add_int32(a.data(), b.data(), expected.data(), size);
+      kernels.add_int32(a.data(), b.data(), actual.data(), size);
+      EXPECT(expected == actual);
+      scalar.mul_int32(a.data(), b.data(), expected.data(), size);
+      kernels.mul_int32(a.data(), b.data(), actual.data(), size);
+      EXPECT(expected == actual);
+      kernels.fill_int32(actual.data(), size, -5);
+      EXPECT(std::vector<int32_t>(size, -5) == actual);
+
+      const auto x = RandomDoubles(size, &rng);
+      const auto y = RandomDoubles(size, &rng);
+      EXPECT_EQ(scalar.sum_double(x.data(), size),
+                kernels.sum_double(x.data(), size));
+      EXPECT_EQ(scalar.min_double(x.data(), size),
+                kernels.min_double(x.data(), size));
+      EXPECT_EQ(scalar.max_double(x.data(), size),
+                kernels.max_double(x.data(), size));
+      EXPECT_EQ(scalar.dot_double(x.data(), y.data(), size),
+                kernels.dot_double(x.data(), y.data(), size));
+      std::vector<double> expected_doubles(size);
+      std::vector<double> actual_doubles(size);
+      scalar.add_double(x.data(), y.data(), expected_doubles.data(), size);
+      kernels.add_double(x.data(), y.data(), actual_doubles.data(), size);
+      EXPECT(expected_doubles == actual_doubles);
+      scalar.mul_double(x.data(), y.data(), expected_doubles.data(), size);
+      kernels.mul_double(x.data(), y.data(), actual_doubles.data(), size);
+      EXPECT(expected_doubles == actual_doubles);
+      kernels.fill_double(actual_doubles.data(), size, 0.5);
+      EXPECT(std::vector<double>(size, 0.5) == actual_doubles);
+    }
+  }
+}
+
+SIMPLE_TEST(TypedArray, NanMinMax) {
+  std::mt19937 rng(42);
+  for (const KernelSet kernel_set : kKernelSets) {
+    if (!IsSupported(kernel_set)) {
+      continue;
+    }
+    const ArrayKernels& kernels = GetArrayKernels(kernel_set);
+    for (const size_t size : kSizes) {
+      // First, middle and last element, in the vector body and the tail.
+      for (const size_t nan_index : {size_t{0}, size / 2, size - 1}) {
+        auto x = RandomDoubles(size, &rng);
+        x[nan_index] = std::numeric_limits<double>::quiet_NaN();
+        EXPECT(std::isnan(kernels.min_double(x.data(), size)));
+        EXPECT(std::isnan(kernels.max_double(x.data(), size)));
+      }
+    }
+  }
+}
+
+}  // namespace runtime
+}  // namespace elsh
@@ -22,8 +22,19 @@
 
 #include "test/utest_framework/simple_unit_test.h"
 
+#include <fnmatch.h>
+
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 namespace elsh {
 namespace test {
@@ -31,8 +42,84 @@ namespace utest_framework {
 namespace {
 constexpr int kMaxOutputLength = 40;
 constexpr int kMinDotNum = 4;
+// Calibrated batches run at least this long.
+constexpr int64_t kBenchMinBatchNs = 5000000;
+
+std::mutex g_output_mutex;
+
+bool MatchesFilter(const std::string& filter, const std::string& name) {
+  if (filter.empty()) {
+    return true;
+  }
+  std::istringstream ss(filter);
+  std::string glob;
+  while (std::getline(ss, glob, ':')) {
+    if (fnmatch(glob.c_str(), name.c_str(), 0) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string Escape(const std::string& text, const bool xml) {
+  std::string escaped;
+  for (const char c : text) {
+    if (xml && c == '<') {
+      escaped += "&lt;";
+    } else if (xml && c == '>') {
+      escaped += "&gt;";
+    } else if (xml && c == '&') {
+      escaped += "&amp;";
+    } else if (xml && c == '"') {
+      escaped += "&quot;";
+    } else if (!xml && (c == '"' || c == '\\')) {
+      escaped += '\\';
+      escaped += c;
+    } else if (!xml && c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+std::string Dots(const std::string& name) {
+  return std::string(
+      std::max(kMaxOutputLength - static_cast<int>(name.size()), kMinDotNum),
+      '.');
+}
+
+int64_t TimeBatch(BenchBase* const bench, const int64_t iterations) {
+  BenchState state(iterations);
+  const auto start = std::chrono::steady_clock::now();
+  bench->BenchFunc(&state);
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// Baseline files hold one `name ns_per_op` pair per line.
+std::unordered_map<std::string, double> ReadBaseline(const std::string& path) {
+  std::unordered_map<std::string, double> baseline;
+  std::ifstream is(path);
+  std::string name;
+  double ns_per_op;
+  while (is >> name >> ns_per_op) {
+    baseline[name] = ns_per_op;
+  }
+  return baseline;
+}
+
+std::string Seconds(const uint64_t ns) {
+  std::ostringstream ss;
+  ss << std::fixed << std::setprecision(6) << ns / 1e9;
+  return ss.str();
+}
 }  // namespace
 
+constexpr int TestFactory::kBenchSamples;
+
 TestFactory* TestFactory::Instance() {
   static TestFactory instance;
   return &instance;
@@ -42,21 +129,133 @@ void TestFactory::Append(std::shared_ptr<TestBase> test_case) {
   tests_.push_back(test_case);
 }
 
-void TestFactory::Run() {
-  for (auto test_case : tests_) {
-    std::string str = "[Test Case] " + test_case->name_ + " ";
-    int dot_num =
-        std::max(kMaxOutputLength - static_cast<int>(test_case->name_.size()),
-                 kMinDotNum);
-    for (int i = 0; i < dot_num; ++i) {
-      str += ".";
+void TestFactory::Append(std::shared_ptr<BenchBase> bench) {
+  benches_.push_back(bench);
+}
+
+int TestFactory::Run(const Options& options) {
+  std::vector<TestBase*> selected;
+  std::vector<TestBase*> serial;
+  for (const auto& test_case : tests_) {
+    test_case->ran_ = false;
+    test_case->test_infos_.clear();
+    if (MatchesFilter(options.filter, test_case->name_)) {
+      (test_case->serial_ ? serial : selected).push_back(test_case.get());
     }
+  }
+
+  slow_ms_ = options.slow_ms;
+  const auto start = std::chrono::steady_clock::now();
+  std::atomic<size_t> next(0);
+  const auto worker = [this, &selected, &next, &options]() {
+    for (size_t i = next++; i < selected.size(); i = next++) {
+      RunOne(selected[i], options);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 1; i < options.jobs; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto* const test_case : serial) {
+    RunOne(test_case, options);
+  }
+  selected.insert(selected.end(), serial.begin(), serial.end());
+  wall_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now() - start)
+                 .count();
 
-    test_case->TestFunc();
-    str += test_case->test_infos_.empty() ? "\e[1;32m passed \e[0m"
-                                          : "\e[1;31m failed \e[0m";
-    std::cout << str << std::endl;
+  int failed = 0;
+  for (const auto* test_case : selected) {
+    failed += test_case->test_infos_.empty() ? 0 : 1;
   }
+  return failed;
+}
+
+void TestFactory::RunOne(TestBase* const test_case, const Options& options) {
+  const auto start = std::chrono::steady_clock::now();
+  test_case->TestFunc();
+  test_case->wall_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+  test_case->ran_ = true;
+
+  std::string str = "[Test Case] " + test_case->name_ + " " +
+                    Dots(test_case->name_);
+  str += test_case->test_infos_.empty() ? "\e[1;32m passed \e[0m"
+                                        : "\e[1;31m failed \e[0m";
+  const double ms = test_case->wall_ns_ / 1e6;
+  std::ostringstream time;
+  time << std::fixed << std::setprecision(1) << ms << " ms";
+  str += time.str();
+  if (ms > options.slow_ms) {
+    str += " \e[1;33m(slow)\e[0m";
+  }
+  std::lock_guard<std::mutex> lock(g_output_mutex);
+  std::cout << str << std::endl;
+}
+
+int TestFactory::RunBenches(const Options& options) {
+  const auto baseline = options.baseline_path.empty()
+                            ? std::unordered_map<std::string, double>()
+                            : ReadBaseline(options.baseline_path);
+  int regressions = 0;
+  std::ofstream save;
+  if (!options.save_baseline_path.empty()) {
+    save.open(options.save_baseline_path);
+  }
+  for (const auto& bench : benches_) {
+    if (!MatchesFilter(options.filter, bench->name_)) {
+      continue;
+    }
+    RunBench(bench.get(), options, baseline);
+    regressions += bench->regressed_ ? 1 : 0;
+    if (save.is_open()) {
+      save << bench->name_ << " " << std::setprecision(6) << bench->median_ns_
+           << "\n";
+    }
+  }
+  return regressions;
+}
+
+void TestFactory::RunBench(
+    BenchBase* const bench, const Options& options,
+    const std::unordered_map<std::string, double>& baseline) {
+  // Double the batch until it is long enough for the clock, the last
+  // calibration batch doubles as warmup.
+  int64_t iterations = 1;
+  while (TimeBatch(bench, iterations) < kBenchMinBatchNs &&
+         iterations < (int64_t{1} << 40)) {
+    iterations *= 2;
+  }
+  std::vector<double> ns_per_op;
+  for (int i = 0; i < kBenchSamples; ++i) {
+    ns_per_op.push_back(static_cast<double>(TimeBatch(bench, iterations)) /
+                        iterations);
+  }
+  std::sort(ns_per_op.begin(), ns_per_op.end());
+  const auto percentile = [&ns_per_op](const int pct) {
+    return ns_per_op[(ns_per_op.size() - 1) * pct / 100];
+  };
+  bench->median_ns_ = percentile(50);
+
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(2) << "[Bench] " << bench->name_
+       << " " << Dots(bench->name_) << " " << bench->median_ns_
+       << " ns/op (p10 " << percentile(10) << ", p90 " << percentile(90)
+       << ", " << iterations << " x " << kBenchSamples << ")";
+  const auto it = baseline.find(bench->name_);
+  if (it != baseline.end() && it->second > 0.) {
+    const double change_pct = (bench->median_ns_ / it->second - 1.) * 100.;
+    bench->regressed_ = change_pct > options.regression_pct;
+    line << std::showpos << std::setprecision(1) << " " << change_pct << "%"
+         << std::noshowpos
+         << (bench->regressed_ ? " \e[1;31mregressed\e[0m" : "");
+  }
+  std::cout << line.str() << std::endl;
 }
 
 void TestFactory::Dump() {
@@ -73,12 +272,128 @@ void TestFactory::Dump() {
   }
 }
 
+bool TestFactory::WriteJUnit(const std::string& path) const {
+  int tests = 0;
+  int failures = 0;
+  for (const auto& test_case : tests_) {
+    tests += test_case->ran_ ? 1 : 0;
+    failures += test_case->test_infos_.empty() ? 0 : 1;
+  }
+  std::ofstream os(path);
+  os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+     << "<testsuite name=\"elsh\" tests=\"" << tests << "\" failures=\""
+     << failures << "\" time=\"" << Seconds(wall_ns_) << "\">\n";
+  for (const auto& test_case : tests_) {
+    if (!test_case->ran_) {
+      continue;
+    }
+    const std::string& name = test_case->name_;
+    const size_t dot = name.find('.');
+    os << "  <testcase classname=\"" << Escape(name.substr(0, dot), true)
+       << "\" name=\"" << Escape(name.substr(dot + 1), true) << "\" time=\""
+       << Seconds(test_case->wall_ns_) << "\"";
+    if (test_case->test_infos_.empty()) {
+      os << "/>\n";
+      continue;
+    }
+    os << ">\n";
+    for (const auto& test_info : test_case->test_infos_) {
+      os << "    <failure message=\""
+         << Escape(test_info.file + ":" + std::to_string(test_info.line_num) +
+                       ": " + test_info.condition + " check failed.",
+                   true)
+         << "\"/>\n";
+    }
+    os << "  </testcase>\n";
+  }
+  os << "</testsuite>\n";
+  return static_cast<bool>(os);
+}
+
+bool TestFactory::WriteJson(const std::string& path) const {
+  int tests = 0;
+  int failures = 0;
+  for (const auto& test_case : tests_) {
+    tests += test_case->ran_ ? 1 : 0;
+    failures += test_case->test_infos_.empty() ? 0 : 1;
+  }
+  std::ofstream os(path);
+  os << "{\"tests\": " << tests << ", \"failures\": " << failures
+     << ", \"seconds\": " << Seconds(wall_ns_) << ", \"cases\": [";
+  bool first = true;
+  for (const auto& test_case : tests_) {
+    if (!test_case->ran_) {
+      continue;
+    }
+    os << (first ? "" : ", ") << "{\"name\": \""
+       << Escape(test_case->name_, false) << "\", \"passed\": "
+       << (test_case->test_infos_.empty() ? "true" : "false")
+       << ", \"slow\": "
+       << (test_case->wall_ns_ / 1e6 > slow_ms_ ? "true" : "false")
+       << ", \"seconds\": " << Seconds(test_case->wall_ns_) << "}";
+    first = false;
+  }
+  os << "]}\n";
+  return static_cast<bool>(os);
+}
+
 }  // namespace utest_framework
 }  // namespace test
 }  // namespace elsh
 
-int main(int, char**) {
-  elsh::test::utest_framework::TestFactory::Instance()->Run();
-  elsh::test::utest_framework::TestFactory::Instance()->Dump();
-  return 0;
+namespace {
+void PrintUsage(const char* const program) {
+  std::cerr << "usage: " << program
+            << " [--jobs N] [--filter GLOB[:GLOB...]] [--slow-ms MS]"
+               " [--junit PATH] [--json PATH]\n"
+            << "       " << program
+            << " --bench [--filter GLOB[:GLOB...]] [--baseline PATH]"
+               " [--save-baseline PATH] [--regression PCT]\n";
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  using elsh::test::utest_framework::TestFactory;
+  TestFactory::Options options;
+  for (int i = 1; i < argc; ++i) {
+    const bool has_value = i + 1 < argc;
+    if (std::strcmp(argv[i], "--jobs") == 0 && has_value) {
+      options.jobs = std::max(std::atoi(argv[++i]), 1);
+    } else if (std::strcmp(argv[i], "--filter") == 0 && has_value) {
+      options.filter = argv[++i];
+    } else if (std::strcmp(argv[i], "--slow-ms") == 0 && has_value) {
+      options.slow_ms = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--junit") == 0 && has_value) {
+      options.junit_path = argv[++i];
+    } else if (std::strcmp(argv[i], "--json") == 0 && has_value) {
+      options.json_path = argv[++i];
+    } else if (std::strcmp(argv[i], "--bench") == 0) {
+      options.bench = true;
+    } else if (std::strcmp(argv[i], "--baseline") == 0 && has_value) {
+      options.baseline_path = argv[++i];
+    } else if (std::strcmp(argv[i], "--save-baseline") == 0 && has_value) {
+      options.save_baseline_path = argv[++i];
+    } else if (std::strcmp(argv[i], "--regression") == 0 && has_value) {
+      options.regression_pct = std::atof(argv[++i]);
+    } else {
+      PrintUsage(argv[0]);
+      return 2;
+    }
+  }
+
+  TestFactory* const factory = TestFactory::Instance();
+  if (options.bench) {
+    return factory->RunBenches(options) == 0 ? 0 : 1;
+  }
+  const int failed = factory->Run(options);
+  factory->Dump();
+  if (!options.junit_path.empty() && !factory->WriteJUnit(options.junit_path)) {
+    std::cerr << "can not write " << options.junit_path << "\n";
+    return 2;
+  }
+  if (!options.json_path.empty() && !factory->WriteJson(options.json_path)) {
+    std::cerr << "can not write " << options.json_path << "\n";
+    return 2;
+  }
+  return failed == 0 ? 0 : 1;
 }
@@ -35,7 +35,36 @@
 ///    EXPECT_TRUE(fs.is_open());
 ///  }
 ///  }
+///
+/// Every test binary accepts:
+///
+///  --jobs N          run tests on N threads
+///  --filter GLOB     only run `package.case` names matching one of the
+///                    colon separated globs
+///  --slow-ms MS      flag tests slower than MS milliseconds (default 1000)
+///  --junit PATH      write JUnit style xml
+///  --json PATH       write a json summary
+///
+/// and exits with 1 if any test failed. Tests declared with
+/// `SIMPLE_TEST_SERIAL` run one at a time after all others, for checks of
+/// process wide state such as allocation counts.
+///
+/// Microbenchmarks live next to the tests and only run with `--bench`:
+///
+///  SIMPLE_BENCH(Lex, GetToken) {
+///    while (state->KeepRunning()) {
+///      DoNotOptimize(loader.GetToken());
+///    }
+///  }
+///
+/// The iteration count is calibrated until a batch takes a few milliseconds,
+/// then a warmup batch and `kBenchSamples` timed batches run. The report
+/// gives the median and the spread in ns/op. `--save-baseline PATH` stores
+/// the medians, `--baseline PATH` compares against stored ones and fails on
+/// slowdowns beyond `--regression PCT` (default 10).
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -87,21 +116,113 @@ class TestBase {
  protected:
   std::vector<TestInfo> test_infos_;
   std::string name_;
+  bool serial_ = false;
+
+ private:
+  bool ran_ = false;
+  uint64_t wall_ns_ = 0;
+};
+
+/// @brief Iteration budget of one timed batch.
+class BenchState {
+ public:
+  explicit BenchState(const int64_t iterations) : remaining_(iterations) {}
+
+  bool KeepRunning() { return remaining_-- > 0; }
+
+ private:
+  int64_t remaining_;
+};
+
+class BenchBase {
+  friend class TestFactory;
+
+ public:
+  BenchBase() = default;
+  virtual ~BenchBase() {}
+
+  /// @brief Implemented by each benchmark, runs its body while
+  /// `state->KeepRunning()`.
+  virtual void BenchFunc(BenchState* const state) = 0;
+
+  /// @brief Make the compiler assume `value` is read, so computing it can not
+  /// be optimized away.
+  template <typename T>
+  static void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+  }
+
+  /// @brief Make the compiler assume all memory is read and written here.
+  static void ClobberMemory() {
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+  }
+
+ protected:
+  std::string name_;
+
+ private:
+  double median_ns_ = 0.;
+  bool regressed_ = false;
+};
+
+class SerialTestBase : public TestBase {
+ public:
+  SerialTestBase() { serial_ = true; }
 };
 
 class TestFactory {
  public:
+  struct Options {
+    int jobs = 1;
+    /// @brief Colon separated globs, empty runs everything.
+    std::string filter;
+    double slow_ms = 1000.;
+    std::string junit_path;
+    std::string json_path;
+    /// @brief Run the benchmarks selected by `filter` instead of the tests.
+    bool bench = false;
+    std::string baseline_path;
+    std::string save_baseline_path;
+    double regression_pct = 10.;
+  };
+
+  static constexpr int kBenchSamples = 21;
+
   /// Singleton
   static TestFactory* Instance();
   /// @brief Add a new test case.
   void Append(std::shared_ptr<TestBase> test_case);
+  void Append(std::shared_ptr<BenchBase> bench);
   /// @brief Run all test cases.
-  void Run();
+  void Run() { Run(Options()); }
+  /// @brief Run the test cases selected by `options.filter` on
+  /// `options.jobs` threads, then the selected serial ones on this thread,
+  /// and return the number of failed ones.
+  int Run(const Options& options);
+  /// @brief Run the benchmarks selected by `options.filter` one at a time and
+  /// return the number of regressions against `options.baseline_path`.
+  int RunBenches(const Options& options);
   /// @brief Dump all test informations.
   void Dump();
+  /// @brief Results of the last `Run` as JUnit xml and as json.
+  bool WriteJUnit(const std::string& path) const;
+  bool WriteJson(const std::string& path) const;
+
+ private:
+  void RunOne(TestBase* const test_case, const Options& options);
+  void RunBench(BenchBase* const bench, const Options& options,
+                const std::unordered_map<std::string, double>& baseline);
 
  private:
   std::vector<std::shared_ptr<TestBase>> tests_;
+  std::vector<std::shared_ptr<BenchBase>> benches_;
+  uint64_t wall_ns_ = 0;
+  double slow_ms_ = 0.;
 };
 
 namespace internal {
@@ -110,6 +231,11 @@ inline int RegisterNewTestCase(std::shared_ptr<TestBase> test_case) {
   return 0;
 }
 
+inline int RegisterNewBench(std::shared_ptr<BenchBase> bench) {
+  TestFactory::Instance()->Append(bench);
+  return 0;
+}
+
 template <typename T1, typename T2>
 constexpr bool StaticAssertTypeEq() noexcept {
   static_assert(std::is_same<T1, T2>::value, "T1 and T2 are not the same type");
@@ -150,6 +276,34 @@ constexpr bool StaticAssertTypeEq() noexcept {
                ::elsh::test::utest_framework::TestBase, \
                ::elsh::test::utest_framework::TestFactory)
 
+#define SIMPLE_TEST_SERIAL(package_name, test_case_name)    \
+  SIMPLE_TEST_(package_name, test_case_name,                  \
+               ::elsh::test::utest_framework::SerialTestBase, \
+               ::elsh::test::utest_framework::TestFactory)
+
+#define BENCH_CLASS_NAME(package_name, bench_name) \
+  SimpleBench##package_name##bench_name
+
+#define SIMPLE_BENCH(package_name, bench_name)                               \
+  class BENCH_CLASS_NAME(package_name, bench_name)                           \
+      : public ::elsh::test::utest_framework::BenchBase {                    \
+   public:                                                                   \
+    BENCH_CLASS_NAME(package_name, bench_name)() {                           \
+      this->name_ = std::string(#package_name) + "." + #bench_name;          \
+    }                                                                        \
+    void BenchFunc(::elsh::test::utest_framework::BenchState* const state)   \
+        override;                                                            \
+                                                                             \
+   private:                                                                  \
+    static int const nothing_important_ TEST_ATTRIBUTE_UNUSED_;              \
+  };                                                                         \
+                                                                             \
+  int const BENCH_CLASS_NAME(package_name, bench_name)::nothing_important_ = \
+      ::elsh::test::utest_framework::internal::RegisterNewBench(             \
+          std::make_shared<BENCH_CLASS_NAME(package_name, bench_name)>());   \
+  void BENCH_CLASS_NAME(package_name, bench_name)::BenchFunc(                \
+      ::elsh::test::utest_framework::BenchState* const state)
+
 #define EXPECT_OP(val1, val2, operator)                                 \
   {                                                                     \
     if (!((val1) operator(val2)))                                       \